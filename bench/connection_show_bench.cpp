@@ -0,0 +1,180 @@
+#include <benchmark/benchmark.h>
+
+#include <netlink/msg.h>
+#include <netlink/route/link.h>
+#include <linux/if.h>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "dbus_trace.h"
+#include "mem_counters.h"
+#include "mem_stats.h"
+#include "network_manager.h"
+#include "trace.h"
+
+namespace {
+
+// 每个合成响应的耗时，接近本机系统总线上一次 D-Bus 往返
+constexpr auto ROUND_TRIP = std::chrono::microseconds(150);
+
+class SyntheticTrace {
+  public:
+    SyntheticTrace() : data_("NMTRACE1") {}
+
+    template <typename... Args>
+    void dbus(
+        const std::string &path, const std::string &interface, const std::string &method, const std::string &payload,
+        const Args &...args
+    ) {
+        add(Trace::Kind::DBus, method, dbusTraceKey(path, interface, method, args...), payload);
+    }
+
+    void property(
+        const std::string &path, const std::string &interface, const std::string &name, const sdbus::Variant &value
+    ) {
+        dbus(path, "org.freedesktop.DBus.Properties", "Get", dbusTraceReply(value), interface, name);
+    }
+
+    void netlink(const std::string &operation, const std::string &key, const std::vector<std::string> &messages) {
+        std::string payload;
+        TraceEncoder encoder(payload);
+        encoder.u32(0);
+        encoder.u32(static_cast<uint32_t>(messages.size()));
+        for (const auto &message : messages) {
+            encoder.bytes(message);
+        }
+        add(Trace::Kind::Netlink, operation, key, payload);
+    }
+
+    void save(const std::string &path) const {
+        std::ofstream(path, std::ios::binary).write(data_.data(), static_cast<std::streamsize>(data_.size()));
+    }
+
+  private:
+    void add(Trace::Kind kind, const std::string &operation, const std::string &key, const std::string &payload) {
+        TraceEncoder encoder(data_);
+        encoder.u8(static_cast<uint8_t>(kind));
+        encoder.bytes(operation);
+        encoder.bytes(key);
+        encoder.u64(0);
+        encoder.u64(static_cast<uint64_t>(std::chrono::nanoseconds(ROUND_TRIP).count()));
+        encoder.bytes(payload);
+    }
+
+    std::string data_;
+};
+
+// RTM_NEWLINK 消息，与内核对 RTM_GETLINK dump 的响应格式相同
+std::string linkMessage(int ifindex, const char *name, uint8_t operstate) {
+    struct rtnl_link *link = rtnl_link_alloc();
+    rtnl_link_set_ifindex(link, ifindex);
+    rtnl_link_set_name(link, name);
+    rtnl_link_set_operstate(link, operstate);
+
+    struct nl_msg *msg = nullptr;
+    rtnl_link_build_add_request(link, NLM_F_MULTI, &msg);
+    struct nlmsghdr *nlh = nlmsg_hdr(msg);
+    std::string raw(reinterpret_cast<const char *>(nlh), nlh->nlmsg_len);
+    nlmsg_free(msg);
+    rtnl_link_put(link);
+    return raw;
+}
+
+std::string hex(const std::string &text) {
+    static const char digits[] = "0123456789abcdef";
+    std::string out;
+    for (unsigned char c : text) {
+        out += digits[c >> 4];
+        out += digits[c & 0xf];
+    }
+    return out;
+}
+
+// iwd 的对象布局：适配器 0、设备 0/4，已连接到第一个已知网络，另有 known - 1 个已保存的网络
+std::string writeTrace(int known) {
+    SyntheticTrace trace;
+
+    trace.netlink(
+        "RTM_GETLINK", "route/link",
+        {linkMessage(1, "lo", IF_OPER_UNKNOWN), linkMessage(2, "eth0", IF_OPER_DOWN),
+         linkMessage(3, "wlan0", IF_OPER_UP)}
+    );
+
+    std::string root = "<node><node name=\"0\"/>";
+    for (int i = 0; i < known; ++i) {
+        root += "<node name=\"" + hex("bench-network-" + std::to_string(i)) + "_psk\"/>";
+    }
+    root += "</node>";
+    trace.dbus("/net/connman/iwd", "org.freedesktop.DBus.Introspectable", "Introspect", dbusTraceReply(root));
+    trace.dbus(
+        "/net/connman/iwd/0", "org.freedesktop.DBus.Introspectable", "Introspect",
+        dbusTraceReply(std::string("<node><node name=\"4\"/></node>"))
+    );
+
+    const std::string connected = "/net/connman/iwd/0/4/" + hex("bench-network-0") + "_psk";
+    trace.property(
+        "/net/connman/iwd/0/4", "net.connman.iwd.Station", "ConnectedNetwork",
+        sdbus::Variant(sdbus::ObjectPath{connected})
+    );
+    trace.property(connected, "net.connman.iwd.Network", "Name", sdbus::Variant(std::string("bench-network-0")));
+
+    for (int i = 0; i < known; ++i) {
+        const std::string name = "bench-network-" + std::to_string(i);
+        trace.property(
+            "/net/connman/iwd/" + hex(name) + "_psk", "net.connman.iwd.KnownNetwork", "Name", sdbus::Variant(name)
+        );
+    }
+
+    const std::string path = "/tmp/nmcli-alt-connection-bench-" + std::to_string(known) + ".trace";
+    trace.save(path);
+    return path;
+}
+
+// 按录制耗时回放合成的 iwd 和 rtnetlink 响应，测量的是往返次数决定的延迟
+void runConnectionShow(benchmark::State &state, bool active_only) {
+    const int known = static_cast<int>(state.range(0));
+
+    std::string path;
+    try {
+        // 回放不连接系统总线，没有 D-Bus 的 CI 上也能运行
+        path = writeTrace(known);
+        Trace::global().loadReplay(path, true);
+    } catch (const std::exception &e) {
+        state.SkipWithError(e.what());
+        return;
+    }
+
+    NetworkManager nm;
+    std::ofstream sink("/dev/null");
+    std::streambuf *stdout_buf = std::cout.rdbuf(sink.rdbuf());
+
+    // 与 --mem-stats 相同的计数，分配次数和字节数的回归会直接体现在计数器上
+    MemCounters memory(state);
+    for (auto _ : state) {
+        MemPhase phase("command", "connection show");
+        nm.showConnections(active_only);
+    }
+    memory.report();
+    std::cout.rdbuf(stdout_buf);
+
+    state.counters["known_networks"] = known;
+    std::remove(path.c_str());
+}
+
+} // namespace
+
+// 完整列表：每个已知网络一次 Name 读取，延迟随已知网络数量线性增长
+static void BM_ConnectionShow(benchmark::State &state) {
+    runConnectionShow(state, false);
+}
+BENCHMARK(BM_ConnectionShow)->Arg(0)->Arg(50)->Arg(500)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// --active：只读取 up 的设备和 ConnectedNetwork，延迟与已知网络数量无关
+static void BM_ConnectionShowActive(benchmark::State &state) {
+    runConnectionShow(state, true);
+}
+BENCHMARK(BM_ConnectionShowActive)->Arg(0)->Arg(50)->Arg(500)->Unit(benchmark::kMillisecond)->UseRealTime();
@@ -0,0 +1,37 @@
+#ifndef BENCH_MEM_COUNTERS_H
+#define BENCH_MEM_COUNTERS_H
+
+#include <benchmark/benchmark.h>
+
+#include "mem_stats.h"
+
+/**
+ * 基准测试的内存计数器，与 --mem-stats 使用相同的分配钩子
+ *
+ * 在计时循环之前构造，循环之后调用 report()，报告每次迭代的分配次数和字节数（含嵌套阶段），
+ * 以及整个循环期间相对开始时的峰值存活字节数。
+ */
+class MemCounters {
+  public:
+    explicit MemCounters(benchmark::State &state) : state_(state) {
+        MemStats::enable();
+        MemStats::resetPeak();
+        before_ = MemStats::totals();
+    }
+
+    void report() {
+        const MemStats::Totals after = MemStats::totals();
+        state_.counters["allocs_per_op"] = benchmark::Counter(
+            static_cast<double>(after.allocations - before_.allocations), benchmark::Counter::kAvgIterations
+        );
+        state_.counters["bytes_per_op"] =
+            benchmark::Counter(static_cast<double>(after.bytes - before_.bytes), benchmark::Counter::kAvgIterations);
+        state_.counters["peak_live_bytes"] = static_cast<double>(after.peak - before_.live);
+    }
+
+  private:
+    benchmark::State &state_;
+    MemStats::Totals before_{};
+};
+
+#endif // BENCH_MEM_COUNTERS_H
@@ -0,0 +1,99 @@
+#include <benchmark/benchmark.h>
+
+#include <dirent.h>
+#include <unistd.h>
+#include <cstdlib>
+#include <string>
+
+#include "network_import.h"
+
+namespace {
+
+// connection import 的 CSV 输入：count 个网络，安全类型轮换，带一个需要十六进制文件名的 SSID
+std::string makeCsv(size_t count) {
+    std::string csv = "ssid,security,passphrase,identity,eap\n";
+    for (size_t i = 0; i < count; ++i) {
+        const std::string ssid = (i % 10 == 0 ? "bench café " : "bench-network-") + std::to_string(i);
+        switch (i % 3) {
+        case 0:
+            csv += ssid + ",psk,passphrase-" + std::to_string(i) + ",,\n";
+            break;
+        case 1:
+            csv += ssid + ",open,,,\n";
+            break;
+        default:
+            csv += ssid + ",8021x,secret-" + std::to_string(i) + ",user" + std::to_string(i) + ",PEAP\n";
+            break;
+        }
+    }
+    return csv;
+}
+
+// 同样的网络写成 JSON
+std::string makeJson(size_t count) {
+    std::string json = "[";
+    for (size_t i = 0; i < count; ++i) {
+        json += i == 0 ? "\n" : ",\n";
+        json += "{\"ssid\": \"bench-network-" + std::to_string(i) + "\", \"security\": \"wpa-psk\", "
+                "\"passphrase\": \"passphrase-" + std::to_string(i) + "\"}";
+    }
+    return json + "\n]\n";
+}
+
+void removeTree(const std::string &dir) {
+    if (DIR *d = opendir(dir.c_str())) {
+        while (struct dirent *entry = readdir(d)) {
+            const std::string name = entry->d_name;
+            if (name != "." && name != "..") {
+                unlink((dir + "/" + name).c_str());
+            }
+        }
+        closedir(d);
+    }
+    rmdir(dir.c_str());
+}
+
+// 解析并写入临时存储目录，每次迭代覆盖上一次写入的配置（--replace），包含 syncfs 和目录同步
+void runImport(benchmark::State &state, const std::string &text) {
+    char dir_template[] = "/tmp/nmcli-alt-import-XXXXXX";
+    if (!mkdtemp(dir_template)) {
+        state.SkipWithError("Failed to create a temporary storage directory");
+        return;
+    }
+    const std::string dir = dir_template;
+
+    for (auto _ : state) {
+        const auto profiles = parseNetworkProfiles(text);
+        const ProfileWriteResult result = writeIwdProfiles(dir, profiles, true);
+        if (!result.errors.empty()) {
+            state.SkipWithError(result.errors.front().c_str());
+            break;
+        }
+        benchmark::DoNotOptimize(result.written);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    removeTree(dir);
+}
+
+} // namespace
+
+// 目标：1000 个网络远低于一秒
+static void BM_ImportCsv(benchmark::State &state) {
+    runImport(state, makeCsv(state.range(0)));
+}
+BENCHMARK(BM_ImportCsv)->Arg(100)->Arg(1000)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+static void BM_ImportJson(benchmark::State &state) {
+    runImport(state, makeJson(state.range(0)));
+}
+BENCHMARK(BM_ImportJson)->Arg(100)->Arg(1000)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// 只解析，不写文件
+static void BM_ParseNetworkProfiles(benchmark::State &state) {
+    const std::string csv = makeCsv(state.range(0));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(parseNetworkProfiles(csv));
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_ParseNetworkProfiles)->Arg(1000);
@@ -0,0 +1,145 @@
+#include <benchmark/benchmark.h>
+
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "iwd_introspection.h"
+#include "network_manager.h"
+#include "string_util.h"
+
+namespace {
+
+// 已知网络对象的节点名：SSID 的十六进制编码加安全类型
+std::string networkNode(size_t i) {
+    static const char *security[] = {"psk", "open", "8021x"};
+    static const char hex[] = "0123456789abcdef";
+    std::string ssid = "bench-network-" + std::to_string(i);
+    std::string node;
+    for (unsigned char c : ssid) {
+        node += hex[c >> 4];
+        node += hex[c & 0x0F];
+    }
+    return node + "_" + security[i % 3];
+}
+
+// /net/connman/iwd 的 Introspect 结果：count 个已知网络节点，适配器节点放在最后（最坏情况）
+std::string makeIntrospection(size_t count) {
+    std::string xml = "<!DOCTYPE node PUBLIC \"-//freedesktop//DTD D-BUS Object Introspection 1.0//EN\"\n"
+                      "\"http://www.freedesktop.org/standards/dbus/1.0/introspect.dtd\">\n<node>\n"
+                      "  <interface name=\"org.freedesktop.DBus.Introspectable\">\n"
+                      "    <method name=\"Introspect\"><arg name=\"xml\" type=\"s\" direction=\"out\"/></method>\n"
+                      "  </interface>\n";
+    for (size_t i = 0; i < count; ++i) {
+        xml += "  <node name=\"" + networkNode(i) + "\"/>\n";
+    }
+    xml += "  <node name=\"0\"/>\n</node>\n";
+    return xml;
+}
+
+// connection show 的一行：名称、UUID、类型、设备
+std::vector<std::vector<std::string>> makeTable(size_t rows) {
+    std::vector<std::vector<std::string>> table(rows);
+    for (size_t i = 0; i < rows; ++i) {
+        const std::string name = "bench-network-" + std::to_string(i);
+        table[i] = {name, stringToUUID(name), "wifi", i == 0 ? "wlan0" : "--"};
+    }
+    return table;
+}
+
+void runTable(benchmark::State &state, bool terse) {
+    const auto table = makeTable(state.range(0));
+    NetworkManager nm;
+    nm.terse_output = terse;
+
+    // 只测格式化本身，输出丢弃
+    std::ofstream sink("/dev/null");
+    std::streambuf *stdout_buf = std::cout.rdbuf(sink.rdbuf());
+    for (auto _ : state) {
+        nm.printFormattedTable(table, {"NAME", "UUID", "TYPE", "DEVICE"});
+    }
+    std::cout.rdbuf(stdout_buf);
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+} // namespace
+
+// connection show 和 connection delete 每个连接名生成一次 UUID
+static void BM_StringToUUID(benchmark::State &state) {
+    std::vector<std::string> names(state.range(0));
+    for (size_t i = 0; i < names.size(); ++i) {
+        names[i] = "bench-network-" + std::to_string(i);
+    }
+    for (auto _ : state) {
+        for (const auto &name : names) {
+            benchmark::DoNotOptimize(stringToUUID(name));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_StringToUUID)->RangeMultiplier(10)->Range(10, 100000);
+
+// 逐个转换的 dBm 到信号质量映射（批量版本见 BM_QualityKernel）
+static void BM_DbmToQualitySegmented(benchmark::State &state) {
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> dbm(-100, -20);
+    std::vector<int> signals(state.range(0));
+    for (auto &signal : signals) {
+        signal = dbm(rng);
+    }
+    NetworkManager nm;
+    for (auto _ : state) {
+        int sum = 0;
+        for (int signal : signals) {
+            sum += nm.dbmToQualitySegmented(signal);
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_DbmToQualitySegmented)->RangeMultiplier(10)->Range(10, 100000);
+
+static void BM_PrintFormattedTableAligned(benchmark::State &state) {
+    runTable(state, false);
+}
+BENCHMARK(BM_PrintFormattedTableAligned)->RangeMultiplier(10)->Range(10, 100000);
+
+static void BM_PrintFormattedTableTerse(benchmark::State &state) {
+    runTable(state, true);
+}
+BENCHMARK(BM_PrintFormattedTableTerse)->RangeMultiplier(10)->Range(10, 100000);
+
+// getAdapterObjectPath：在 /net/connman/iwd 的内省数据中查找适配器节点
+static void BM_AdapterPathFromIntrospection(benchmark::State &state) {
+    const std::string xml = makeIntrospection(state.range(0));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(adapterPathFromIntrospection(xml));
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(xml.size()));
+}
+BENCHMARK(BM_AdapterPathFromIntrospection)->RangeMultiplier(10)->Range(10, 100000);
+
+// Station::getAllConnection：从同一份内省数据中列出所有已知网络路径
+static void BM_NetworkPathsFromIntrospection(benchmark::State &state) {
+    const std::string xml = makeIntrospection(state.range(0));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(networkPathsFromIntrospection(xml));
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(xml.size()));
+}
+BENCHMARK(BM_NetworkPathsFromIntrospection)->RangeMultiplier(10)->Range(10, 100000);
+
+// -f 字段列表的切分
+static void BM_Split(benchmark::State &state) {
+    std::string fields;
+    for (int64_t i = 0; i < state.range(0); ++i) {
+        fields += (i > 0 ? "," : "") + std::string("FIELD") + std::to_string(i);
+    }
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(split(fields, ','));
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Split)->RangeMultiplier(10)->Range(10, 100000);
@@ -0,0 +1,145 @@
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "mem_counters.h"
+#include "mem_stats.h"
+#include "scan_snapshot.h"
+#include "signal_quality.h"
+
+namespace {
+
+// 旧实现中每行的数据结构
+struct NetworkRow {
+    std::string object_path;
+    std::string ssid;
+    std::string security;
+    int signal_strength;
+    bool in_use;
+};
+
+// 旧实现中带分支的逐行转换
+int legacyQuality(int rssi_dbm) {
+    if (rssi_dbm >= -50) {
+        return 100;
+    } else if (rssi_dbm >= -60) {
+        return 80 + ((rssi_dbm + 60) * 20) / 10;
+    } else if (rssi_dbm >= -70) {
+        return 60 + ((rssi_dbm + 70) * 20) / 10;
+    } else if (rssi_dbm >= -80) {
+        return 40 + ((rssi_dbm + 80) * 20) / 10;
+    } else if (rssi_dbm >= -90) {
+        return 20 + ((rssi_dbm + 90) * 20) / 10;
+    } else {
+        return 0;
+    }
+}
+
+// 按 iwd 的返回顺序（信号降序）生成合成网络
+std::vector<NetworkRow> makeNetworks(size_t count) {
+    static const char *security[] = {"open", "wep", "psk", "8021x"};
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> signal(-9500, -3000);
+
+    std::vector<NetworkRow> rows(count);
+    for (size_t i = 0; i < count; ++i) {
+        rows[i].ssid = "bench-network-" + std::to_string(i);
+        rows[i].object_path = "/net/connman/iwd/0/4/" + std::to_string(i) + "_psk";
+        rows[i].security = security[i % 4];
+        rows[i].signal_strength = signal(rng);
+        rows[i].in_use = i == 0;
+    }
+    std::sort(rows.begin(), rows.end(), [](const NetworkRow &a, const NetworkRow &b) {
+        return a.signal_strength > b.signal_strength;
+    });
+    return rows;
+}
+
+ScanSnapshot makeSnapshot(const std::vector<NetworkRow> &rows) {
+    ScanSnapshot snapshot(rows.size());
+    for (const auto &row : rows) {
+        snapshot.add(row.object_path, row.ssid, row.security, row.signal_strength, row.in_use);
+    }
+    return snapshot;
+}
+
+constexpr size_t LIMIT = 20;
+
+} // namespace
+
+// 旧的列表路径：完整排序 + 逐行分支转换 + std::to_string
+static void BM_ListLegacyFullSort(benchmark::State &state) {
+    // 与 iwd 返回的数据一样，输入已经按信号降序排列
+    auto networks = makeNetworks(state.range(0));
+    MemCounters memory(state);
+    for (auto _ : state) {
+        MemPhase phase("command", "device wifi list");
+        std::sort(networks.begin(), networks.end(), [](const NetworkRow &a, const NetworkRow &b) {
+            return a.signal_strength > b.signal_strength;
+        });
+        std::vector<std::string> column;
+        column.reserve(networks.size());
+        for (const auto &network : networks) {
+            column.push_back(std::to_string(legacyQuality(network.signal_strength / 100)));
+        }
+        benchmark::DoNotOptimize(column.data());
+    }
+    memory.report();
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_ListLegacyFullSort)->Arg(10000)->Arg(100000);
+
+// 新的列表路径：SoA 快照 + 已排序检查 / Top-K + 批量质量转换
+static void BM_ListSnapshotTopK(benchmark::State &state) {
+    const auto snapshot = makeSnapshot(makeNetworks(state.range(0)));
+    const size_t limit = state.range(1);
+    const int16_t *signals = snapshot.signals();
+    auto stronger = [signals](uint32_t a, uint32_t b) { return signals[a] > signals[b]; };
+
+    MemCounters memory(state);
+    for (auto _ : state) {
+        MemPhase phase("command", "device wifi list");
+        std::vector<uint32_t> order(snapshot.size());
+        std::iota(order.begin(), order.end(), 0);
+        if (limit > 0 && limit < order.size()) {
+            std::partial_sort(order.begin(), order.begin() + limit, order.end(), stronger);
+        } else if (!std::is_sorted(order.begin(), order.end(), stronger)) {
+            std::sort(order.begin(), order.end(), stronger);
+        }
+        std::vector<uint8_t> quality(snapshot.size());
+        signalToQuality(signals, quality.data(), snapshot.size());
+        benchmark::DoNotOptimize(order.data());
+        benchmark::DoNotOptimize(quality.data());
+    }
+    memory.report();
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_ListSnapshotTopK)->Args({10000, 0})->Args({100000, 0})->Args({10000, LIMIT})->Args({100000, LIMIT});
+
+static void BM_QualityScalarBranchy(benchmark::State &state) {
+    const auto snapshot = makeSnapshot(makeNetworks(state.range(0)));
+    std::vector<uint8_t> quality(snapshot.size());
+    for (auto _ : state) {
+        for (size_t i = 0; i < snapshot.size(); ++i) {
+            quality[i] = static_cast<uint8_t>(legacyQuality(snapshot.signal(i) / 100));
+        }
+        benchmark::DoNotOptimize(quality.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_QualityScalarBranchy)->Arg(10000)->Arg(100000);
+
+static void BM_QualityKernel(benchmark::State &state) {
+    const auto snapshot = makeSnapshot(makeNetworks(state.range(0)));
+    std::vector<uint8_t> quality(snapshot.size());
+    for (auto _ : state) {
+        signalToQuality(snapshot.signals(), quality.data(), snapshot.size());
+        benchmark::DoNotOptimize(quality.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_QualityKernel)->Arg(10000)->Arg(100000);
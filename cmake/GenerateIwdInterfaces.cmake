@@ -0,0 +1,405 @@
+# 由 D-Bus 内省 XML 生成 iwd 接口的类型化属性结构体和代理类
+#
+#   cmake -DINPUT_DIR=<xml 目录> -DOUTPUT=<头文件> -P GenerateIwdInterfaces.cmake
+#
+# 每个 XML 文件描述一个接口，只识别 property、method、arg 和 annotation 元素。
+# 对每个接口生成：
+#   Iwd<名称>Properties  属性结构体，decode() 一次遍历 GetAll/GetManagedObjects 的属性字典；
+#                        缺少必需属性或类型不符时抛出 DBusException
+#   Iwd<名称>Proxy       包装 sdbus::IProxy 的代理，属性访问器、可写属性的 set 方法和接口方法都有确定的类型；
+#                        PropertyCache 覆盖的字符串属性（Name、Type）读取时先查 --cache
+# 带 org.nmcli_alt.Optional 注解的属性（iwd 只在特定状态下提供）为 std::optional，缺失时不报错。
+# 解码失败只影响该对象：遍历 GetManagedObjects 的调用者捕获 DBusException 并跳过这个对象。
+
+cmake_minimum_required(VERSION 3.10)
+
+if(NOT INPUT_DIR OR NOT OUTPUT)
+    message(FATAL_ERROR "Usage: cmake -DINPUT_DIR=<dir> -DOUTPUT=<header> -P GenerateIwdInterfaces.cmake")
+endif()
+
+# D-Bus 签名到 C++ 类型，只列出接口定义中用到的签名
+function(dbus_cpp_type signature out_var)
+    if(signature STREQUAL "s")
+        set(type "std::string")
+    elseif(signature STREQUAL "b")
+        set(type "bool")
+    elseif(signature STREQUAL "o")
+        set(type "sdbus::ObjectPath")
+    elseif(signature STREQUAL "y")
+        set(type "uint8_t")
+    elseif(signature STREQUAL "n")
+        set(type "int16_t")
+    elseif(signature STREQUAL "q")
+        set(type "uint16_t")
+    elseif(signature STREQUAL "i")
+        set(type "int32_t")
+    elseif(signature STREQUAL "u")
+        set(type "uint32_t")
+    elseif(signature STREQUAL "x")
+        set(type "int64_t")
+    elseif(signature STREQUAL "t")
+        set(type "uint64_t")
+    elseif(signature STREQUAL "d")
+        set(type "double")
+    elseif(signature STREQUAL "as")
+        set(type "std::vector<std::string>")
+    elseif(signature STREQUAL "ao")
+        set(type "std::vector<sdbus::ObjectPath>")
+    elseif(signature STREQUAL "an")
+        set(type "std::vector<int16_t>")
+    elseif(signature STREQUAL "a(on)")
+        set(type "std::vector<sdbus::Struct<sdbus::ObjectPath, int16_t>>")
+    elseif(signature STREQUAL "a(sns)")
+        set(type "std::vector<sdbus::Struct<std::string, int16_t, std::string>>")
+    elseif(signature STREQUAL "a{sv}")
+        set(type "std::map<std::string, sdbus::Variant>")
+    else()
+        message(FATAL_ERROR "${xml_file}: unsupported D-Bus signature '${signature}', add it to dbus_cpp_type")
+    endif()
+    set(${out_var} "${type}" PARENT_SCOPE)
+endfunction()
+
+# 参数声明：标量按值传递，其余按 const 引用
+function(cpp_parameter type name out_var)
+    if(type MATCHES "^(bool|u?int[0-9]+_t|double)$")
+        set(${out_var} "${type} ${name}" PARENT_SCOPE)
+    else()
+        set(${out_var} "const ${type} &${name}" PARENT_SCOPE)
+    endif()
+endfunction()
+
+# LastConnectedTime -> last_connected_time
+function(snake_case name out_var)
+    string(REGEX REPLACE "([a-z0-9])([A-Z])" "\\1_\\2" result "${name}")
+    string(TOLOWER "${result}" result)
+    set(${out_var} "${result}" PARENT_SCOPE)
+endfunction()
+
+# GetOrderedNetworks -> getOrderedNetworks
+function(lower_camel name out_var)
+    string(SUBSTRING "${name}" 0 1 first)
+    string(SUBSTRING "${name}" 1 -1 rest)
+    string(TOLOWER "${first}" first)
+    set(${out_var} "${first}${rest}" PARENT_SCOPE)
+endfunction()
+
+function(xml_attribute tag attribute out_var)
+    if(tag MATCHES "${attribute}=\"([^\"]*)\"")
+        set(${out_var} "${CMAKE_MATCH_1}" PARENT_SCOPE)
+    else()
+        set(${out_var} "" PARENT_SCOPE)
+    endif()
+endfunction()
+
+macro(emit_property)
+    dbus_cpp_type("${property_type}" cpp_type)
+    snake_case("${property_name}" field)
+    lower_camel("${property_name}" accessor)
+
+    if(property_optional)
+        string(APPEND fields "    std::optional<${cpp_type}> ${field};\n")
+        string(APPEND accessors
+            "    std::optional<${cpp_type}> ${accessor}() const { return getOptional<${cpp_type}>(\"${property_name}\"); }\n"
+        )
+    else()
+        if(cpp_type MATCHES "^(bool|u?int[0-9]+_t|double)$")
+            string(APPEND fields "    ${cpp_type} ${field}{};\n")
+        else()
+            string(APPEND fields "    ${cpp_type} ${field};\n")
+        endif()
+        string(APPEND accessors
+            "    ${cpp_type} ${accessor}() const { return get<${cpp_type}>(\"${property_name}\"); }\n"
+        )
+    endif()
+
+    if(decode_cases STREQUAL "")
+        string(APPEND decode_cases "            if (name == \"${property_name}\") {\n")
+    else()
+        string(APPEND decode_cases "            } else if (name == \"${property_name}\") {\n")
+    endif()
+    string(APPEND decode_cases
+        "                result.${field} = iwdPropertyValue<${cpp_type}>(value, INTERFACE, \"${property_name}\");\n"
+    )
+    if(NOT property_optional)
+        string(APPEND decode_cases "                seen |= 1ull << ${required_count};\n")
+        string(APPEND required_names " ${property_name}")
+        math(EXPR required_count "${required_count} + 1")
+    endif()
+
+    if(property_access STREQUAL "readwrite")
+        cpp_parameter("${cpp_type}" value parameter)
+        string(APPEND accessors
+            "    void set${property_name}(${parameter}) const { set(\"${property_name}\", value); }\n"
+        )
+    endif()
+    set(element "")
+endmacro()
+
+macro(emit_method)
+    lower_camel("${method_name}" function_name)
+
+    set(parameters "")
+    set(arguments "")
+    list(LENGTH in_types in_count)
+    if(in_count GREATER 0)
+        math(EXPR last "${in_count} - 1")
+        foreach(index RANGE ${last})
+            list(GET in_types ${index} arg_type)
+            list(GET in_names ${index} arg_name)
+            dbus_cpp_type("${arg_type}" cpp_type)
+            cpp_parameter("${cpp_type}" "${arg_name}" parameter)
+            if(index GREATER 0)
+                string(APPEND parameters ", ")
+            endif()
+            string(APPEND parameters "${parameter}")
+            string(APPEND arguments ", ${arg_name}")
+        endforeach()
+    endif()
+
+    set(results "")
+    list(LENGTH out_types out_count)
+    foreach(arg_type IN LISTS out_types)
+        dbus_cpp_type("${arg_type}" cpp_type)
+        if(results STREQUAL "")
+            set(results "${cpp_type}")
+        else()
+            string(APPEND results ", ${cpp_type}")
+        endif()
+    endforeach()
+
+    set(call "dbusCall<${results}>(proxy_, INTERFACE, \"${method_name}\", \"calling ${method_name}\"${arguments})")
+    if(out_count EQUAL 0)
+        string(APPEND methods "    void ${function_name}(${parameters}) const {\n        ${call};\n    }\n")
+    elseif(out_count EQUAL 1)
+        string(APPEND methods "    ${results} ${function_name}(${parameters}) const {\n        return ${call};\n    }\n")
+    else()
+        string(APPEND methods
+            "    std::tuple<${results}> ${function_name}(${parameters}) const {\n        return ${call};\n    }\n"
+        )
+    endif()
+    set(element "")
+endmacro()
+
+set(body "")
+file(GLOB xml_files "${INPUT_DIR}/*.xml")
+list(SORT xml_files)
+if(NOT xml_files)
+    message(FATAL_ERROR "No interface XML found in ${INPUT_DIR}")
+endif()
+
+foreach(xml_file IN LISTS xml_files)
+    file(READ "${xml_file}" content)
+    string(REGEX REPLACE "<!--[^>]*-->" "" content "${content}")
+
+    if(NOT content MATCHES "<interface name=\"([^\"]+)\"")
+        message(FATAL_ERROR "${xml_file}: no <interface> element")
+    endif()
+    set(interface "${CMAKE_MATCH_1}")
+    string(REGEX REPLACE "^.*\\." "" short_name "${interface}")
+    set(properties_class "Iwd${short_name}Properties")
+    set(proxy_class "Iwd${short_name}Proxy")
+
+    set(fields "")
+    set(decode_cases "")
+    set(accessors "")
+    set(methods "")
+    set(required_count 0)
+    set(required_names "")
+    set(element "")
+
+    string(REGEX MATCHALL "<(property|/property|method|/method|arg|annotation)[^>]*>" tags "${content}")
+    foreach(tag IN LISTS tags)
+        if(tag MATCHES "^<property ")
+            xml_attribute("${tag}" name property_name)
+            xml_attribute("${tag}" type property_type)
+            xml_attribute("${tag}" access property_access)
+            set(property_optional FALSE)
+            set(element property)
+            if(tag MATCHES "/>$")
+                emit_property()
+            endif()
+        elseif(tag STREQUAL "</property>")
+            emit_property()
+        elseif(tag MATCHES "^<annotation ")
+            xml_attribute("${tag}" name annotation_name)
+            xml_attribute("${tag}" value annotation_value)
+            if(element STREQUAL "property" AND annotation_name STREQUAL "org.nmcli_alt.Optional" AND
+               annotation_value STREQUAL "true")
+                set(property_optional TRUE)
+            endif()
+        elseif(tag MATCHES "^<method ")
+            xml_attribute("${tag}" name method_name)
+            set(in_types "")
+            set(in_names "")
+            set(out_types "")
+            set(element method)
+            if(tag MATCHES "/>$")
+                emit_method()
+            endif()
+        elseif(tag STREQUAL "</method>")
+            emit_method()
+        elseif(tag MATCHES "^<arg ")
+            xml_attribute("${tag}" type arg_type)
+            xml_attribute("${tag}" direction arg_direction)
+            xml_attribute("${tag}" name arg_name)
+            if(arg_direction STREQUAL "out")
+                list(APPEND out_types "${arg_type}")
+            else()
+                list(LENGTH in_types in_count)
+                if(arg_name STREQUAL "")
+                    set(arg_name "arg${in_count}")
+                endif()
+                list(APPEND in_types "${arg_type}")
+                list(APPEND in_names "${arg_name}")
+            endif()
+        endif()
+    endforeach()
+
+    string(APPEND body "// ---- ${interface} ----\n\n")
+
+    if(NOT fields STREQUAL "")
+        string(STRIP "${required_names}" required_names)
+        string(APPEND body
+            "struct ${properties_class} {\n"
+            "    static constexpr const char *INTERFACE = \"${interface}\";\n\n"
+            "${fields}\n"
+            "    // 一次遍历属性字典（GetAll 的结果或 GetManagedObjects 中该接口的部分）\n"
+            "    template <typename PropertyMap> static ${properties_class} decode(const PropertyMap &properties) {\n"
+            "        ${properties_class} result;\n"
+        )
+        if(required_count GREATER 0)
+            string(APPEND body "        uint64_t seen = 0;\n")
+        endif()
+        string(APPEND body
+            "        for (const auto &[name, value] : properties) {\n"
+            "${decode_cases}"
+            "            }\n"
+            "        }\n"
+        )
+        if(required_count GREATER 0)
+            string(APPEND body
+                "        if (seen != (1ull << ${required_count}) - 1) {\n"
+                "            throw DBusException(\"${interface} is missing required properties (${required_names})\");\n"
+                "        }\n"
+            )
+        endif()
+        string(APPEND body
+            "        return result;\n"
+            "    }\n"
+            "};\n\n"
+        )
+    endif()
+
+    string(APPEND body
+        "class ${proxy_class} {\n"
+        "  public:\n"
+        "    static constexpr const char *INTERFACE = \"${interface}\";\n\n"
+        "    // proxy 须指向实现了该接口的对象，生命周期长于代理\n"
+        "    explicit ${proxy_class}(sdbus::IProxy &proxy) : proxy_(proxy) {}\n"
+    )
+    if(NOT fields STREQUAL "")
+        string(APPEND body
+            "\n"
+            "${accessors}\n"
+            "    // 一次 GetAll 读取全部属性\n"
+            "    ${properties_class} getAll() const {\n"
+            "        return ${properties_class}::decode(dbusCall<std::map<std::string, sdbus::Variant>>(\n"
+            "            proxy_, \"org.freedesktop.DBus.Properties\", \"GetAll\", \"reading ${interface}\", std::string(INTERFACE)\n"
+            "        ));\n"
+            "    }\n"
+        )
+    endif()
+    if(NOT methods STREQUAL "")
+        string(APPEND body "\n${methods}")
+    endif()
+    string(APPEND body "\n  private:\n")
+    if(NOT fields STREQUAL "")
+        string(APPEND body
+            "    // iwd 生命周期内不变的字符串属性先查跨进程缓存（--cache）\n"
+            "    template <typename T> T get(const char *property) const {\n"
+            "        PropertyCache &cache = PropertyCache::global();\n"
+            "        const bool cached = std::is_same_v<T, std::string> && cache.covers(INTERFACE, property);\n"
+            "        if constexpr (std::is_same_v<T, std::string>) {\n"
+            "            if (cached) {\n"
+            "                const std::string *value =\n"
+            "                    cache.lookup(proxy_.getConnection(), proxy_.getObjectPath(), INTERFACE, property);\n"
+            "                if (value) {\n"
+            "                    return *value;\n"
+            "                }\n"
+            "            }\n"
+            "        }\n"
+            "        sdbus::Variant value = dbusCall<sdbus::Variant>(\n"
+            "            proxy_, \"org.freedesktop.DBus.Properties\", \"Get\", std::string(\"reading \") + property,\n"
+            "            std::string(INTERFACE), std::string(property)\n"
+            "        );\n"
+            "        T result = iwdPropertyValue<T>(value, INTERFACE, property);\n"
+            "        if constexpr (std::is_same_v<T, std::string>) {\n"
+            "            if (cached) {\n"
+            "                cache.store(proxy_.getObjectPath(), INTERFACE, property, result);\n"
+            "            }\n"
+            "        }\n"
+            "        return result;\n"
+            "    }\n\n"
+            "    // iwd（ell）的属性 getter 对当前不存在的属性返回 Error.Failed；其他错误（对象不存在、超时等）照常抛出\n"
+            "    template <typename T> std::optional<T> getOptional(const char *property) const {\n"
+            "        try {\n"
+            "            return get<T>(property);\n"
+            "        } catch (const sdbus::Error &e) {\n"
+            "            if (e.getName() != \"org.freedesktop.DBus.Error.Failed\") {\n"
+            "                throw;\n"
+            "            }\n"
+            "            return std::nullopt;\n"
+            "        }\n"
+            "    }\n\n"
+            "    template <typename T> void set(const char *property, const T &value) const {\n"
+            "        dbusCall<>(\n"
+            "            proxy_, \"org.freedesktop.DBus.Properties\", \"Set\", std::string(\"setting \") + property,\n"
+            "            std::string(INTERFACE), std::string(property), sdbus::Variant(value)\n"
+            "        );\n"
+            "    }\n\n"
+        )
+    endif()
+    string(APPEND body
+        "    sdbus::IProxy &proxy_;\n"
+        "};\n\n"
+    )
+endforeach()
+
+set(header
+"// 由 cmake/GenerateIwdInterfaces.cmake 根据 interfaces/*.xml 生成，不要手工修改
+#ifndef IWD_INTERFACES_H
+#define IWD_INTERFACES_H
+
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+#include <sdbus-c++/sdbus-c++.h>
+#include \"dbus_async.h\"
+#include \"nmcli_exception.h\"
+#include \"property_cache.h\"
+
+// 取出属性值；类型与接口定义不符时抛出 DBusException，而不是返回默认值
+template <typename T> T iwdPropertyValue(const sdbus::Variant &value, const char *interface, const char *property) {
+    if (!value.containsValueOfType<T>()) {
+        throw DBusException(
+            std::string(interface) + \".\" + property + \" has unexpected type '\" + value.peekValueType() + \"'\"
+        );
+    }
+    return value.get<T>();
+}
+
+${body}#endif // IWD_INTERFACES_H
+")
+
+# 内容不变时不改写，避免依赖它的源文件重新编译
+if(EXISTS "${OUTPUT}")
+    file(READ "${OUTPUT}" existing)
+    if(existing STREQUAL header)
+        return()
+    endif()
+endif()
+file(WRITE "${OUTPUT}" "${header}")
@@ -0,0 +1,593 @@
+#ifndef DBUS_ASYNC_H
+#define DBUS_ASYNC_H
+
+#include <algorithm>
+#include <chrono>
+#include <coroutine>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <map>
+#include <optional>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+#include "deadline.h"
+#include "dbus_trace.h"
+#include "instrumentation.h"
+#include "nmcli_exception.h"
+#include "probes.h"
+#include "property_cache.h"
+#include <sdbus-c++/sdbus-c++.h>
+
+template <typename T = void> class DBusTask;
+
+/**
+ * 基于 C++20 协程的 sdbus-c++ 异步调用层
+ *
+ * DBusEventLoop 在调用线程上驱动一个 D-Bus 连接的事件循环；DBusTask 是惰性启动的协程，
+ * 在其中 co_await 异步方法调用、属性变化或定时器，多个任务可以在同一线程上并发推进。
+ * 销毁一个挂起的任务会取消它正在等待的调用。所有调用和等待都受 Deadline::global() 限制。
+ */
+class DBusEventLoop {
+  public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit DBusEventLoop(sdbus::IConnection &connection);
+
+    // 禁止拷贝构造和赋值
+    DBusEventLoop(const DBusEventLoop &) = delete;
+    DBusEventLoop &operator=(const DBusEventLoop &) = delete;
+
+    sdbus::IConnection &connection() { return connection_; }
+
+    // 把协程放入就绪队列，在当前 D-Bus 回调返回后恢复执行
+    void schedule(std::coroutine_handle<> handle);
+
+    // 定时器，到期时在事件循环中调用回调
+    uint64_t addTimer(Clock::time_point when, std::function<void()> callback);
+    void cancelTimer(uint64_t id);
+
+    // 在同一个循环中监视其他文件描述符（如 netlink socket），可读时调用回调
+    uint64_t addWatch(int fd, std::function<void()> on_readable);
+    void removeWatch(uint64_t id);
+
+    // 运行一次循环：处理就绪协程和待处理的 D-Bus 消息，然后最多阻塞到下一个事件
+    void runOnce();
+
+    // 驱动事件循环直到 done() 返回 true
+    void runUntil(const std::function<bool()> &done);
+
+    // 运行单个任务直到完成并返回其结果
+    template <typename Task> auto run(Task task) -> decltype(task.result());
+
+    // 并发运行多个任务直到全部完成，第一个失败任务的异常会被重新抛出
+    template <typename... Tasks> void runAll(Tasks &...tasks);
+    // 数量在运行时确定的版本：先全部启动（各自的调用同时发出），再等待全部完成
+    template <typename T> void runAll(std::vector<DBusTask<T>> &tasks);
+
+    // 等待一段时间的 awaiter
+    class SleepAwaiter {
+      public:
+        SleepAwaiter(DBusEventLoop &loop, Clock::duration duration) : loop_(loop), duration_(duration) {}
+        ~SleepAwaiter() {
+            if (timer_) {
+                loop_.cancelTimer(timer_);
+            }
+        }
+        bool await_ready() const noexcept { return duration_ <= Clock::duration::zero(); }
+        void await_suspend(std::coroutine_handle<> handle) {
+            timer_ = loop_.addTimer(Clock::now() + duration_, [this, handle] {
+                timer_ = 0;
+                loop_.schedule(handle);
+            });
+        }
+        void await_resume() const noexcept {}
+
+      private:
+        DBusEventLoop &loop_;
+        Clock::duration duration_;
+        uint64_t timer_ = 0;
+    };
+
+    SleepAwaiter sleepFor(Clock::duration duration) { return SleepAwaiter(*this, duration); }
+
+  private:
+    struct Timer {
+        Clock::time_point when;
+        std::function<void()> callback;
+    };
+
+    struct Watch {
+        int fd;
+        std::function<void()> on_readable;
+    };
+
+    // 处理所有已就绪的事件，直到没有新的进展
+    void dispatch();
+    void fireTimers();
+
+    sdbus::IConnection &connection_;
+    std::deque<std::coroutine_handle<>> ready_;
+    std::map<uint64_t, Timer> timers_;
+    uint64_t next_timer_id_ = 1;
+    std::map<uint64_t, Watch> watches_;
+    uint64_t next_watch_id_ = 1;
+};
+
+/**
+ * 惰性启动的协程任务
+ *
+ * 被 co_await 时开始执行，完成后通过对称转移恢复等待者；顶层任务由 DBusEventLoop::run 启动。
+ */
+class DBusTaskPromiseBase {
+  public:
+    struct FinalAwaiter {
+        bool await_ready() const noexcept { return false; }
+        template <typename Promise> std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept {
+            std::coroutine_handle<> continuation = handle.promise().continuation_;
+            return continuation ? continuation : std::noop_coroutine();
+        }
+        void await_resume() const noexcept {}
+    };
+
+    std::suspend_always initial_suspend() const noexcept { return {}; }
+    FinalAwaiter final_suspend() const noexcept { return {}; }
+    void unhandled_exception() { exception_ = std::current_exception(); }
+
+    std::coroutine_handle<> continuation_;
+    std::exception_ptr exception_;
+};
+
+template <typename T> class DBusTask {
+  public:
+    struct promise_type : DBusTaskPromiseBase {
+        DBusTask get_return_object() { return DBusTask(std::coroutine_handle<promise_type>::from_promise(*this)); }
+        void return_value(T value) { value_ = std::move(value); }
+
+        std::optional<T> value_;
+    };
+
+    DBusTask(DBusTask &&other) noexcept : handle_(std::exchange(other.handle_, {})) {}
+    DBusTask &operator=(DBusTask &&other) noexcept {
+        if (this != &other) {
+            reset();
+            handle_ = std::exchange(other.handle_, {});
+        }
+        return *this;
+    }
+    DBusTask(const DBusTask &) = delete;
+    DBusTask &operator=(const DBusTask &) = delete;
+    ~DBusTask() { reset(); }
+
+    void start() { handle_.resume(); }
+    bool done() const { return !handle_ || handle_.done(); }
+    bool failed() const { return handle_ && handle_.done() && handle_.promise().exception_; }
+
+    T result() {
+        if (handle_.promise().exception_) {
+            std::rethrow_exception(handle_.promise().exception_);
+        }
+        return std::move(*handle_.promise().value_);
+    }
+
+    bool await_ready() const noexcept { return done(); }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+        handle_.promise().continuation_ = awaiting;
+        return handle_;
+    }
+    T await_resume() { return result(); }
+
+  private:
+    explicit DBusTask(std::coroutine_handle<promise_type> handle) : handle_(handle) {}
+
+    void reset() {
+        if (handle_) {
+            handle_.destroy();
+            handle_ = {};
+        }
+    }
+
+    std::coroutine_handle<promise_type> handle_;
+};
+
+template <> class DBusTask<void> {
+  public:
+    struct promise_type : DBusTaskPromiseBase {
+        DBusTask get_return_object() { return DBusTask(std::coroutine_handle<promise_type>::from_promise(*this)); }
+        void return_void() const noexcept {}
+    };
+
+    DBusTask(DBusTask &&other) noexcept : handle_(std::exchange(other.handle_, {})) {}
+    DBusTask &operator=(DBusTask &&other) noexcept {
+        if (this != &other) {
+            reset();
+            handle_ = std::exchange(other.handle_, {});
+        }
+        return *this;
+    }
+    DBusTask(const DBusTask &) = delete;
+    DBusTask &operator=(const DBusTask &) = delete;
+    ~DBusTask() { reset(); }
+
+    void start() { handle_.resume(); }
+    bool done() const { return !handle_ || handle_.done(); }
+    bool failed() const { return handle_ && handle_.done() && handle_.promise().exception_; }
+
+    void result() {
+        if (handle_.promise().exception_) {
+            std::rethrow_exception(handle_.promise().exception_);
+        }
+    }
+
+    bool await_ready() const noexcept { return done(); }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+        handle_.promise().continuation_ = awaiting;
+        return handle_;
+    }
+    void await_resume() { result(); }
+
+  private:
+    explicit DBusTask(std::coroutine_handle<promise_type> handle) : handle_(handle) {}
+
+    void reset() {
+        if (handle_) {
+            handle_.destroy();
+            handle_ = {};
+        }
+    }
+
+    std::coroutine_handle<promise_type> handle_;
+};
+
+template <typename Task> auto DBusEventLoop::run(Task task) -> decltype(task.result()) {
+    task.start();
+    runUntil([&task] { return task.done(); });
+    return task.result();
+}
+
+template <typename... Tasks> void DBusEventLoop::runAll(Tasks &...tasks) {
+    (tasks.start(), ...);
+    runUntil([&tasks...] { return (tasks.done() && ...); });
+    (tasks.result(), ...);
+}
+
+template <typename T> void DBusEventLoop::runAll(std::vector<DBusTask<T>> &tasks) {
+    for (auto &task : tasks) {
+        task.start();
+    }
+    runUntil([&tasks] { return std::all_of(tasks.begin(), tasks.end(), [](const auto &task) { return task.done(); }); });
+    for (auto &task : tasks) {
+        if (task.failed()) {
+            task.result();
+        }
+    }
+}
+
+// 0 个返回值为 void，1 个为该类型本身，多个为 std::tuple
+template <typename... Results> struct DBusCallResult {
+    using type = std::tuple<Results...>;
+};
+template <> struct DBusCallResult<> {
+    using type = void;
+};
+template <typename Result> struct DBusCallResult<Result> {
+    using type = Result;
+};
+
+/**
+ * 异步方法调用的 awaiter，回复到达后恢复协程；调用失败时在 co_await 处抛出 sdbus::Error
+ */
+template <typename ArgsTuple, typename... Results> class DBusCallAwaiter {
+  public:
+    DBusCallAwaiter(
+        DBusEventLoop &loop, sdbus::IProxy &proxy, std::string interface, std::string method, ArgsTuple args
+    )
+        : loop_(loop), proxy_(proxy), interface_(std::move(interface)), method_(std::move(method)),
+          args_(std::move(args)) {}
+
+    DBusCallAwaiter(const DBusCallAwaiter &) = delete;
+    DBusCallAwaiter &operator=(const DBusCallAwaiter &) = delete;
+
+    ~DBusCallAwaiter() {
+        // 协程在等待期间被销毁时取消调用，避免回调访问已释放的 awaiter；
+        // 回调不会再运行，由这里触发结束探针，开始探针不会没有配对
+        if (call_ && call_->isPending()) {
+            call_->cancel();
+            Probes::end(ProbeKind::DBus, method_.c_str(), proxy_.getObjectPath().c_str(), start_, -1);
+        }
+        if (timer_) {
+            loop_.cancelTimer(timer_);
+        }
+    }
+
+    bool await_ready() const noexcept { return false; }
+
+    void await_suspend(std::coroutine_handle<> handle) {
+        Trace &trace = Trace::global();
+        if (trace.recording() || trace.replaying()) {
+            key_ = std::apply(
+                [this](const auto &...args) { return dbusTraceKey(proxy_, interface_, method_, args...); }, args_
+            );
+        }
+
+        // 回放时不访问总线，录制的响应立即可用；paced 回放在录制的耗时之后由定时器恢复，不阻塞其他调用
+        if (trace.replaying()) {
+            Trace::Clock::duration delay{};
+            try {
+                results_.emplace(dbusTraceDecode<Results...>(trace.replay(Trace::Kind::DBus, method_, key_, &delay)));
+            } catch (const sdbus::Error &e) {
+                error_ = e;
+            }
+            if (delay > Trace::Clock::duration::zero()) {
+                timer_ = loop_.addTimer(DBusEventLoop::Clock::now() + delay, [this, handle] {
+                    timer_ = 0;
+                    loop_.schedule(handle);
+                });
+            } else {
+                loop_.schedule(handle);
+            }
+            return;
+        }
+
+        start_ = std::chrono::steady_clock::now();
+        Probes::begin(ProbeKind::DBus, method_.c_str(), proxy_.getObjectPath().c_str());
+        std::apply(
+            [this, handle](auto &...args) {
+                call_ = proxy_.callMethodAsync(method_)
+                            .onInterface(interface_)
+                            .withTimeout(Deadline::global().dbusTimeout("calling " + method_))
+                            .withArguments(args...)
+                            .uponReplyInvoke([this, handle](std::optional<sdbus::Error> error, Results... results) {
+                                const auto elapsed = std::chrono::steady_clock::now() - start_;
+                                Instrumentation::record("dbus", method_, elapsed);
+                                Probes::end(
+                                    ProbeKind::DBus, method_.c_str(), proxy_.getObjectPath().c_str(), start_,
+                                    error ? 1 : 0
+                                );
+                                if (Trace::global().recording()) {
+                                    Trace::global().record(
+                                        Trace::Kind::DBus, method_, key_, start_, elapsed,
+                                        error ? dbusTraceError(*error) : dbusTraceReply(results...)
+                                    );
+                                }
+                                if (error) {
+                                    error_ = std::move(error);
+                                } else {
+                                    results_.emplace(std::move(results)...);
+                                }
+                                loop_.schedule(handle);
+                            });
+            },
+            args_
+        );
+    }
+
+    typename DBusCallResult<Results...>::type await_resume() {
+        if (error_) {
+            // 因截止时间到期而失败的调用报告为超时
+            Deadline::global().check("calling " + method_);
+            PropertyCache::global().noteError(error_->getName());
+            throw *error_;
+        }
+        if constexpr (sizeof...(Results) == 1) {
+            return std::move(std::get<0>(*results_));
+        } else if constexpr (sizeof...(Results) > 1) {
+            return std::move(*results_);
+        }
+    }
+
+  private:
+    DBusEventLoop &loop_;
+    sdbus::IProxy &proxy_;
+    std::string interface_;
+    std::string method_;
+    ArgsTuple args_;
+    std::chrono::steady_clock::time_point start_;
+    std::string key_;
+    std::optional<sdbus::PendingAsyncCall> call_;
+    uint64_t timer_ = 0; // paced 回放的恢复定时器
+    std::optional<sdbus::Error> error_;
+    std::optional<std::tuple<Results...>> results_;
+};
+
+/**
+ * 异步调用 D-Bus 方法，Results 为返回值类型，参数类型自动推导
+ *
+ *     auto xml = co_await dbusCallAsync<std::string>(loop, proxy, "org.freedesktop.DBus.Introspectable", "Introspect");
+ */
+template <typename... Results, typename... Args>
+DBusCallAwaiter<std::tuple<std::decay_t<Args>...>, Results...> dbusCallAsync(
+    DBusEventLoop &loop, sdbus::IProxy &proxy, const std::string &interface, const std::string &method, Args &&...args
+) {
+    return DBusCallAwaiter<std::tuple<std::decay_t<Args>...>, Results...>(
+        loop, proxy, interface, method, std::tuple<std::decay_t<Args>...>(std::forward<Args>(args)...)
+    );
+}
+
+/**
+ * 同步调用 D-Bus 方法，what 描述调用目的，用于超时信息
+ *
+ * 与 dbusCallAsync 一样记录调用耗时，并参与 --record / --replay；因截止时间到期而失败时抛出 TimeoutException。
+ *
+ *     auto xml = dbusCall<std::string>(proxy, "org.freedesktop.DBus.Introspectable", "Introspect", "listing objects");
+ */
+template <typename... Results, typename... Args>
+typename DBusCallResult<Results...>::type dbusCall(
+    sdbus::IProxy &proxy, const std::string &interface, const std::string &method, const std::string &what,
+    const Args &...args
+) {
+    Trace &trace = Trace::global();
+    std::tuple<Results...> results;
+
+    if (trace.replaying()) {
+        results = dbusTraceDecode<Results...>(
+            trace.replay(Trace::Kind::DBus, method, dbusTraceKey(proxy, interface, method, args...))
+        );
+    } else {
+        const auto start = std::chrono::steady_clock::now();
+        ProbeSpan probe(ProbeKind::DBus, method.c_str(), proxy.getObjectPath().c_str());
+        try {
+            LatencySpan span("dbus", method);
+            std::apply(
+                [&](auto &...out) {
+                    proxy.callMethod(method)
+                        .onInterface(interface)
+                        .withTimeout(Deadline::global().dbusTimeout(what))
+                        .withArguments(args...)
+                        .storeResultsTo(out...);
+                },
+                results
+            );
+        } catch (const sdbus::Error &e) {
+            probe.setResult(1);
+            if (trace.recording()) {
+                trace.record(
+                    Trace::Kind::DBus, method, dbusTraceKey(proxy, interface, method, args...), start,
+                    std::chrono::steady_clock::now() - start, dbusTraceError(e)
+                );
+            }
+            PropertyCache::global().noteError(e.getName());
+            // 与 DBusCallAwaiter 一样，因截止时间到期而失败的调用报告为超时
+            Deadline::global().check(what);
+            throw;
+        }
+
+        if (trace.recording()) {
+            trace.record(
+                Trace::Kind::DBus, method, dbusTraceKey(proxy, interface, method, args...), start,
+                std::chrono::steady_clock::now() - start,
+                std::apply([](const auto &...values) { return dbusTraceReply(values...); }, results)
+            );
+        }
+    }
+
+    if constexpr (sizeof...(Results) == 1) {
+        return std::move(std::get<0>(results));
+    } else if constexpr (sizeof...(Results) > 1) {
+        return results;
+    }
+}
+
+/**
+ * 等待属性满足条件的 awaiter
+ *
+ * 先订阅 PropertiesChanged 再读取当前值，因此不会错过两者之间发生的变化。
+ * 条件满足时 co_await 返回 true，超时返回 false（timeout 为 0 表示不超时）；
+ * 等待时间不超过 Deadline::global() 的剩余时间，因截止时间到期结束时抛出 TimeoutException。
+ * 录制时保存读取的当前值和使条件满足的那次属性变化，回放时依次检查这两个值，不满足则立即按超时结束。
+ */
+class DBusPropertyWait {
+  public:
+    using Predicate = std::function<bool(const sdbus::Variant &)>;
+
+    DBusPropertyWait(
+        DBusEventLoop &loop, sdbus::IProxy &proxy, std::string interface, std::string property, Predicate predicate,
+        DBusEventLoop::Clock::duration timeout = DBusEventLoop::Clock::duration::zero()
+    );
+    ~DBusPropertyWait();
+
+    DBusPropertyWait(const DBusPropertyWait &) = delete;
+    DBusPropertyWait &operator=(const DBusPropertyWait &) = delete;
+
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(std::coroutine_handle<> handle);
+    bool await_resume();
+
+    // 常用条件：属性等于给定值
+    template <typename T> static Predicate equals(T expected) {
+        return [expected](const sdbus::Variant &value) {
+            return value.containsValueOfType<T>() && value.get<T>() == expected;
+        };
+    }
+
+  private:
+    // 条件在这次检查中满足时返回 true
+    bool check(const sdbus::Variant &value);
+    void finish(bool matched);
+    void replay();
+
+    DBusEventLoop &loop_;
+    sdbus::IProxy &proxy_;
+    std::string interface_;
+    std::string property_;
+    Predicate predicate_;
+    DBusEventLoop::Clock::duration timeout_;
+
+    std::coroutine_handle<> handle_;
+    sdbus::Slot signal_slot_;
+    std::optional<sdbus::PendingAsyncCall> get_call_;
+    std::chrono::steady_clock::time_point get_start_;
+    uint64_t timer_ = 0;
+    DBusEventLoop::Clock::duration replay_delay_{}; // paced 回放时录制的 Get 耗时
+    bool finished_ = false;
+    bool matched_ = false;
+    std::optional<sdbus::Error> error_;
+};
+
+/**
+ * 等待对象出现的 awaiter
+ *
+ * 在 ObjectManager（manager 指向其根对象）下等待一个路径以 path_prefix 开头、实现了 interface 的对象。
+ * 先订阅 InterfacesAdded 再调用 GetManagedObjects，因此不会错过两者之间出现的对象。
+ * 给出 match 时每个这样的对象都交给它，返回 true 才结束等待，可以用来等待一组对象全部出现。
+ * co_await 返回使等待结束的对象路径，超时返回空字符串；超时和截止时间的处理与 DBusPropertyWait 相同。
+ * 录制时保存 GetManagedObjects 的结果和等待期间符合条件的每次 InterfacesAdded，回放时依次检查。
+ */
+class DBusInterfaceWait {
+  public:
+    using Interfaces = std::map<std::string, std::map<std::string, sdbus::Variant>>;
+    using Match = std::function<bool(const sdbus::ObjectPath &, const Interfaces &)>;
+
+    DBusInterfaceWait(
+        DBusEventLoop &loop, sdbus::IProxy &manager, std::string interface, std::string path_prefix,
+        DBusEventLoop::Clock::duration timeout = DBusEventLoop::Clock::duration::zero(), Match match = {}
+    );
+    ~DBusInterfaceWait();
+
+    DBusInterfaceWait(const DBusInterfaceWait &) = delete;
+    DBusInterfaceWait &operator=(const DBusInterfaceWait &) = delete;
+
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(std::coroutine_handle<> handle);
+    std::string await_resume();
+
+  private:
+    using ManagedObjects = std::map<sdbus::ObjectPath, Interfaces>;
+
+    // 路径和接口是否符合条件
+    bool relevant(const sdbus::ObjectPath &path, const Interfaces &interfaces) const;
+    // 对象符合条件且 match 接受时结束等待并返回 true
+    bool check(const sdbus::ObjectPath &path, const Interfaces &interfaces);
+    void finish(const std::string &path);
+    void replay();
+
+    DBusEventLoop &loop_;
+    sdbus::IProxy &manager_;
+    std::string interface_;
+    std::string path_prefix_;
+    DBusEventLoop::Clock::duration timeout_;
+    Match match_;
+
+    std::coroutine_handle<> handle_;
+    sdbus::Slot signal_slot_;
+    std::optional<sdbus::PendingAsyncCall> list_call_;
+    std::chrono::steady_clock::time_point list_start_;
+    uint64_t timer_ = 0;
+    DBusEventLoop::Clock::duration replay_delay_{}; // paced 回放时录制的 GetManagedObjects 耗时
+    bool finished_ = false;
+    std::string path_;
+    std::optional<sdbus::Error> error_;
+};
+
+/**
+ * 打开系统总线连接
+ *
+ * 回放（--replay）时不访问总线：返回 socketpair 一端上的服务端连接，对端从不发言，
+ * 方法调用都由追踪文件应答，信号订阅只在本地登记，因此回放可以在没有 D-Bus 的机器上运行。
+ */
+std::unique_ptr<sdbus::IConnection> openSystemBus();
+
+#endif // DBUS_ASYNC_H
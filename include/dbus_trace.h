@@ -0,0 +1,221 @@
+#ifndef DBUS_TRACE_H
+#define DBUS_TRACE_H
+
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "trace.h"
+#include <sdbus-c++/sdbus-c++.h>
+
+/**
+ * D-Bus 参数和返回值在追踪文件中的编码
+ *
+ * 只覆盖 iwd 接口用到的类型：基本类型、字符串、对象路径、数组、字典、结构体和 Variant。
+ * Variant 保存类型签名；签名不在支持范围内的值无法录制，抛出 NmcliException 让录制失败，
+ * 而不是录成空 Variant、回放时悄悄变成默认值。
+ */
+template <typename T, typename = void> struct TraceCodec;
+
+template <typename T> struct TraceCodec<T, std::enable_if_t<std::is_arithmetic_v<T>>> {
+    static void encode(TraceEncoder &encoder, const T &value) {
+        uint64_t bits = 0;
+        std::memcpy(&bits, &value, sizeof(T));
+        encoder.u64(bits);
+    }
+    static T decode(TraceDecoder &decoder) {
+        uint64_t bits = decoder.u64();
+        T value;
+        std::memcpy(&value, &bits, sizeof(T));
+        return value;
+    }
+};
+
+template <> struct TraceCodec<std::string> {
+    static void encode(TraceEncoder &encoder, const std::string &value) { encoder.bytes(value); }
+    static std::string decode(TraceDecoder &decoder) { return std::string(decoder.bytes()); }
+};
+
+template <> struct TraceCodec<sdbus::ObjectPath> {
+    static void encode(TraceEncoder &encoder, const sdbus::ObjectPath &value) { encoder.bytes(value); }
+    static sdbus::ObjectPath decode(TraceDecoder &decoder) { return sdbus::ObjectPath{std::string(decoder.bytes())}; }
+};
+
+template <typename T> struct TraceCodec<std::vector<T>> {
+    static void encode(TraceEncoder &encoder, const std::vector<T> &value) {
+        encoder.u32(static_cast<uint32_t>(value.size()));
+        for (const auto &element : value) {
+            TraceCodec<T>::encode(encoder, element);
+        }
+    }
+    static std::vector<T> decode(TraceDecoder &decoder) {
+        std::vector<T> value(decoder.u32());
+        for (auto &element : value) {
+            element = TraceCodec<T>::decode(decoder);
+        }
+        return value;
+    }
+};
+
+template <typename K, typename V> struct TraceCodec<std::map<K, V>> {
+    static void encode(TraceEncoder &encoder, const std::map<K, V> &value) {
+        encoder.u32(static_cast<uint32_t>(value.size()));
+        for (const auto &[key, element] : value) {
+            TraceCodec<K>::encode(encoder, key);
+            TraceCodec<V>::encode(encoder, element);
+        }
+    }
+    static std::map<K, V> decode(TraceDecoder &decoder) {
+        std::map<K, V> value;
+        for (uint32_t count = decoder.u32(); count > 0; --count) {
+            K key = TraceCodec<K>::decode(decoder);
+            value.emplace(std::move(key), TraceCodec<V>::decode(decoder));
+        }
+        return value;
+    }
+};
+
+template <typename... E> struct TraceCodec<sdbus::Struct<E...>> {
+    static void encode(TraceEncoder &encoder, const sdbus::Struct<E...> &value) {
+        std::apply(
+            [&encoder](const E &...fields) { (TraceCodec<E>::encode(encoder, fields), ...); },
+            static_cast<const std::tuple<E...> &>(value)
+        );
+    }
+    static sdbus::Struct<E...> decode(TraceDecoder &decoder) {
+        // 花括号初始化保证按字段顺序求值
+        return sdbus::Struct<E...>(std::tuple<E...>{TraceCodec<E>::decode(decoder)...});
+    }
+};
+
+template <> struct TraceCodec<sdbus::Variant> {
+    static void encode(TraceEncoder &encoder, const sdbus::Variant &value) {
+        const char *raw = value.isEmpty() ? nullptr : value.peekValueType();
+        const std::string signature = raw ? raw : "";
+        if (signature.empty()) {
+            encoder.bytes("");
+            return;
+        }
+        if (!encodeAs<std::string>(encoder, value, signature, "s") &&
+            !encodeAs<sdbus::ObjectPath>(encoder, value, signature, "o") &&
+            !encodeAs<bool>(encoder, value, signature, "b") && !encodeAs<uint8_t>(encoder, value, signature, "y") &&
+            !encodeAs<int16_t>(encoder, value, signature, "n") && !encodeAs<uint16_t>(encoder, value, signature, "q") &&
+            !encodeAs<int32_t>(encoder, value, signature, "i") && !encodeAs<uint32_t>(encoder, value, signature, "u") &&
+            !encodeAs<int64_t>(encoder, value, signature, "x") && !encodeAs<uint64_t>(encoder, value, signature, "t") &&
+            !encodeAs<double>(encoder, value, signature, "d") &&
+            !encodeAs<std::vector<std::string>>(encoder, value, signature, "as") &&
+            !encodeAs<std::vector<sdbus::ObjectPath>>(encoder, value, signature, "ao") &&
+            !encodeAs<std::vector<uint8_t>>(encoder, value, signature, "ay") &&
+            !encodeAs<std::vector<int32_t>>(encoder, value, signature, "ai") &&
+            !encodeAs<std::vector<uint32_t>>(encoder, value, signature, "au") &&
+            !encodeAs<std::vector<sdbus::Variant>>(encoder, value, signature, "av") &&
+            !encodeAs<std::map<std::string, std::string>>(encoder, value, signature, "a{ss}") &&
+            !encodeAs<std::map<std::string, sdbus::Variant>>(encoder, value, signature, "a{sv}")) {
+            throw NmcliException("Cannot record a D-Bus variant of type '" + signature + "'");
+        }
+    }
+
+    static sdbus::Variant decode(TraceDecoder &decoder) {
+        const std::string signature(decoder.bytes());
+        sdbus::Variant value;
+        if (signature.empty()) {
+            return value;
+        }
+        if (decodeAs<std::string>(decoder, signature, "s", value) ||
+            decodeAs<sdbus::ObjectPath>(decoder, signature, "o", value) ||
+            decodeAs<bool>(decoder, signature, "b", value) || decodeAs<uint8_t>(decoder, signature, "y", value) ||
+            decodeAs<int16_t>(decoder, signature, "n", value) || decodeAs<uint16_t>(decoder, signature, "q", value) ||
+            decodeAs<int32_t>(decoder, signature, "i", value) || decodeAs<uint32_t>(decoder, signature, "u", value) ||
+            decodeAs<int64_t>(decoder, signature, "x", value) || decodeAs<uint64_t>(decoder, signature, "t", value) ||
+            decodeAs<double>(decoder, signature, "d", value) ||
+            decodeAs<std::vector<std::string>>(decoder, signature, "as", value) ||
+            decodeAs<std::vector<sdbus::ObjectPath>>(decoder, signature, "ao", value) ||
+            decodeAs<std::vector<uint8_t>>(decoder, signature, "ay", value) ||
+            decodeAs<std::vector<int32_t>>(decoder, signature, "ai", value) ||
+            decodeAs<std::vector<uint32_t>>(decoder, signature, "au", value) ||
+            decodeAs<std::vector<sdbus::Variant>>(decoder, signature, "av", value) ||
+            decodeAs<std::map<std::string, std::string>>(decoder, signature, "a{ss}", value) ||
+            decodeAs<std::map<std::string, sdbus::Variant>>(decoder, signature, "a{sv}", value)) {
+            return value;
+        }
+        throw NmcliException("Unsupported D-Bus variant type '" + signature + "' in trace file");
+    }
+
+  private:
+    template <typename T>
+    static bool
+    encodeAs(TraceEncoder &encoder, const sdbus::Variant &value, const std::string &signature, const char *expected) {
+        if (signature != expected) {
+            return false;
+        }
+        encoder.bytes(signature);
+        TraceCodec<T>::encode(encoder, value.get<T>());
+        return true;
+    }
+
+    template <typename T>
+    static bool
+    decodeAs(TraceDecoder &decoder, const std::string &signature, const char *expected, sdbus::Variant &value) {
+        if (signature != expected) {
+            return false;
+        }
+        value = sdbus::Variant(TraceCodec<T>::decode(decoder));
+        return true;
+    }
+};
+
+// 请求的键：对象路径、接口、方法和编码后的参数（生成合成追踪时不需要代理和总线连接）
+template <typename... Args>
+std::string dbusTraceKey(
+    const std::string &path, const std::string &interface, const std::string &method, const Args &...args
+) {
+    std::string key;
+    TraceEncoder encoder(key);
+    encoder.bytes(path);
+    encoder.bytes(interface);
+    encoder.bytes(method);
+    (TraceCodec<Args>::encode(encoder, args), ...);
+    return key;
+}
+
+template <typename... Args>
+std::string dbusTraceKey(
+    const sdbus::IProxy &proxy, const std::string &interface, const std::string &method, const Args &...args
+) {
+    return dbusTraceKey(proxy.getObjectPath(), interface, method, args...);
+}
+
+// 响应：状态字节后跟返回值，失败时为错误名和错误信息
+template <typename... Results> std::string dbusTraceReply(const Results &...results) {
+    std::string payload;
+    TraceEncoder encoder(payload);
+    encoder.u8(0);
+    (TraceCodec<Results>::encode(encoder, results), ...);
+    return payload;
+}
+
+inline std::string dbusTraceError(const sdbus::Error &error) {
+    std::string payload;
+    TraceEncoder encoder(payload);
+    encoder.u8(1);
+    encoder.bytes(error.getName());
+    encoder.bytes(error.getMessage());
+    return payload;
+}
+
+// 解码录制的响应，录制的是错误时抛出同样的 sdbus::Error
+template <typename... Results> std::tuple<Results...> dbusTraceDecode(const std::string &payload) {
+    TraceDecoder decoder(payload);
+    if (decoder.u8() != 0) {
+        std::string name(decoder.bytes());
+        std::string message(decoder.bytes());
+        throw sdbus::Error(sdbus::Error::Name{std::move(name)}, std::move(message));
+    }
+    return std::tuple<Results...>{TraceCodec<Results>::decode(decoder)...};
+}
+
+#endif // DBUS_TRACE_H
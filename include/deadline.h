@@ -0,0 +1,54 @@
+#ifndef DEADLINE_H
+#define DEADLINE_H
+
+#include <chrono>
+#include <optional>
+#include <string>
+#include "nmcli_exception.h"
+
+/**
+ * 命令的截止时间
+ *
+ * 由 --wait 的时间预算得到，之后每个 D-Bus 调用、netlink 接收和子进程等待都只使用剩余时间，
+ * 因此整个命令的耗时有确定的上限。默认构造的 Deadline 不限时。
+ */
+class Deadline {
+  public:
+    using Clock = std::chrono::steady_clock;
+
+    // sd-bus 的默认方法调用超时，不限时的情况下仍按此值设置单次调用的超时
+    static constexpr std::chrono::microseconds DEFAULT_DBUS_TIMEOUT = std::chrono::seconds(25);
+
+    Deadline() = default;
+
+    // 从现在开始经过 budget 后到期
+    static Deadline after(Clock::duration budget) { return Deadline(Clock::now() + budget); }
+
+    // 进程级截止时间，由 main 根据 --wait 设置
+    static Deadline &global();
+
+    bool unlimited() const { return !when_; }
+    bool expired() const { return when_ && Clock::now() >= *when_; }
+
+    // 剩余时间，不限时返回 fallback，已到期返回 0
+    Clock::duration remainingOr(Clock::duration fallback) const;
+
+    // 已到期时抛出 TimeoutException，what 描述正在进行的操作
+    void check(const std::string &what) const;
+
+    // 单次 D-Bus 调用的超时：剩余时间和 sd-bus 默认值中较小的一个，已到期时抛出 TimeoutException
+    std::chrono::microseconds dbusTimeout(const std::string &what) const;
+
+    // poll() 使用的毫秒超时，不限时返回 -1
+    int pollTimeoutMs() const;
+
+    // 把剩余时间设置为 socket 的 SO_RCVTIMEO，不限时则不做任何事
+    void applyReceiveTimeout(int fd) const;
+
+  private:
+    explicit Deadline(Clock::time_point when) : when_(when) {}
+
+    std::optional<Clock::time_point> when_;
+};
+
+#endif // DEADLINE_H
@@ -0,0 +1,34 @@
+#ifndef DIAGNOSTICS_H
+#define DIAGNOSTICS_H
+
+#include <iostream>
+#include <ostream>
+
+/**
+ * 诊断输出
+ *
+ * iwd 和 Station 相关的库代码在出错时除了返回失败外还会向 stderr 说明原因。
+ * 命令行前端需要这些信息；嵌入方（NmcliClient）只看返回值和异常，
+ * 在自己的线程上用 DiagnosticsMute 静默，不影响其他线程。
+ */
+inline thread_local bool diagnostics_muted = false;
+
+inline std::ostream &diag() {
+    // 没有 streambuf 的流处于 badbit 状态，写入直接丢弃
+    thread_local std::ostream discard(nullptr);
+    return diagnostics_muted ? discard : std::cerr;
+}
+
+class DiagnosticsMute {
+  public:
+    DiagnosticsMute() : previous_(diagnostics_muted) { diagnostics_muted = true; }
+    ~DiagnosticsMute() { diagnostics_muted = previous_; }
+
+    DiagnosticsMute(const DiagnosticsMute &) = delete;
+    DiagnosticsMute &operator=(const DiagnosticsMute &) = delete;
+
+  private:
+    bool previous_;
+};
+
+#endif // DIAGNOSTICS_H
@@ -0,0 +1,95 @@
+#ifndef INSTRUMENTATION_H
+#define INSTRUMENTATION_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include "mem_stats.h"
+
+/**
+ * HDR 风格的延迟直方图
+ *
+ * 对数-线性分桶：每个 2 的幂区间再等分为 32 个子桶，相对误差不超过 1/32，
+ * 以纳秒为单位覆盖 1ns 到约 73 分钟。记录只是一次计数器自增，可以在多个线程中并发记录。
+ */
+class LatencyHistogram {
+  public:
+    static constexpr int SUB_BUCKET_BITS = 5;
+    static constexpr uint64_t SUB_BUCKET_COUNT = 1ull << SUB_BUCKET_BITS;
+    static constexpr int MAX_EXPONENT = 42; // 2^42ns ≈ 73 分钟，更大的值记入最后一个桶
+    static constexpr size_t BUCKET_COUNT = (MAX_EXPONENT - SUB_BUCKET_BITS + 2) * SUB_BUCKET_COUNT;
+
+    LatencyHistogram() = default;
+
+    // 禁止拷贝构造和赋值
+    LatencyHistogram(const LatencyHistogram &) = delete;
+    LatencyHistogram &operator=(const LatencyHistogram &) = delete;
+
+    void record(uint64_t value_ns);
+
+    uint64_t count() const { return count_.load(std::memory_order_relaxed); }
+    uint64_t sum() const { return sum_.load(std::memory_order_relaxed); }
+    uint64_t max() const { return max_.load(std::memory_order_relaxed); }
+
+    // 不超过 value_ns 的记录数（按桶上界判断，误差在桶宽以内）
+    uint64_t countAtOrBelow(uint64_t value_ns) const;
+
+    // 分位数对应的值，q 取 [0, 1]，返回所在桶的上界
+    uint64_t valueAtQuantile(double q) const;
+
+    static size_t bucketIndex(uint64_t value_ns);
+    static uint64_t bucketUpperBound(size_t index);
+
+  private:
+    std::array<std::atomic<uint64_t>, BUCKET_COUNT> buckets_{};
+    std::atomic<uint64_t> count_{0};
+    std::atomic<uint64_t> sum_{0};
+    std::atomic<uint64_t> max_{0};
+};
+
+/**
+ * 进程内所有调用延迟直方图的注册表，按 (kind, operation) 区分
+ *
+ * kind 为 "dbus" 或 "netlink"，operation 为方法名或消息类型。返回的引用在进程生命周期内有效。
+ */
+class Instrumentation {
+  public:
+    static LatencyHistogram &histogram(const std::string &kind, const std::string &operation);
+
+    // 记录一次调用耗时，用于无法用 LatencySpan 包围的异步调用
+    static void record(const std::string &kind, const std::string &operation, std::chrono::steady_clock::duration elapsed);
+
+    // 按 kind、operation 排序依次访问所有直方图
+    static void forEach(
+        const std::function<void(const std::string &kind, const std::string &operation, const LatencyHistogram &)> &fn
+    );
+};
+
+/**
+ * 记录一次调用耗时的 RAII 区间，析构时写入对应的直方图
+ *
+ * 启用 --mem-stats 时区间同时是一个分配统计阶段，标签为 "kind operation"。
+ */
+class LatencySpan {
+  public:
+    LatencySpan(const char *kind, std::string operation)
+        : kind_(kind), operation_(std::move(operation)), mem_phase_(MemStats::enterPhase(kind_, operation_)),
+          start_(std::chrono::steady_clock::now()) {}
+    ~LatencySpan();
+
+    // 禁止拷贝构造和赋值
+    LatencySpan(const LatencySpan &) = delete;
+    LatencySpan &operator=(const LatencySpan &) = delete;
+
+  private:
+    const char *kind_;
+    std::string operation_;
+    int mem_phase_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+#endif // INSTRUMENTATION_H
@@ -0,0 +1,20 @@
+#ifndef IWD_INTROSPECTION_H
+#define IWD_INTROSPECTION_H
+
+#include <string>
+#include <vector>
+
+/**
+ * 解析 iwd 对象的 Introspect XML，只处理字符串，不访问总线（基准测试直接调用）
+ */
+
+// 第一个数字或 phyN 命名的子节点对应的适配器路径，没有时返回空字符串
+std::string adapterPathFromIntrospection(const std::string &introspectionData);
+
+// 适配器下第一个数字命名的子节点对应的设备路径，没有时返回空字符串
+std::string devicePathFromIntrospection(const std::string &adapterPath, const std::string &introspectionData);
+
+// /net/connman/iwd 下所有非纯数字子节点（已知网络）的路径
+std::vector<std::string> networkPathsFromIntrospection(const std::string &introspectionData);
+
+#endif // IWD_INTROSPECTION_H
@@ -1,10 +1,14 @@
 #ifndef IWD_MANAGER_H
 #define IWD_MANAGER_H
 
+#include <chrono>
+#include <functional>
 #include <memory>
+#include <optional>
 #include <string>
 #include <vector>
 #include "nmcli_exception.h"
+#include "dbus_async.h"
 #include <sdbus-c++/sdbus-c++.h>
 
 // 前向声明
@@ -37,6 +41,71 @@ public:
     bool connectToNetwork(const std::string& ssid, const std::string& password = "");
     bool connectToNetworkViaDBus(const std::string& ssid, const std::string& password = "");
     bool connectToNetworkViaIWCTL(const std::string& ssid, const std::string& password = "");
+
+    // 协程版本，多个操作可以在同一个 loop 上并发推进，销毁任务即取消等待中的调用
+    DBusTask<std::string> getAdapterObjectPathAsync(DBusEventLoop& loop);
+    DBusTask<std::string> getDeviceObjectPathAsync(DBusEventLoop& loop);
+    DBusTask<std::unique_ptr<Station>> createStationAsync(DBusEventLoop& loop);
+    // 扫描、查找网络、调用 Connect 并等待 State 变为 connected
+    DBusTask<bool> connectToNetworkAsync(DBusEventLoop& loop, const std::string& ssid);
+    // 扫描并按名称查找网络，返回其对象路径，找不到时抛出 NetworkException
+    DBusTask<std::string> findNetworkAsync(DBusEventLoop& loop, Station& station, const std::string& ssid);
+    // 调用 Connect 并等待 State 变为 connected，超时返回 false
+    DBusTask<bool> connectNetworkAsync(DBusEventLoop& loop, Station& station, const std::string& networkPath);
+    // 设置 Powered 并等待属性生效
+    DBusTask<bool> setWifiRadioStateAsync(DBusEventLoop& loop, bool enabled);
+
+    // 一次开启无线电的各阶段时间点（radio wifi on --until-ready）
+    struct RadioPowerUp {
+        std::chrono::steady_clock::time_point start;   // 设置 Powered 之前
+        std::chrono::steady_clock::time_point powered; // Adapter.Powered 变为 true
+        std::chrono::steady_clock::time_point station; // 适配器下出现 Station 对象
+        std::chrono::steady_clock::time_point ready;   // Station.State 已知
+        std::string device;                            // 网卡名称
+        std::string state;                             // 此时的 Station.State
+    };
+    // 开启无线电并等待 Station 可用（对象出现且 State 已知），超时返回 std::nullopt；默认最多等待 10 秒
+    DBusTask<std::optional<RadioPowerUp>> powerUpWifiAsync(DBusEventLoop& loop);
+
+    // 扫描结果中可以连接的已知网络
+    struct KnownCandidate {
+        std::string network_path;
+        std::string ssid;
+        std::string security;
+        int signal;                 // 信号强度，单位为dBm*100
+        std::string last_connected; // ISO 8601 格式，从未连接过为空
+    };
+
+    // 一次自动重连的结果
+    struct ReconnectEvent {
+        std::string ssid;
+        std::chrono::milliseconds elapsed; // 从断开到重新连接完成
+        int attempts;                      // 调用 Connect 的次数
+    };
+
+    // 已保存的网络（KnownNetwork 对象）
+    struct KnownNetwork {
+        std::string path;
+        std::string name;
+        std::string type;
+        std::string last_connected; // ISO 8601 格式，从未连接过为空
+    };
+
+    // 一次 GetManagedObjects 列出所有已知网络
+    DBusTask<std::vector<KnownNetwork>> listKnownNetworksAsync(DBusEventLoop& loop);
+    // 调用 KnownNetwork.Forget，成功返回空字符串，D-Bus 错误返回错误信息
+    DBusTask<std::string> forgetKnownNetworkAsync(DBusEventLoop& loop, std::string path);
+
+    // 当前扫描结果与 KnownNetworks 的交集，按信号强度和最近连接时间排序
+    DBusTask<std::vector<KnownCandidate>> getKnownCandidatesAsync(DBusEventLoop& loop, Station& station);
+    // 依次尝试候选网络直到连接成功，返回连接上的网络名称，全部失败返回空字符串
+    DBusTask<std::string> connectBestAsync(DBusEventLoop& loop, Station& station, int* attempts = nullptr);
+    // 每次断开后立即重连到最佳的已知网络，并报告从断开到连接完成的耗时；启动时未连接的那次连接不报告。
+    // D-Bus 错误经 diag() 报告后重试，只有 --wait 预算耗尽（TimeoutException）才结束
+    DBusTask<void> watchAndReconnectAsync(
+        DBusEventLoop& loop, Station& station, std::function<void(const ReconnectEvent&)> on_reconnect);
+
+    sdbus::IConnection& connection() { return *connection_; }
     
 private:
     // Private implementation details
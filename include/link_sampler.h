@@ -0,0 +1,69 @@
+#ifndef LINK_SAMPLER_H
+#define LINK_SAMPLER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include "instrumentation.h"
+#include "netlink_exchange.h"
+#include "nl80211_client.h"
+
+struct nl_msg;
+
+/**
+ * 基于 NL80211_CMD_GET_STATION 的高频链路质量采样器
+ *
+ * 请求消息和接收缓冲区在构造时一次性分配，之后每次采样只有一次 send 和若干次 recv，
+ * 不在堆上分配内存，避免采样本身影响被测量的链路。
+ */
+class LinkSampler {
+  public:
+    // 一次采样的结果，固定大小且没有隐式填充，可直接作为二进制记录写出（--binary）
+    struct Sample {
+        uint64_t timestamp_ns; // CLOCK_MONOTONIC 时间戳
+        uint8_t bssid[6];      // 当前关联的AP
+        int8_t signal;         // 信号强度，单位为dBm
+        int8_t signal_avg;     // 平均信号强度，单位为dBm
+        uint32_t tx_bitrate;   // 发送速率，单位为100kbit/s
+        uint32_t rx_bitrate;   // 接收速率，单位为100kbit/s
+        uint32_t tx_retries;   // 累计重传次数
+        uint32_t tx_failed;    // 累计发送失败次数
+        uint32_t beacon_loss;  // 累计 Beacon 丢失次数
+        uint32_t reserved;     // 显式补齐到 8 字节对齐，总是 0
+    };
+    static_assert(sizeof(Sample) == 40, "Sample is written as a fixed-size binary record");
+
+    // 采样器自身的开销统计
+    struct Overhead {
+        uint64_t samples = 0;
+        uint64_t total_ns = 0; // 所有采样耗时之和
+        uint64_t max_ns = 0;   // 单次采样最大耗时
+    };
+
+    explicit LinkSampler(const std::string &ifname);
+    ~LinkSampler();
+
+    // 禁止拷贝构造和赋值
+    LinkSampler(const LinkSampler &) = delete;
+    LinkSampler &operator=(const LinkSampler &) = delete;
+
+    // 采样一次，未关联时返回false
+    bool sample(Sample &out);
+
+    const Overhead &overhead() const { return overhead_; }
+
+  private:
+    struct MsgDeleter {
+        void operator()(struct nl_msg *msg) const;
+    };
+
+    std::string ifname_;
+    Nl80211Client client_;
+    std::unique_ptr<struct nl_msg, MsgDeleter> request_;
+    NetlinkExchange exchange_;
+    Overhead overhead_;
+    LatencyHistogram &latency_; // 构造时查找一次，采样时不再访问注册表
+};
+
+#endif // LINK_SAMPLER_H
@@ -0,0 +1,73 @@
+#ifndef MEM_STATS_H
+#define MEM_STATS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * 堆分配统计（--mem-stats）
+ *
+ * 全局 operator new/delete 的替换实现（mem_hooks.cpp，只链接进 nmcli-alt 和基准测试，不进入库）
+ * 在启用后把每次分配和释放计入这里：次数、字节数、当前存活字节和峰值。字节数按 malloc_usable_size 计，
+ * 包含分配器的取整，分配和释放两侧口径一致。
+ *
+ * 分配同时计入当前线程所在的阶段。阶段与延迟统计使用相同的标签：每个 LatencySpan 都是一个阶段
+ * （"dbus GetManagedObjects"、"netlink RTM_GETLINK"），main 把整条命令作为最外层阶段（"command connection show"）。
+ * 阶段本身的计数不含嵌套在其中的阶段；最外层阶段另有包含全部嵌套阶段的合计，即整条命令的分配。
+ * 钩子中不能分配内存，所以阶段表是定长数组，超出容量的阶段合并到 "other"。
+ */
+class MemStats {
+  public:
+    struct Totals {
+        uint64_t allocations = 0;
+        uint64_t frees = 0;
+        uint64_t bytes = 0; // 累计分配
+        uint64_t live = 0;  // 当前存活
+        uint64_t peak = 0;  // 存活字节的峰值
+    };
+
+    struct Phase {
+        std::string label;
+        uint64_t allocations; // 不含嵌套阶段
+        uint64_t bytes;
+        uint64_t inclusive_allocations; // 作为最外层阶段时含嵌套阶段的合计，从未作为最外层时为 0
+        uint64_t inclusive_bytes;
+    };
+
+    static void enable();
+    static bool enabled();
+
+    static Totals totals();
+    // 从当前存活字节重新开始记录峰值，基准测试用来单独测量每个用例
+    static void resetPeak();
+    // 有分配的阶段，按字节数（最外层阶段按含嵌套的字节数）降序
+    static std::vector<Phase> phases();
+
+    // 由 operator new/delete 钩子调用，不分配内存
+    static void recordAllocation(size_t bytes) noexcept;
+    static void recordFree(size_t bytes) noexcept;
+
+    // 进入 "kind operation" 阶段，返回之前的阶段，离开时交给 leavePhase；未启用时不做任何事
+    static int enterPhase(const char *kind, const std::string &operation) noexcept;
+    static void leavePhase(int previous) noexcept;
+};
+
+/**
+ * 阶段的 RAII 区间
+ */
+class MemPhase {
+  public:
+    MemPhase(const char *kind, const std::string &operation) : previous_(MemStats::enterPhase(kind, operation)) {}
+    ~MemPhase() { MemStats::leavePhase(previous_); }
+
+    // 禁止拷贝构造和赋值
+    MemPhase(const MemPhase &) = delete;
+    MemPhase &operator=(const MemPhase &) = delete;
+
+  private:
+    int previous_;
+};
+
+#endif // MEM_STATS_H
@@ -0,0 +1,33 @@
+#ifndef METRICS_EXPORTER_H
+#define METRICS_EXPORTER_H
+
+#include <cstdint>
+#include <string>
+#include "nmcli_exception.h"
+#include "state_snapshot.h"
+
+/**
+ * node_exporter textfile collector 的输出
+ *
+ * 把一次状态快照和进程内的调用延迟直方图渲染为 Prometheus 文本格式，
+ * 先写入同目录的临时文件再 rename，collector 不会读到写了一半的文件。
+ */
+class MetricsExporter {
+  public:
+    explicit MetricsExporter(std::string path);
+
+    // 渲染并原子替换目标文件，失败时抛出 NmcliException
+    void write(const StateSnapshot &snapshot);
+
+    // Prometheus 文本格式
+    std::string render(const StateSnapshot &snapshot) const;
+
+    uint64_t writes() const { return writes_; }
+
+  private:
+    std::string path_;
+    std::string tmp_path_;
+    uint64_t writes_ = 0;
+};
+
+#endif // METRICS_EXPORTER_H
@@ -0,0 +1,63 @@
+#ifndef NETLINK_EXCHANGE_H
+#define NETLINK_EXCHANGE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include "nmcli_exception.h"
+
+struct nlmsghdr;
+
+/**
+ * 常驻采样器在预先构造的请求上完成一次 netlink 请求/响应交换
+ *
+ * 接收缓冲区在构造时分配一次，请求每次只更新序列号，响应直接在缓冲区上交给 handler，
+ * 正常采样不做堆分配。收到 NLMSG_DONE 或 ACK 时结束，内核返回的错误和超出缓冲区的消息抛出 NetworkException。
+ * 录制时保存收到的原始数据（--record），回放时不访问内核，把录制的数据依次交给 handler。
+ * LinkSampler（nl80211）和 LinkStatsSampler（rtnetlink）共用。
+ */
+class NetlinkExchange {
+  public:
+    using Callback = void (*)(void *context, struct nlmsghdr *nlh);
+
+    // description 用于错误信息和截止时间，例如 "station info"
+    NetlinkExchange(size_t buffer_size, std::string description);
+    ~NetlinkExchange();
+
+    // 禁止拷贝构造和赋值
+    NetlinkExchange(const NetlinkExchange &) = delete;
+    NetlinkExchange &operator=(const NetlinkExchange &) = delete;
+
+    /**
+     * 在 fd 上发送 request，把响应中的每条消息交给 handler(nlh)
+     *
+     * operation 和 key 是探针、延迟统计和追踪文件中的名称。返回交换耗时（纳秒），回放时为 0。
+     */
+    template <typename Handler>
+    uint64_t run(int fd, struct nlmsghdr *request, const char *operation, const std::string &key, Handler &&handler) {
+        using Target = std::remove_reference_t<Handler>;
+        return run(
+            fd, request, operation, key,
+            [](void *context, struct nlmsghdr *nlh) { (*static_cast<Target *>(context))(nlh); },
+            const_cast<void *>(static_cast<const void *>(&handler))
+        );
+    }
+
+    uint64_t run(
+        int fd, struct nlmsghdr *request, const char *operation, const std::string &key, Callback callback,
+        void *context
+    );
+
+  private:
+    // 解析缓冲区中的 size 字节，收到 DONE 或 ACK 时返回 true
+    bool parseChunk(int size, bool check_seq, Callback callback, void *context);
+
+    std::unique_ptr<unsigned char[]> buffer_;
+    size_t buffer_size_;
+    std::string description_;
+    uint32_t seq_;
+};
+
+#endif // NETLINK_EXCHANGE_H
@@ -0,0 +1,33 @@
+#ifndef NETNS_H
+#define NETNS_H
+
+#include <map>
+#include <string>
+#include <vector>
+#include "rtnl_dump.h"
+
+/**
+ * 读取其他网络命名空间中的链路和路由（--netns）
+ *
+ * rtnetlink socket 属于创建它时所在的命名空间，因此工作线程先 setns 进入目标命名空间再打开 socket，
+ * 之后的 dump 与调用线程无关。多个命名空间由一组线程并行读取，总耗时接近几次串行 dump，
+ * 而不是与命名空间数量成正比。进入命名空间需要 CAP_SYS_ADMIN。
+ */
+
+constexpr const char *NETNS_RUN_DIR = "/run/netns";
+
+// 一个命名空间的读取结果
+struct NetnsSnapshot {
+    std::string name;
+    std::map<int, RtnlDump::LinkRecord> links; // 不含地址
+    bool has_default_route = false;
+    std::string error; // 非空表示无法进入或读取该命名空间，其余字段无意义
+};
+
+// ip netns add 创建的命名空间（NETNS_RUN_DIR 下的挂载点），按名称排序
+std::vector<std::string> listNamedNetns();
+
+// 并行读取 names 中每个命名空间的链路和路由，结果与 names 顺序相同；超时时抛出 TimeoutException
+std::vector<NetnsSnapshot> scanNetns(const std::vector<std::string> &names);
+
+#endif // NETNS_H
@@ -0,0 +1,59 @@
+#ifndef NETWORK_IMPORT_H
+#define NETWORK_IMPORT_H
+
+#include <string>
+#include <vector>
+#include "nmcli_exception.h"
+
+/**
+ * 批量导入已知网络（connection import）
+ *
+ * 从 CSV 或 JSON 读取 SSID、安全类型和密码，直接生成 iwd 的网络配置文件（iwd.network(5)）写入存储目录，
+ * 不需要逐个连接，也不要求网络在范围内。iwd 通过 inotify 监视存储目录，新文件会自动成为 KnownNetwork。
+ */
+
+constexpr const char *IWD_STORAGE_DIR = "/var/lib/iwd";
+
+struct NetworkProfile {
+    std::string ssid;
+    std::string security;   // 规范化后为 open/psk/8021x
+    std::string passphrase; // psk 的口令（8-63 个字符）或 64 位十六进制 PSK，8021x 的密码
+    std::string identity;   // 仅 8021x
+    std::string eap_method; // 仅 8021x：PEAP 或 TTLS，内层均为 MSCHAPV2
+    int line = 0;           // 输入中的行号（JSON 为第几个对象），用于报告错误
+};
+
+/**
+ * 解析 CSV 或 JSON（以 '[' 开头时按 JSON 解析）
+ *
+ * CSV 第一行是列名，至少包含 ssid，可选 security、passphrase、identity、eap，字段可以按 RFC 4180 加引号。
+ * JSON 是对象数组，键与 CSV 列名相同。安全类型接受 nmcli 和 iwd 的常见写法（wpa-psk、sae、wpa-eap 等），
+ * 省略时有密码为 psk，否则为 open。格式错误时抛出 NmcliException。
+ */
+std::vector<NetworkProfile> parseNetworkProfiles(const std::string &text);
+
+// 检查单个条目，返回错误说明，合法时为空
+std::string validateNetworkProfile(const NetworkProfile &profile);
+
+// 存储目录中的文件名：SSID 只含字母数字、空格、'-' 和 '_' 时直接使用，否则为 '=' 加十六进制编码
+std::string iwdProfileFileName(const std::string &ssid, const std::string &security);
+
+// 配置文件内容，值按 iwd 设置文件的规则转义
+std::string iwdProfileContents(const NetworkProfile &profile);
+
+struct ProfileWriteResult {
+    size_t written = 0;
+    size_t skipped = 0;                    // 已存在且未要求替换
+    std::vector<std::string> errors;       // 每个失败条目一行
+    std::vector<std::string> written_ssid; // 写入成功的 SSID，用于确认 iwd 已加载
+};
+
+/**
+ * 把配置文件写入 dir
+ *
+ * 每个文件先写入同目录的临时文件，全部写完后一次 syncfs 落盘，再逐个 rename 到最终文件名并同步目录，
+ * 既保证 iwd 不会读到写了一半的文件，又避免每个文件一次 fsync。replace 为 false 时跳过已存在的配置。
+ */
+ProfileWriteResult writeIwdProfiles(const std::string &dir, const std::vector<NetworkProfile> &profiles, bool replace);
+
+#endif // NETWORK_IMPORT_H
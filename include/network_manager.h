@@ -1,8 +1,22 @@
 #ifndef NETWORK_MANAGER_H
 #define NETWORK_MANAGER_H
 
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <optional>
 #include <string>
 #include <vector>
+#include "scan_coordinator.h"
+#include "state_snapshot.h"
+#include "station.h"
+
+struct ShmState;
+struct NetnsSnapshot;
+class ShmStateReader;
+
+// 由连接名称生成稳定的 UUID，与 connection show 输出一致
+std::string stringToUUID(const std::string &input);
 
 class NetworkManager {
   public:
@@ -12,6 +26,9 @@ class NetworkManager {
     // Command line options
     bool terse_output = false;
     std::vector<std::string> field_selection;
+    std::string backend = "iwd"; // WiFi列表后端: iwd 或 nl80211
+    std::string shm_path;        // --from-shm：非空时连通性、设备列表和无线电状态从共享内存读取
+    std::string netns;           // --netns：命名空间名称或 all，非空时连通性和设备列表读取这些命名空间
 
     // Formatting methods
     void printFormattedTable(
@@ -20,10 +37,14 @@ class NetworkManager {
 
     // Networking commands
     std::string getConnectivity();
+    // --netns 下每个命名空间一行 NETNS、CONNECTIVITY；任一命名空间无法读取时返回 false
+    bool showNetnsConnectivity();
 
     // Radio commands
-    bool setWifiRadio(bool enabled);
-    bool getWifiRadioState();
+    // until_ready 为 true 且开启时等待 Station 可用，并输出各阶段耗时
+    bool setWifiRadio(bool enabled, bool until_ready = false);
+    // 无法读取，或 --from-shm 快照中状态未知时输出错误并返回 nullopt
+    std::optional<bool> getWifiRadioState();
 
     // Device commands
     struct DeviceInfo {
@@ -32,7 +53,11 @@ class NetworkManager {
         std::string state;
     };
 
-    std::vector<DeviceInfo> listDevices();
+    // 读取失败时输出错误并返回 false
+    bool listDevices(std::vector<DeviceInfo> &devices);
+    // --netns 下并行读取各命名空间的设备，合并为带 NETNS 列的表格；任一命名空间无法读取时返回 false
+    bool listNetnsDevices();
+    bool showDevice(const std::string &ifname);
 
     // Connection commands
     struct ConnectionInfo {
@@ -42,15 +67,73 @@ class NetworkManager {
         std::string device;
     };
 
-    void showConnections();
-    void listWifiNetworks(bool rescan = false);
+    // connection show 的行（NmcliClient 共用）：设备上的连接在前，其后是未激活的已保存网络；不输出，失败时抛出异常。
+    // active_only 为 true 时只读取处于 up 状态的设备和 Station 的 ConnectedNetwork，往返次数与已知网络数量无关
+    std::vector<ConnectionInfo> collectConnections(bool active_only = false);
+    bool showConnections(bool active_only = false);
+
+    // device wifi list 的结果（NmcliClient 共用）
+    struct WifiListing {
+        ScanSnapshot networks;
+        std::vector<uint32_t> order;  // 显示顺序：信号强到弱，有 limit 时只含前 limit 个快照下标
+        std::vector<uint8_t> quality; // 按快照下标的信号质量 0-100
+        bool scan_timed_out;          // 扫描超时，列出的是之前的结果
+    };
+    // 按 backend 取得扫描结果并排序，不输出，失败时抛出异常；rescan 为 Auto 时，最近一次完成的扫描不超过
+    // max_age 就不再扫描（nl80211 后端忽略 rescan）
+    WifiListing collectWifiNetworks(
+        RescanPolicy rescan = RescanPolicy::No, size_t limit = 0, std::chrono::seconds max_age = std::chrono::seconds(30)
+    );
+    bool listWifiNetworks(
+        RescanPolicy rescan = RescanPolicy::No, size_t limit = 0, std::chrono::seconds max_age = std::chrono::seconds(30)
+    );
+    bool sampleWifiLink(const std::string &ifname, int interval_ms, int count, bool binary);
+    // 每 interval_ms 输出一帧各接口的收发速率和错误数，count 为 0 时直到被中断
+    bool monitorDeviceStats(int interval_ms, int count);
+    // 常驻进程，状态变化时以 Prometheus 文本格式原子重写 path；信号强度每 interval_ms 刷新一次
+    bool exportMetrics(const std::string &path, int interval_ms);
+    // 常驻进程，状态变化时原地更新 path 处的共享内存快照（布局见 state_shm.h）
+    bool publishState(const std::string &path, int interval_ms);
     int dbmToQualitySegmented(int rssi_dbm);
-    bool activateConnection(const std::string &ssid);
+    // until_ready 为 true 时等待关联、获得地址和默认路由，并输出各阶段耗时（connection up --until-ready）
+    bool activateConnection(const std::string &ssid, bool until_ready = false);
+    // 连接扫描结果中最佳的已知网络；watch 为 true 时每次断开后自动重连并报告耗时，直到被中断
+    bool activateBestConnection(bool watch);
     bool deactivateConnection(const std::string &ssid);
-    bool deleteConnection(const std::string &ssid);
+    // 删除名称等于或匹配任一 shell 通配符的已知网络（patterns 为空时匹配全部），older_than 限定最近连接时间；
+    // 目标由一次枚举确定，Forget 调用同时发出并逐个报告结果
+    bool deleteConnections(const std::vector<std::string> &patterns, std::optional<std::chrono::seconds> older_than);
+    // 从 CSV/JSON（file 为 "-" 时读标准输入）生成 iwd 配置文件写入 storage_dir（为空时是 iwd 的存储目录），
+    // 写入 iwd 的存储目录时确认 iwd 已加载为 KnownNetwork
+    bool importConnections(const std::string &file, const std::string &storage_dir, bool replace);
+
+    // 常驻事件循环：rtnetlink 和 iwd 的变化合并后采集快照交给 sink，信号强度每 interval_ms 刷新一次；
+    // 每次唤醒后检查 stop，返回 true 时退出。wake_fd 可读时唤醒循环并重新采集（例如另一个线程写入的 eventfd），
+    // 不会安装信号处理函数
+    void watchState(
+        int interval_ms, const std::function<void(const StateSnapshot &)> &sink, const std::function<bool()> &stop,
+        int wake_fd = -1
+    );
 
   private:
-    // Private implementation details
+    // 通过 iwd 的 D-Bus 接口获取（按策略先扫描）排序后的网络列表，扫描与其他进程协调
+    ScanSnapshot getIwdNetworks(RescanPolicy rescan, std::chrono::seconds max_age, bool &scan_timed_out);
+    // 内核缓存的 BSS 表（--backend nl80211），不经过 iwd
+    ScanSnapshot getNl80211Networks();
+
+    // 通过事件等待 Station 连接、RTM_NEWADDR 和默认路由，输出各阶段耗时
+    bool activateConnectionAndWait(const std::string &ssid);
+
+    // 当前 iwd 连接的网络名称，未连接或 iwd 不可用时返回空字符串
+    std::string getIwdConnectionName();
+
+    // 从 shm_path 读取一致的快照，失败或快照过期（发布端已退出）时输出错误并返回 false
+    bool readSharedState(ShmState &state);
+
+    // 读取 netns 指定的命名空间，无法读取的命名空间输出到标准错误
+    std::vector<NetnsSnapshot> scanSelectedNetns(bool &complete);
+
+    std::unique_ptr<ShmStateReader> shm_reader_;
 };
 
 #endif // NETWORK_MANAGER_H
@@ -0,0 +1,65 @@
+#ifndef NL80211_CLIENT_H
+#define NL80211_CLIENT_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "nmcli_exception.h"
+#include "station.h"
+
+struct nl_sock;
+
+/**
+ * 直接通过 nl80211 (generic netlink) 读取内核的无线状态
+ *
+ * 只做只读查询，不依赖 iwd 的 D-Bus 对象，因此在 iwd 忙碌或重启时仍然可用。
+ */
+class Nl80211Client {
+  public:
+    // nl80211 管理的无线接口
+    struct InterfaceInfo {
+        int ifindex;
+        std::string name;
+    };
+
+    // 内核 BSS 表中的一条记录
+    struct BssInfo {
+        std::string bssid;
+        std::string ssid;
+        std::string security; // 与 iwd Network.Type 一致: open/wep/psk/8021x
+        uint32_t frequency;   // 频率，单位为MHz
+        int signal_mbm;       // 信号强度，单位为dBm*100
+        bool associated;      // 是否为当前关联的BSS
+    };
+
+    Nl80211Client();
+    ~Nl80211Client();
+
+    // 禁止拷贝构造和赋值
+    Nl80211Client(const Nl80211Client &) = delete;
+    Nl80211Client &operator=(const Nl80211Client &) = delete;
+
+    // 列出所有 station 模式的无线接口
+    std::vector<InterfaceInfo> listInterfaces();
+
+    // 一次 NL80211_CMD_GET_SCAN dump 读取内核缓存的 BSS 表
+    std::vector<BssInfo> dumpScan(int ifindex);
+
+    // 按 SSID 和安全类型合并 BSS，得到与 iwd GetOrderedNetworks 相同形式的网络列表
+    std::vector<Station::NetworkInfo> getNetworks(int ifindex);
+
+    // 供需要自行构造消息的调用者（如高频采样）复用同一个 genl socket
+    struct nl_sock *socket() const { return sock_.get(); }
+    int familyId() const { return family_id_; }
+
+  private:
+    struct SocketDeleter {
+        void operator()(struct nl_sock *sock) const;
+    };
+
+    std::unique_ptr<struct nl_sock, SocketDeleter> sock_;
+    int family_id_;
+};
+
+#endif // NL80211_CLIENT_H
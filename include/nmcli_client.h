@@ -0,0 +1,94 @@
+#ifndef NMCLI_CLIENT_H
+#define NMCLI_CLIENT_H
+
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+#include "nmcli_exception.h"
+#include "state_snapshot.h"
+
+/**
+ * 可嵌入的客户端接口（libnmcli-alt）
+ *
+ * 供状态栏、托盘程序等直接链接使用，省去每次查询启动 nmcli-alt 进程和解析文本输出的开销。
+ * 客户端持有一条系统总线连接，查询只需一次 GetManagedObjects 或 rtnetlink dump。
+ *
+ * - 不向 stdout/stderr 输出任何内容，结果以结构体返回，失败时抛出 NmcliException 的子类
+ * - 所有方法可以从任意线程调用，同步查询在内部串行化
+ * - *Async 版本在客户端的查询线程上依次执行同步查询，通过 std::future 取得结果或异常；
+ *   客户端销毁时正在执行的查询先完成，尚未开始的以 std::future_error（broken_promise）结束
+ * - onStateChanged 注册的回调在后台监视线程上调用，参数与 state publish 发布的快照相同
+ *
+ * 本头文件不依赖 sdbus-c++ 和 libnl。
+ */
+class NmcliClient {
+  public:
+    struct Device {
+        std::string name;
+        std::string type;  // ethernet/wifi/loopback 等
+        std::string state; // up/down/dormant 等
+    };
+
+    struct WifiNetwork {
+        std::string ssid;
+        std::string security; // open/psk/8021x
+        int signal_dbm;
+        int quality; // 0-100
+        bool in_use;
+        bool known; // 已保存过凭据
+    };
+
+    struct Connection {
+        std::string name;
+        std::string uuid;
+        std::string type;   // 与 connection show 相同：ethernet/wifi/loopback
+        std::string device; // 未激活时为空
+    };
+
+    using StateCallback = std::function<void(const StateSnapshot &)>;
+
+    // 连接系统总线，失败时抛出 DBusException
+    NmcliClient();
+    // 注销所有回调并等待监视线程退出
+    ~NmcliClient();
+
+    // 禁止拷贝构造和赋值
+    NmcliClient(const NmcliClient &) = delete;
+    NmcliClient &operator=(const NmcliClient &) = delete;
+
+    // full/none/unknown
+    std::string connectivity();
+    std::vector<Device> devices();
+    // iwd 不可用或没有适配器时抛出异常
+    bool wifiRadioEnabled();
+    // 按信号强度降序；rescan 为 true 时先扫描并等待结果
+    std::vector<WifiNetwork> wifiNetworks(bool rescan = false);
+    // active_only 为 false 时同时列出所有已保存的网络
+    std::vector<Connection> connections(bool active_only = true);
+
+    std::future<std::string> connectivityAsync();
+    std::future<std::vector<Device>> devicesAsync();
+    std::future<bool> wifiRadioEnabledAsync();
+    std::future<std::vector<WifiNetwork>> wifiNetworksAsync(bool rescan = false);
+    std::future<std::vector<Connection>> connectionsAsync(bool active_only = true);
+
+    /**
+     * 注册状态变化回调，返回用于注销的标识
+     *
+     * 第一个回调注册时启动监视线程。每次注册后所有回调都会收到一次当前状态，之后在链路、地址、路由或
+     * iwd 状态变化时调用，信号强度每 interval_ms 刷新一次（以启动监视时的参数为准）。
+     * 回调不应阻塞，抛出的异常会被忽略；不能在回调中销毁客户端。
+     */
+    uint64_t onStateChanged(StateCallback callback, int interval_ms = 5000);
+    // 注销回调，可以在回调中调用；没有回调时监视线程释放 rtnetlink 订阅和总线连接并等待下一次注册
+    void removeStateCallback(uint64_t id);
+
+  private:
+    struct Impl;
+    std::unique_ptr<Impl> impl_;
+};
+
+#endif // NMCLI_CLIENT_H
@@ -44,4 +44,12 @@ public:
     explicit ConnectionException(const std::string& message) : NmcliException(message) {}
 };
 
+/**
+ * 超时异常，命令的 --wait 时间预算耗尽
+ */
+class TimeoutException : public NmcliException {
+public:
+    explicit TimeoutException(const std::string& message) : NmcliException(message) {}
+};
+
 #endif // NMCLI_EXCEPTION_H
\ No newline at end of file
@@ -0,0 +1,107 @@
+#ifndef PROBES_H
+#define PROBES_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+
+/**
+ * 热路径追踪：USDT 探针和 Chrome trace-event 输出（--trace）
+ *
+ * 每个区间开始和结束时各触发一个 provider 为 nmcli_alt 的 USDT 探针，bpftrace 和 perf 无需重新编译即可附加：
+ *
+ *     bpftrace -e 'usdt:/usr/bin/nmcli-alt:nmcli_alt:dbus__call__end { @[str(arg0)] = hist(arg2); }'
+ *
+ * 开始探针的参数为 (name, detail)，结束探针为 (name, detail, elapsed_ns, result)。探针在未附加时只是一条 nop；
+ * 构建时没有 <sys/sdt.h> 或关闭了 NMCLI_ALT_USDT 时为空操作。
+ * --trace 启用后，同样的区间还按 Chrome trace-event JSON 写入文件，可以在 Perfetto 中查看。
+ */
+enum class ProbeKind {
+    DBus,    // dbus__call__start / dbus__call__end：方法名、对象路径，result 为 1 表示调用失败，-1 表示等待中被取消
+    Netlink, // netlink__send / netlink__receive：消息类型，result 为返回值（负数为错误码）
+    Process, // process__spawn / process__exit：命令，result 为退出码
+    Scan,    // scan__start / scan__complete：设备对象路径，result 非 0 表示超时或失败
+    Render,  // render__start / render__end：输出名称，result 为行数
+};
+
+class Probes {
+  public:
+    using Clock = std::chrono::steady_clock;
+
+    static void begin(ProbeKind kind, const char *name, const char *detail);
+    static void end(ProbeKind kind, const char *name, const char *detail, Clock::time_point start, int64_t result);
+};
+
+/**
+ * 区间的 RAII 封装，构造时触发开始探针，析构时触发结束探针
+ *
+ * name 和 detail 不复制，调用者保证它们在区间结束前有效。
+ */
+class ProbeSpan {
+  public:
+    ProbeSpan(ProbeKind kind, const char *name, const char *detail = "")
+        : kind_(kind), name_(name), detail_(detail), start_(Probes::Clock::now()) {
+        Probes::begin(kind_, name_, detail_);
+    }
+    ~ProbeSpan() { Probes::end(kind_, name_, detail_, start_, result_); }
+
+    // 禁止拷贝构造和赋值
+    ProbeSpan(const ProbeSpan &) = delete;
+    ProbeSpan &operator=(const ProbeSpan &) = delete;
+
+    void setResult(int64_t result) { result_ = result; }
+
+  private:
+    ProbeKind kind_;
+    const char *name_;
+    const char *detail_;
+    Probes::Clock::time_point start_;
+    int64_t result_ = 0;
+};
+
+/**
+ * --trace 的区间输出，以 Chrome trace-event JSON 边记录边写入文件
+ *
+ * 区间格式化后先放进一块有上限的缓冲区，满了就写入文件，常驻命令（device status --interval、monitor）
+ * 长时间运行时内存占用不随区间数量增长。可以在多个线程中并发记录（--netns 的工作线程），
+ * 每个线程在 Perfetto 中是一条轨道。
+ */
+class ChromeTrace {
+  public:
+    static ChromeTrace &global();
+
+    ~ChromeTrace();
+
+    // 创建文件并写出 JSON 开头，失败时在 stderr 报告并返回 false
+    bool enable(const std::string &path);
+    bool enabled() const { return enabled_.load(std::memory_order_relaxed); }
+
+    // 记录一个完整区间，category 为 dbus、netlink、process、scan、render 或 command
+    void add(
+        const char *category, const char *name, const char *detail, Probes::Clock::time_point start,
+        Probes::Clock::duration elapsed, int64_t result
+    );
+
+    // 写出剩余区间和 JSON 结尾并关闭文件，之前或这次写入失败时在 stderr 报告并返回 false
+    bool write();
+
+  private:
+    ChromeTrace() = default;
+
+    // 调用者持有 mutex_
+    void flushLocked();
+
+    std::atomic<bool> enabled_{false};
+    std::string path_;
+    Probes::Clock::time_point origin_;
+    long pid_ = 0;
+    std::mutex mutex_;
+    FILE *file_ = nullptr;
+    std::string pending_; // 尚未写入文件的区间
+    int error_ = 0;       // 第一次写入失败的 errno
+};
+
+#endif // PROBES_H
@@ -11,6 +11,7 @@ public:
      * @param command 要执行的命令
      * @param args 命令参数
      * @return 命令的退出码，-1表示执行失败
+     * @throws TimeoutException 超过 --wait 截止时间时终止子进程并抛出
      */
     static int executeCommand(const std::string& command, const std::vector<std::string>& args);
 };
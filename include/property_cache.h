@@ -0,0 +1,78 @@
+#ifndef PROPERTY_CACHE_H
+#define PROPERTY_CACHE_H
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <tuple>
+
+namespace sdbus {
+class IConnection;
+}
+
+/**
+ * 跨进程的 iwd 属性缓存（--cache）
+ *
+ * 保存适配器/设备路径和网络对象的 Name、Type 等在 iwd 进程生命周期内不变的属性，
+ * 文件位于 $XDG_RUNTIME_DIR/nmcli-alt/iwd-cache，格式与追踪文件相同（小端序、带长度前缀），
+ * 可以直接 mmap 解析。文件记录写入时 iwd 的唯一总线名和代数：每次运行第一次查询时用 GetNameOwner
+ * 确认 iwd 没有重启，否则清空；收到 NameOwnerChanged 或调用因对象不存在而失败时也会清空并递增代数。
+ */
+class PropertyCache {
+  public:
+    // 拓扑条目使用的伪接口名，Adapter 挂在 /net/connman/iwd 下，Device 挂在适配器路径下
+    static constexpr const char *TOPOLOGY = "nmcli-alt.Topology";
+
+    static PropertyCache &global();
+
+    // 禁止拷贝构造和赋值
+    PropertyCache(const PropertyCache &) = delete;
+    PropertyCache &operator=(const PropertyCache &) = delete;
+
+    // $XDG_RUNTIME_DIR/nmcli-alt/iwd-cache，未设置 XDG_RUNTIME_DIR 时返回空字符串
+    static std::string defaultPath();
+
+    // 启用缓存并加载 path，文件不存在或无法解析时从空缓存开始
+    void enable(const std::string &path);
+    bool enabled() const { return !path_.empty(); }
+
+    // 已启用且属性在 iwd 生命周期内不变
+    bool covers(const std::string &interface, const std::string &property) const;
+
+    // 未命中或 iwd 不可用时返回 nullptr
+    const std::string *lookup(
+        sdbus::IConnection &connection, const std::string &path, const std::string &interface,
+        const std::string &property
+    );
+    void store(const std::string &path, const std::string &interface, const std::string &property, std::string value);
+
+    // iwd 重启时调用：清空条目、递增代数，下一次查询重新确认唯一总线名
+    void invalidate();
+
+    // 对象、接口不存在的错误说明缓存的拓扑已经过时
+    void noteError(const std::string &error_name);
+
+    // 有变化时写回文件（临时文件加 rename），写入失败不影响命令本身
+    void flush();
+
+    uint64_t generation() const { return generation_; }
+
+  private:
+    PropertyCache() = default;
+
+    // 本次运行第一次查询时确认 iwd 的唯一总线名与缓存一致
+    bool validate(sdbus::IConnection &connection);
+    void load();
+
+    using Key = std::tuple<std::string, std::string, std::string>;
+
+    std::string path_;
+    std::string owner_; // 条目所属 iwd 进程的唯一总线名
+    uint64_t generation_ = 0;
+    bool validated_ = false;
+    bool usable_ = false;
+    bool dirty_ = false;
+    std::map<Key, std::string> entries_;
+};
+
+#endif // PROPERTY_CACHE_H
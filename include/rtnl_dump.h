@@ -0,0 +1,75 @@
+#ifndef RTNL_DUMP_H
+#define RTNL_DUMP_H
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include "nmcli_exception.h"
+
+struct nl_sock;
+
+/**
+ * 在一个 rtnetlink socket 上依次执行 link/addr/route dump，并按 ifindex 合并结果
+ *
+ * 直接解析原始 netlink 消息，不构建 libnl 的对象缓存。
+ */
+class RtnlDump {
+  public:
+    struct AddressInfo {
+        int family; // AF_INET 或 AF_INET6
+        std::string address;
+        int prefixlen;
+        uint8_t scope;  // RT_SCOPE_*
+        uint32_t flags; // IFA_F_*
+    };
+
+    struct LinkRecord {
+        int ifindex = 0;
+        std::string name;
+        std::string type; // ethernet/wifi/loopback 或 IFLA_INFO_KIND
+        std::string hwaddr;
+        uint32_t mtu = 0;
+        uint8_t operstate = 0;
+        uint32_t flags = 0; // IFF_* 标志
+        std::vector<AddressInfo> addresses;
+        std::string ipv4_gateway;
+        std::string ipv6_gateway;
+    };
+
+    RtnlDump();
+    ~RtnlDump();
+
+    // 禁止拷贝构造和赋值
+    RtnlDump(const RtnlDump &) = delete;
+    RtnlDump &operator=(const RtnlDump &) = delete;
+
+    // 执行 RTM_GETLINK、RTM_GETADDR、RTM_GETROUTE 三个 dump，返回按 ifindex 排序的结果
+    // with_addresses 为 false 时跳过地址 dump，addresses 为空
+    std::map<int, LinkRecord> collect(bool with_addresses = true);
+
+    // 最近一次 collect 时主路由表中是否有默认路由
+    bool hasDefaultRoute() const { return has_default_route_; }
+
+    // 由 IFLA_INFO_KIND、ARPHRD_* 和接口名推断设备类型（ethernet/wifi/loopback 或 kind 本身）
+    static std::string linkType(const char *kind, unsigned short arptype, const std::string &name);
+
+    // 地址能否承载外部流量：IPv4 地址，或已完成 DAD 的全局 IPv6 地址（RtnlMonitor 的 AddressAdded 使用同一规则）
+    static bool usableAddress(int family, uint8_t scope, uint32_t flags);
+
+    // 将 IF_OPER_* 转换为可读字符串
+    static std::string operstateToString(uint8_t operstate);
+
+  private:
+    struct SocketDeleter {
+        void operator()(struct nl_sock *sock) const;
+    };
+
+    void dump(int type, int family, int (*handler)(struct nl_msg *, void *), void *arg);
+
+    std::unique_ptr<struct nl_sock, SocketDeleter> sock_;
+    bool has_default_route_ = false;
+};
+
+#endif // RTNL_DUMP_H
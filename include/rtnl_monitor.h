@@ -0,0 +1,58 @@
+#ifndef RTNL_MONITOR_H
+#define RTNL_MONITOR_H
+
+#include <functional>
+#include <memory>
+#include <string>
+#include "nmcli_exception.h"
+
+struct nl_sock;
+
+/**
+ * 监听一个接口上的链路、地址和默认路由变化（rtnetlink 组播通知）
+ *
+ * ifindex 为 0 时监听所有接口。socket 为非阻塞，可以把 fd() 交给事件循环，可读时调用 drain()。
+ * 订阅在构造时完成，之后发生的变化都会排队在 socket 中，不会丢失。
+ * 回放（--replay）时不访问内核，fd() 返回 -1，不产生任何事件。
+ */
+class RtnlMonitor {
+  public:
+    enum class EventType {
+        AddressAdded,      // 可用的地址：IPv4，或已完成 DAD 的全局 IPv6 地址
+        DefaultRouteAdded, // 主路由表中经过该接口的默认路由
+        AddressRemoved,      // 地址被删除
+        DefaultRouteRemoved, // 默认路由被删除
+        LinkChanged,         // 链路新增、删除或状态（operstate、flags）变化，detail 为接口名
+        Overflow,          // socket 缓冲区溢出，可能丢失了通知，调用者需要重新 dump
+    };
+
+    struct Event {
+        EventType type;
+        int ifindex;
+        int family;         // AF_INET 或 AF_INET6，链路事件为 AF_UNSPEC
+        std::string detail; // 地址、网关或接口名
+    };
+
+    explicit RtnlMonitor(int ifindex);
+    ~RtnlMonitor();
+
+    // 禁止拷贝构造和赋值
+    RtnlMonitor(const RtnlMonitor &) = delete;
+    RtnlMonitor &operator=(const RtnlMonitor &) = delete;
+
+    int fd() const;
+
+    // 处理所有已到达的通知，不阻塞
+    void drain(const std::function<void(const Event &)> &callback);
+
+  private:
+    struct SocketDeleter {
+        void operator()(struct nl_sock *sock) const;
+    };
+
+    int ifindex_;
+    std::unique_ptr<struct nl_sock, SocketDeleter> sock_;
+    std::unique_ptr<char[]> recv_buf_;
+};
+
+#endif // RTNL_MONITOR_H
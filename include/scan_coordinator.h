@@ -0,0 +1,76 @@
+#ifndef SCAN_COORDINATOR_H
+#define SCAN_COORDINATOR_H
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+
+// device wifi list 的 --rescan 取值
+enum class RescanPolicy {
+    No,   // 只读取 iwd 已有的结果
+    Yes,  // 总是扫描；其他进程正在扫描时等待它完成
+    Auto, // 最近一次完成的扫描不超过 --max-age 时直接使用已有结果
+};
+
+/**
+ * 跨进程的扫描协调
+ *
+ * 同一台机器上的多个状态栏插件和脚本各自请求扫描时，iwd 会把 Scan 排队依次执行，
+ * 每个请求方都要等前面所有扫描结束，无线电也反复离开当前信道。
+ * 扫描方在状态文件（默认 /run/nmcli-alt/scan）上持有 flock 排他锁直到扫描结束，并记录完成时间：
+ * 锁被占用时后来者不再发起扫描，而是通过 iwd 的 Scanning 属性等待那次扫描结束，直接读取同一次扫描的结果；
+ * Auto 策略下完成时间足够新则完全跳过扫描。进程退出时 flock 自动释放，不会留下失效的锁。
+ * iwd 自己发起的周期扫描同样记录：加锁时 iwd 正在扫描则加入它，常驻的 StateWatcher 在 Scanning 回到 false 时记录。
+ *
+ * 状态文件只属于一个用户（0600，属主必须是当前有效用户），其他用户无法打开它来占住锁、拖住别人的扫描；
+ * 普通用户因此使用各自运行时目录下的文件，只与同一用户的进程协调。
+ */
+class ScanCoordinator {
+  public:
+    using Clock = std::chrono::steady_clock;
+
+    // /run/nmcli-alt/scan，无法创建时改用 $XDG_RUNTIME_DIR/nmcli-alt/scan；都不可用时不协调
+    ScanCoordinator();
+    explicit ScanCoordinator(const std::string &path);
+    ~ScanCoordinator();
+
+    // 禁止拷贝构造和赋值
+    ScanCoordinator(const ScanCoordinator &) = delete;
+    ScanCoordinator &operator=(const ScanCoordinator &) = delete;
+
+    // 扫描所需的 iwd 操作，由调用方在自己的事件循环上实现
+    struct Scanner {
+        std::function<bool()> scanning;                  // iwd 当前是否正在扫描（Station.Scanning）
+        std::function<bool(bool, Clock::duration)> wait; // 等待 Scanning 变为给定值，超时返回 false
+        std::function<bool()> scan;                      // 发起扫描并等待结束，超时返回 false
+    };
+
+    bool valid() const { return fd_ >= 0; }
+    const std::string &path() const { return path_; }
+
+    /**
+     * 按策略获取足够新的扫描结果
+     *
+     * 需要扫描时持锁调用 scanner.scan，完成后记录时间；iwd 已经在扫描时等它结束而不是再发起一次。
+     * 另一个进程正在扫描时不调用 scan，等待其结束。返回 false 表示扫描或等待超时。
+     */
+    bool run(RescanPolicy policy, std::chrono::seconds max_age, Clock::duration timeout, const Scanner &scanner);
+
+    // 最近一次完成的扫描距今的时间，没有记录时为空
+    std::optional<std::chrono::milliseconds> lastScanAge() const;
+
+    // 记录一次刚完成的扫描（包括 iwd 自己发起的扫描）
+    void recordCompletion();
+
+  private:
+    bool open(const std::string &path);
+    // 等待持锁的进程完成扫描
+    bool waitForScan(Clock::duration timeout, const Scanner &scanner);
+
+    std::string path_;
+    int fd_ = -1;
+};
+
+#endif // SCAN_COORDINATOR_H
@@ -0,0 +1,102 @@
+#ifndef SCAN_SNAPSHOT_H
+#define SCAN_SNAPSHOT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+/**
+ * 快照内的字符串驻留表
+ *
+ * 同一次扫描中重复出现的值（安全类型）只存储一份。字符串和哈希表都分配在所属快照的 arena 上，
+ * 随快照一起释放，常驻模式反复刷新时不会累积；返回的 string_view 在快照生命周期内有效。
+ */
+class StringInterner {
+  public:
+    explicit StringInterner(std::pmr::memory_resource *arena);
+
+    std::string_view intern(std::string_view value);
+
+    size_t size() const { return strings_.size(); }
+
+  private:
+    std::pmr::memory_resource *arena_;
+    std::pmr::unordered_set<std::string_view> strings_;
+};
+
+/**
+ * 一次扫描结果的快照
+ *
+ * 按列（SoA）存储，信号强度是一段连续的 int16 数组，便于批量计算和排序；
+ * 所有列、SSID、对象路径和驻留的安全类型都分配在快照自己的 arena 上，销毁快照时整体释放。
+ */
+class ScanSnapshot {
+  public:
+    // 快照的内存统计
+    struct Stats {
+        size_t entries;
+        size_t arena_bytes;          // 从上游申请的总字节数
+        size_t upstream_allocations; // 向上游申请的次数
+    };
+
+    // expected_networks 用于预估初始 arena 大小，使常见情况下只需一次上游分配
+    explicit ScanSnapshot(size_t expected_networks = 0);
+    ~ScanSnapshot();
+
+    // 各列的分配器绑定在 arena 上，只支持移动构造
+    ScanSnapshot(ScanSnapshot &&) noexcept;
+    ScanSnapshot &operator=(ScanSnapshot &&) = delete;
+    ScanSnapshot(const ScanSnapshot &) = delete;
+    ScanSnapshot &operator=(const ScanSnapshot &) = delete;
+
+    // signal_strength 单位为dBm*100，超出 int16 范围时截断
+    void add(
+        std::string_view object_path, std::string_view ssid, std::string_view security, int signal_strength,
+        bool in_use
+    );
+
+    size_t size() const { return signals_.size(); }
+    bool empty() const { return signals_.empty(); }
+
+    std::string_view objectPath(size_t i) const { return object_paths_[i]; } // nl80211 后端为空
+    std::string_view ssid(size_t i) const { return ssids_[i]; }
+    std::string_view security(size_t i) const { return securities_[i]; }
+    int signal(size_t i) const { return signals_[i]; }
+    bool inUse(size_t i) const { return in_use_[i] != 0; }
+
+    // 连续的信号强度数组，单位为dBm*100
+    const int16_t *signals() const { return signals_.data(); }
+
+    Stats stats() const;
+
+  private:
+    // 统计向上游申请内存次数和字节数的 memory_resource
+    class CountingResource : public std::pmr::memory_resource {
+      public:
+        size_t allocations = 0;
+        size_t bytes = 0;
+
+      private:
+        void *do_allocate(size_t bytes, size_t alignment) override;
+        void do_deallocate(void *p, size_t bytes, size_t alignment) override;
+        bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override;
+    };
+
+    // 把字符串复制到 arena
+    std::string_view copy(std::string_view value);
+
+    std::unique_ptr<CountingResource> upstream_;
+    std::unique_ptr<std::pmr::monotonic_buffer_resource> arena_;
+    StringInterner interner_;
+    std::pmr::vector<std::string_view> object_paths_; // 以下字符串都指向本快照的 arena
+    std::pmr::vector<std::string_view> ssids_;
+    std::pmr::vector<std::string_view> securities_; // 驻留字符串
+    std::pmr::vector<int16_t> signals_;
+    std::pmr::vector<uint8_t> in_use_;
+};
+
+#endif // SCAN_SNAPSHOT_H
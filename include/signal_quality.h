@@ -0,0 +1,29 @@
+#ifndef SIGNAL_QUALITY_H
+#define SIGNAL_QUALITY_H
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * 分段线性的 dBm -> 信号质量(0-100) 映射
+ *
+ * -50dBm 及以上为 100，-90dBm 为 20，每 1dB 对应 2%，低于 -90dBm 为 0。
+ * 各段斜率相同，可以写成无分支的 clamp(2*dBm+200, 0, 100)。
+ */
+inline int dbmToQuality(int rssi_dbm) {
+    if (rssi_dbm < -90) {
+        return 0;
+    }
+    int quality = 2 * rssi_dbm + 200;
+    return quality > 100 ? 100 : quality;
+}
+
+/**
+ * 批量把 dBm*100 形式的信号强度转换为信号质量
+ *
+ * 在支持 SSE2 的平台上每次处理 16 个元素，其余元素及其他平台使用标量实现，
+ * 结果与对每个元素调用 dbmToQuality(signal / 100) 完全一致。
+ */
+void signalToQuality(const int16_t *signal_mbm, uint8_t *quality, size_t count);
+
+#endif // SIGNAL_QUALITY_H
@@ -0,0 +1,39 @@
+#ifndef STATE_PUBLISHER_H
+#define STATE_PUBLISHER_H
+
+#include <cstdint>
+#include <string>
+#include "nmcli_exception.h"
+#include "state_shm.h"
+#include "state_snapshot.h"
+
+/**
+ * 共享内存状态文件的写入端（布局和读取端见 state_shm.h）
+ *
+ * 文件按固定大小创建后只原地更新，不截断也不替换，读取端的映射在发布端重启后依然有效。
+ * 文件上持有 flock，同一路径只能有一个发布端。
+ */
+class StatePublisher {
+  public:
+    // 打开或创建 path，必要时创建上级目录；失败时抛出 NmcliException
+    // interval_ms 写入快照，读取端据此判断发布端是否仍在运行
+    explicit StatePublisher(std::string path = SHM_STATE_PATH, uint32_t interval_ms = 5000);
+    ~StatePublisher();
+
+    // 禁止拷贝构造和赋值
+    StatePublisher(const StatePublisher &) = delete;
+    StatePublisher &operator=(const StatePublisher &) = delete;
+
+    // 在 seqlock 写区间内更新全部字段，超出容量的设备被截断并设置 links_truncated
+    void publish(const StateSnapshot &snapshot);
+
+    uint64_t generation() const { return state_->generation; }
+
+  private:
+    std::string path_;
+    uint32_t interval_ms_;
+    int fd_ = -1;
+    ShmState *state_ = nullptr;
+};
+
+#endif // STATE_PUBLISHER_H
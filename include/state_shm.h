@@ -0,0 +1,170 @@
+#ifndef STATE_SHM_H
+#define STATE_SHM_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * 共享内存状态快照的布局和读取端
+ *
+ * 发布端（nmcli-alt state publish）把设备、连通性、无线电和 WiFi 状态写入 /run 下的映射文件，
+ * 每次变化都原地更新同一组定长记录，由 seqlock 保护：写入前后各把 seq 加一，奇数表示正在写入。
+ * 读取端只在打开时 open + mmap 一次，之后每次读取都是一次内存拷贝和两次 seq 比较，
+ * 不加锁也不进入内核，状态栏插件可以高频轮询。
+ *
+ * 本头文件只依赖 libc，可以单独复制给其他程序使用。
+ */
+
+constexpr const char *SHM_STATE_PATH = "/run/nmcli-alt/state";
+constexpr uint32_t SHM_STATE_MAGIC = 0x53414d4e; // "NMAS"
+constexpr uint32_t SHM_STATE_VERSION = 2;
+constexpr size_t SHM_MAX_LINKS = 32;
+constexpr size_t SHM_MAX_WIFI = 4;
+// 超过这么多个发布间隔没有更新的快照视为过期（发布端已退出或卡住）
+constexpr uint64_t SHM_STALE_INTERVALS = 3;
+
+// 字符串字段都以 0 结尾，超长时截断
+struct ShmLinkRecord {
+    char device[16]; // IFNAMSIZ
+    char type[16];
+    char operstate[16];
+};
+
+struct ShmWifiRecord {
+    char device[16];
+    char ssid[36]; // SSID 最长 32 字节
+    uint8_t connected;
+    uint8_t has_signal;
+    uint8_t reserved[2];
+    int32_t signal_dbm;
+    int32_t quality;
+};
+
+struct ShmState {
+    // 布局标识，发布端初始化文件时写入
+    uint32_t magic;
+    uint32_t version;
+    uint32_t size; // sizeof(ShmState)
+    uint32_t seq;  // 只能通过 std::atomic_ref 访问
+
+    // 以下字段受 seq 保护
+    uint64_t generation; // 发布次数
+    uint64_t updated_ns;  // CLOCK_REALTIME
+    uint32_t interval_ms; // 发布端的刷新间隔，即使没有变化也按此间隔更新 updated_ns
+    uint8_t iwd_available;
+    int8_t radio_enabled;    // -1 表示未知
+    uint8_t links_truncated; // 设备多于 SHM_MAX_LINKS，links 只有前 SHM_MAX_LINKS 个
+    uint8_t reserved;
+    char connectivity[16]; // full/none/unknown
+    uint32_t link_count;
+    uint32_t wifi_count;
+    ShmLinkRecord links[SHM_MAX_LINKS];
+    ShmWifiRecord wifi[SHM_MAX_WIFI];
+};
+
+static_assert(alignof(ShmState) >= std::atomic_ref<uint32_t>::required_alignment);
+
+// 快照距今的毫秒数；时钟回拨导致 updated_ns 在未来时按 0 计
+inline uint64_t shmStateAgeMs(const ShmState &state) {
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    const uint64_t now_ns = static_cast<uint64_t>(now.tv_sec) * 1000000000ull + static_cast<uint64_t>(now.tv_nsec);
+    return now_ns > state.updated_ns ? (now_ns - state.updated_ns) / 1000000 : 0;
+}
+
+// 发布端仍在按间隔更新：快照不早于 SHM_STALE_INTERVALS 个发布间隔
+inline bool shmStateFresh(const ShmState &state) {
+    return shmStateAgeMs(state) <= SHM_STALE_INTERVALS * state.interval_ms;
+}
+
+// 文件可以由 --from-shm 任意指定：计数超出数组的快照视为损坏，字符串字段强制以 0 结尾，
+// 读取端之后可以直接按 C 字符串使用它们
+inline bool shmStateSane(ShmState &state) {
+    if (state.magic != SHM_STATE_MAGIC || state.version != SHM_STATE_VERSION || state.size != sizeof(ShmState) ||
+        state.link_count > SHM_MAX_LINKS || state.wifi_count > SHM_MAX_WIFI) {
+        return false;
+    }
+    auto terminate = [](char *field, size_t size) { field[size - 1] = '\0'; };
+    terminate(state.connectivity, sizeof(state.connectivity));
+    for (ShmLinkRecord &link : state.links) {
+        terminate(link.device, sizeof(link.device));
+        terminate(link.type, sizeof(link.type));
+        terminate(link.operstate, sizeof(link.operstate));
+    }
+    for (ShmWifiRecord &wifi : state.wifi) {
+        terminate(wifi.device, sizeof(wifi.device));
+        terminate(wifi.ssid, sizeof(wifi.ssid));
+    }
+    return true;
+}
+
+/**
+ * 读取一份一致的快照
+ *
+ * 拷贝期间 seq 发生变化或为奇数时重试；发布端连续占用 spins 次仍未读到、或快照没有通过 shmStateSane 时返回 false。
+ * 拷贝本身与写入端存在数据竞争，但前后两次 seq 相同保证拷贝结果没有被写到一半。
+ */
+inline bool readShmState(const ShmState *shared, ShmState &out, int spins = 1000) {
+    // 只读映射上的原子 load 不会写内存
+    std::atomic_ref<uint32_t> seq(const_cast<uint32_t &>(shared->seq));
+    for (int i = 0; i < spins; ++i) {
+        const uint32_t before = seq.load(std::memory_order_acquire);
+        if (before & 1) {
+            continue;
+        }
+        std::memcpy(&out, shared, sizeof(ShmState));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (seq.load(std::memory_order_relaxed) == before) {
+            return shmStateSane(out);
+        }
+    }
+    return false;
+}
+
+/**
+ * 只读映射状态文件；映射在对象生命周期内保持，发布端重启后仍是同一个文件
+ */
+class ShmStateReader {
+  public:
+    explicit ShmStateReader(const char *path = SHM_STATE_PATH) {
+        int fd = open(path, O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            return;
+        }
+        struct stat st;
+        if (fstat(fd, &st) == 0 && static_cast<size_t>(st.st_size) >= sizeof(ShmState)) {
+            void *map = mmap(nullptr, sizeof(ShmState), PROT_READ, MAP_SHARED, fd, 0);
+            if (map != MAP_FAILED) {
+                shared_ = static_cast<const ShmState *>(map);
+            }
+        }
+        close(fd);
+    }
+
+    ~ShmStateReader() {
+        if (shared_) {
+            munmap(const_cast<ShmState *>(shared_), sizeof(ShmState));
+        }
+    }
+
+    // 禁止拷贝构造和赋值
+    ShmStateReader(const ShmStateReader &) = delete;
+    ShmStateReader &operator=(const ShmStateReader &) = delete;
+
+    // 文件不存在、大小不对或无法映射时为 false
+    bool valid() const { return shared_ != nullptr; }
+
+    bool read(ShmState &out) const { return shared_ && readShmState(shared_, out); }
+
+  private:
+    const ShmState *shared_ = nullptr;
+};
+
+#endif // STATE_SHM_H
@@ -0,0 +1,36 @@
+#ifndef STATE_SNAPSHOT_H
+#define STATE_SNAPSHOT_H
+
+#include <optional>
+#include <string>
+#include <vector>
+
+/**
+ * 常驻进程（metrics、state publish）在每次状态变化后采集的快照
+ *
+ * 由 rtnetlink 和 iwd 的事件驱动刷新，交给 textfile 导出或共享内存发布。
+ */
+struct StateSnapshot {
+    struct LinkState {
+        std::string device;
+        std::string type;
+        std::string operstate; // up/down/dormant 等
+    };
+
+    struct WifiState {
+        std::string device;
+        std::string ssid;       // 未连接时为空
+        bool connected = false;
+        bool has_signal = false; // 未关联时没有信号强度
+        int signal_dbm = 0;
+        int quality = 0;
+    };
+
+    std::vector<LinkState> links; // 包括 loopback
+    std::vector<WifiState> wifi;
+    bool iwd_available = false;
+    std::optional<bool> radio_enabled;
+    std::string connectivity; // full/none/unknown
+};
+
+#endif // STATE_SNAPSHOT_H
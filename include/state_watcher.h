@@ -0,0 +1,77 @@
+#ifndef STATE_WATCHER_H
+#define STATE_WATCHER_H
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include "dbus_async.h"
+#include "iwd_manager.h"
+#include "link_sampler.h"
+#include "rtnl_dump.h"
+#include "rtnl_monitor.h"
+#include "scan_coordinator.h"
+#include "state_snapshot.h"
+#include "station.h"
+#include <sdbus-c++/sdbus-c++.h>
+
+/**
+ * 常驻模式（metrics、state publish、NmcliClient 的监视线程）共用的状态采集循环
+ *
+ * rtnetlink 通知、iwd 的 PropertiesChanged 和 NameOwnerChanged 触发重新采集，50ms 内的多次变化合并为一次；
+ * 信号强度没有变化通知，每 interval 刷新一次。链路和默认路由每次都从同一个 RtnlDump socket 读取。
+ * sink 抛出的异常（例如磁盘已满时写文件失败）经 diag() 报告后继续运行（DiagnosticsMute 下不输出），下一次刷新会重试。
+ * Station 的 Scanning 回到 false 时把这次扫描（包括 iwd 的周期扫描）记入 ScanCoordinator，供 --rescan auto 使用。
+ */
+class StateWatcher {
+  public:
+    using Sink = std::function<void(const StateSnapshot &)>;
+
+    StateWatcher(std::chrono::milliseconds interval, Sink sink);
+    ~StateWatcher();
+
+    // 禁止拷贝构造和赋值
+    StateWatcher(const StateWatcher &) = delete;
+    StateWatcher &operator=(const StateWatcher &) = delete;
+
+    // 运行到 stop 返回 true 或 Deadline::global() 到期；stop 在每次唤醒后检查。
+    // wake_fd 可读时唤醒循环并重新采集（例如另一个线程写入的 eventfd）
+    void run(const std::function<bool()> &stop, int wake_fd = -1);
+
+  private:
+    // 合并短时间内的多次变化
+    void scheduleRefresh();
+    // 周期刷新，到期后设置下一次
+    void tick();
+    void refresh();
+    // iwd 启动、退出或重启后所有对象路径都会变化，从头订阅
+    void attachIwd();
+    void readWifi(StateSnapshot &snapshot);
+    void deliver(const StateSnapshot &snapshot);
+
+    std::chrono::milliseconds interval_;
+    Sink sink_;
+    IwdManager iwd_;
+    DBusEventLoop loop_;
+    RtnlMonitor monitor_;
+    RtnlDump dump_;
+
+    // iwd 的状态，启动时可能还不存在，iwd 出现后重新订阅
+    std::unique_ptr<Station> station_;
+    std::unique_ptr<sdbus::IProxy> adapter_proxy_;
+    std::unique_ptr<sdbus::IProxy> bus_proxy_;
+    std::string wifi_device_;
+    std::vector<sdbus::Slot> iwd_subscriptions_;
+    sdbus::Slot owner_subscription_;
+    bool iwd_changed_ = true;
+    std::map<std::string, std::unique_ptr<LinkSampler>> samplers_;
+    ScanCoordinator scan_coordinator_;
+
+    uint64_t flush_timer_ = 0;
+    bool sink_failing_ = false; // 连续失败只报告第一次
+};
+
+#endif // STATE_WATCHER_H
@@ -1,10 +1,14 @@
 #ifndef STATION_H
 #define STATION_H
 
+#include <chrono>
 #include <string>
 #include <vector>
 #include <memory>
 #include "nmcli_exception.h"
+#include "deadline.h"
+#include "dbus_async.h"
+#include "scan_snapshot.h"
 #include <sdbus-c++/sdbus-c++.h>
 
 class Station {
@@ -20,6 +24,8 @@ class Station {
 
     // 构造函数，通过device object path初始化
     explicit Station(const std::string &device_object_path);
+    // 复用已有的D-Bus连接，调用者需保证连接的生命周期长于Station
+    Station(sdbus::IConnection &connection, const std::string &device_object_path);
     ~Station();
 
     // 禁止拷贝构造和赋值
@@ -30,6 +36,16 @@ class Station {
     bool scan();                                   // 扫描网络
     bool disconnect();                             // 断开连接
     std::vector<NetworkInfo> getOrderedNetworks(); // 获取排序后的网络列表
+    ScanSnapshot getScanSnapshot();                // 获取排序后的网络列表快照（arena 分配）
+
+    // 协程版本，在 loop 上与其他操作并发推进
+    // 发起扫描并等待 Scanning 变为 false，超时返回 false；等待时间同时受 Deadline::global() 限制。
+    // iwd 以 Busy/InProgress 拒绝扫描时不抛出：正在扫描则等待它结束，否则返回 false，调用者使用已有结果
+    DBusTask<bool> scanAsync(DBusEventLoop &loop, DBusEventLoop::Clock::duration timeout);
+    // 等待 Scanning 属性变为 scanning（已经是该值时立即完成），超时返回 false
+    DBusTask<bool> waitScanningAsync(DBusEventLoop &loop, bool scanning, DBusEventLoop::Clock::duration timeout);
+    // 断开连接并等待 State 变为 disconnected，超时返回 false
+    DBusTask<bool> disconnectAsync(DBusEventLoop &loop, DBusEventLoop::Clock::duration timeout);
 
     // 属性获取方法
     std::string getState() const;            // 获取连接状态
@@ -39,48 +55,8 @@ class Station {
 
     std::vector<std::string> getAllConnection();
 
-    template <typename T> T getProperty(const std::string &interface, const std::string &property) const {
-        // 检查D-Bus连接和代理是否已初始化
-        if (!connection_ || !stationProxy_) {
-            throw std::runtime_error("D-Bus connection or station proxy not initialized");
-        }
-
-        // 使用已有的Station代理获取属性值
-        const sdbus::Variant result = stationProxy_->getProperty(property).onInterface(interface);
-
-        // 根据类型返回相应的值
-        if (result.containsValueOfType<T>()) {
-            return result.get<T>();
-        }
-
-        // 如果类型不匹配，返回默认构造的值
-        return T{};
-    }
-
-    // 从ObjectPath获取属性的通用模板方法
-    template <typename T>
-    T getPropertyFromObjectPath(
-        const sdbus::ObjectPath &objectPath, const std::string &interface, const std::string &property
-    ) const {
-        // 检查D-Bus连接是否已初始化
-        if (!connection_) {
-            throw std::runtime_error("D-Bus connection not initialized");
-        }
-
-        // 使用智能指针创建代理
-        auto proxy = sdbus::createProxy(*connection_, sdbus::ServiceName{"net.connman.iwd"}, objectPath);
-
-        // 获取属性值
-        const sdbus::Variant result = proxy->getProperty(property).onInterface(interface);
-
-        // 根据类型返回相应的值
-        if (result.containsValueOfType<T>()) {
-            return result.get<T>();
-        }
-
-        // 如果类型不匹配，返回默认构造的值
-        return T{};
-    }
+    // 同一连接上指向另一个 iwd 对象的代理，配合 Iwd*Proxy 读取该对象的属性
+    std::unique_ptr<sdbus::IProxy> objectProxy(const sdbus::ObjectPath &objectPath) const;
 
     template <typename T>
     T callMethodFromObjectPath(
@@ -94,14 +70,12 @@ class Station {
         // 使用智能指针创建代理
         auto proxy = sdbus::createProxy(*connection_, sdbus::ServiceName{"net.connman.iwd"}, objectPath);
 
-        T result;
-        proxy->callMethod(method).onInterface(interface).storeResultsTo(result);
-
-        return result;
+        return dbusCall<T>(*proxy, interface, method, "calling " + method);
     }
 
     std::string device_object_path_; // 设备对象路径
-    std::unique_ptr<sdbus::IConnection> connection_;
+    std::unique_ptr<sdbus::IConnection> owned_connection_; // 未传入连接时自行创建
+    sdbus::IConnection *connection_;
     std::unique_ptr<sdbus::IProxy> stationProxy_; // Station代理对象
 };
 
@@ -0,0 +1,168 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <functional>
+#include <map>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include "nmcli_exception.h"
+
+struct nl_sock;
+struct nl_msg;
+struct nl_cache;
+
+/**
+ * 追踪文件的二进制编码，整数按小端序写出，字节串带 32 位长度前缀
+ */
+class TraceEncoder {
+  public:
+    explicit TraceEncoder(std::string &out) : out_(out) {}
+
+    void u8(uint8_t value) { out_ += static_cast<char>(value); }
+    void u32(uint32_t value) { little(value, 4); }
+    void u64(uint64_t value) { little(value, 8); }
+    void bytes(std::string_view data) {
+        u32(static_cast<uint32_t>(data.size()));
+        out_.append(data.data(), data.size());
+    }
+
+  private:
+    void little(uint64_t value, int size) {
+        for (int i = 0; i < size; ++i) {
+            out_ += static_cast<char>((value >> (8 * i)) & 0xff);
+        }
+    }
+
+    std::string &out_;
+};
+
+class TraceDecoder {
+  public:
+    explicit TraceDecoder(std::string_view data) : data_(data) {}
+
+    uint8_t u8() { return static_cast<uint8_t>(little(1)); }
+    uint32_t u32() { return static_cast<uint32_t>(little(4)); }
+    uint64_t u64() { return little(8); }
+    std::string_view bytes() {
+        uint32_t size = u32();
+        need(size);
+        std::string_view value = data_.substr(0, size);
+        data_.remove_prefix(size);
+        return value;
+    }
+
+    bool empty() const { return data_.empty(); }
+
+  private:
+    void need(size_t size) const {
+        if (data_.size() < size) {
+            throw NmcliException("Truncated trace record");
+        }
+    }
+
+    uint64_t little(int size) {
+        need(static_cast<size_t>(size));
+        uint64_t value = 0;
+        for (int i = 0; i < size; ++i) {
+            value |= static_cast<uint64_t>(static_cast<unsigned char>(data_[i])) << (8 * i);
+        }
+        data_.remove_prefix(static_cast<size_t>(size));
+        return value;
+    }
+
+    std::string_view data_;
+};
+
+/**
+ * D-Bus 和 netlink 交互的录制与回放（--record / --replay）
+ *
+ * 录制时每次请求的响应连同开始时间和耗时顺序写入追踪文件；回放时不访问 iwd 和内核，
+ * 同一请求（操作名和请求内容相同）按录制顺序依次返回录制的响应，用完后重复最后一个。
+ * 默认回放不重现录制时的延迟，用于离线、可重复地测量列表和渲染路径；
+ * 按录制耗时回放（paced）时每个响应在录制的耗时之后才返回，用于比较往返次数不同的实现：
+ * 同步调用方在 replay 中阻塞，事件循环上的调用方取得耗时后用定时器恢复，并发的调用因此仍然重叠。
+ */
+class Trace {
+  public:
+    using Clock = std::chrono::steady_clock;
+
+    enum class Kind : uint8_t {
+        DBus = 1,
+        Netlink = 2,
+    };
+
+    static Trace &global();
+
+    ~Trace();
+
+    // 禁止拷贝构造和赋值
+    Trace(const Trace &) = delete;
+    Trace &operator=(const Trace &) = delete;
+
+    void startRecording(const std::string &path);
+    // paced 为 true 时每个响应按录制的耗时延迟返回
+    void loadReplay(const std::string &path, bool paced = false);
+
+    bool recording() const { return file_ != nullptr; }
+    bool replaying() const { return replaying_; }
+
+    void record(
+        Kind kind, const std::string &operation, const std::string &key, Clock::time_point start,
+        Clock::duration elapsed, const std::string &payload
+    );
+
+    // 没有对应的录制响应时抛出 NmcliException。paced 回放时 delay 为空则阻塞录制的耗时，
+    // 否则把耗时写入 *delay（非 paced 时为 0），由调用方在事件循环上安排
+    const std::string &
+    replay(Kind kind, const std::string &operation, const std::string &key, Clock::duration *delay = nullptr);
+
+    // 没有录制的响应时返回 nullptr；不阻塞，delay 不为空时写入 paced 回放应等待的耗时
+    const std::string *
+    find(Kind kind, const std::string &operation, const std::string &key, Clock::duration *delay = nullptr);
+
+    // 是否还有未取出的录制响应（用完后 find 重复返回最后一个）
+    bool pending(Kind kind, const std::string &operation, const std::string &key) const;
+
+    /**
+     * 在 sock 上完成一次 netlink 请求/响应交换
+     *
+     * live 发出请求并接收到结束，返回值原样返回；录制时通过 NL_CB_MSG_IN 保存收到的每条消息。
+     * 回放时不调用 live，把录制的消息依次交给 handler（可以为空），并返回录制时的返回值。
+     */
+    int netlinkExchange(
+        struct nl_sock *sock, const std::string &operation, const std::string &key, const std::function<int()> &live,
+        int (*handler)(struct nl_msg *, void *), void *arg
+    );
+
+    // 用 libnl 缓存（如 "route/route"）接收的交换；回放时分配同类缓存并逐条解析录制的消息
+    int netlinkCache(
+        struct nl_sock *sock, const char *cache_name, const std::string &operation,
+        const std::function<int(struct nl_cache **)> &alloc, struct nl_cache **result
+    );
+
+  private:
+    Trace() = default;
+
+    struct Reply {
+        std::string payload;
+        Clock::duration elapsed{};
+    };
+
+    struct Replies {
+        std::deque<Reply> pending;
+        Reply last;
+    };
+
+    std::FILE *file_ = nullptr;
+    Clock::time_point origin_;
+    bool replaying_ = false;
+    bool paced_ = false;
+    std::map<std::tuple<Kind, std::string, std::string>, Replies> replies_;
+};
+
+#endif // TRACE_H
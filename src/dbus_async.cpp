@@ -0,0 +1,488 @@
+#include "dbus_async.h"
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+DBusEventLoop::DBusEventLoop(sdbus::IConnection &connection) : connection_(connection) {}
+
+void DBusEventLoop::schedule(std::coroutine_handle<> handle) {
+    ready_.push_back(handle);
+}
+
+uint64_t DBusEventLoop::addTimer(Clock::time_point when, std::function<void()> callback) {
+    uint64_t id = next_timer_id_++;
+    timers_.emplace(id, Timer{when, std::move(callback)});
+    return id;
+}
+
+void DBusEventLoop::cancelTimer(uint64_t id) {
+    timers_.erase(id);
+}
+
+uint64_t DBusEventLoop::addWatch(int fd, std::function<void()> on_readable) {
+    uint64_t id = next_watch_id_++;
+    watches_.emplace(id, Watch{fd, std::move(on_readable)});
+    return id;
+}
+
+void DBusEventLoop::removeWatch(uint64_t id) {
+    watches_.erase(id);
+}
+
+void DBusEventLoop::dispatch() {
+    bool progressed;
+    do {
+        progressed = false;
+
+        // 处理连接上所有已到达的消息，异步回复和信号回调只会把协程放入就绪队列
+        while (connection_.processPendingEvent()) {
+            progressed = true;
+        }
+
+        // 在 sdbus 回调之外恢复协程，协程中可以安全地发起新的调用
+        while (!ready_.empty()) {
+            std::coroutine_handle<> handle = ready_.front();
+            ready_.pop_front();
+            handle.resume();
+            progressed = true;
+        }
+    } while (progressed);
+}
+
+void DBusEventLoop::fireTimers() {
+    const Clock::time_point now = Clock::now();
+
+    // 先收集到期的定时器，回调中可能会增删定时器
+    std::vector<uint64_t> expired;
+    for (const auto &[id, timer] : timers_) {
+        if (timer.when <= now) {
+            expired.push_back(id);
+        }
+    }
+
+    for (uint64_t id : expired) {
+        auto it = timers_.find(id);
+        if (it == timers_.end()) {
+            continue;
+        }
+        std::function<void()> callback = std::move(it->second.callback);
+        timers_.erase(it);
+        callback();
+    }
+}
+
+void DBusEventLoop::runOnce() {
+    dispatch();
+
+    sdbus::IConnection::PollData pollData = connection_.getEventLoopPollData();
+
+    // 取 D-Bus 自身的超时和最近的定时器中较早的一个
+    int timeout_ms = pollData.getPollTimeout();
+    if (!timers_.empty()) {
+        Clock::time_point earliest = Clock::time_point::max();
+        for (const auto &entry : timers_) {
+            earliest = std::min(earliest, entry.second.when);
+        }
+        auto until = std::chrono::ceil<std::chrono::milliseconds>(earliest - Clock::now()).count();
+        int timer_ms = static_cast<int>(std::max<decltype(until)>(until, 0));
+        timeout_ms = timeout_ms < 0 ? timer_ms : std::min(timeout_ms, timer_ms);
+    }
+
+    // D-Bus 连接和事件 fd 在前，其后是按 id 排列的外部监视
+    std::vector<struct pollfd> fds;
+    std::vector<uint64_t> watch_ids;
+    fds.reserve(2 + watches_.size());
+    fds.push_back({pollData.fd, pollData.events, 0});
+    if (pollData.eventFd >= 0) {
+        fds.push_back({pollData.eventFd, POLLIN, 0});
+    }
+    const size_t first_watch = fds.size();
+    for (const auto &[id, watch] : watches_) {
+        fds.push_back({watch.fd, POLLIN, 0});
+        watch_ids.push_back(id);
+    }
+
+    int ready = poll(fds.data(), fds.size(), timeout_ms);
+    if (ready < 0 && errno != EINTR) {
+        throw DBusException("Failed to poll D-Bus connection");
+    }
+
+    // 回调中可能移除监视，每次按 id 重新查找
+    for (size_t i = 0; ready > 0 && i < watch_ids.size(); ++i) {
+        if (fds[first_watch + i].revents == 0) {
+            continue;
+        }
+        auto it = watches_.find(watch_ids[i]);
+        if (it != watches_.end()) {
+            it->second.on_readable();
+        }
+    }
+
+    fireTimers();
+    dispatch();
+}
+
+void DBusEventLoop::runUntil(const std::function<bool()> &done) {
+    dispatch();
+    while (!done()) {
+        runOnce();
+    }
+}
+
+namespace {
+
+// 等待时间取 timeout 和截止时间剩余时间中较小的一个，0 表示不超时
+DBusEventLoop::Clock::duration waitTimeout(DBusEventLoop::Clock::duration timeout) {
+    const Deadline &deadline = Deadline::global();
+    if (!deadline.unlimited()) {
+        DBusEventLoop::Clock::duration remaining = deadline.remainingOr(DBusEventLoop::Clock::duration::zero());
+        timeout = timeout > DBusEventLoop::Clock::duration::zero() ? std::min(timeout, remaining) : remaining;
+        timeout = std::max(timeout, DBusEventLoop::Clock::duration(1));
+    }
+    return timeout;
+}
+
+} // namespace
+
+DBusPropertyWait::DBusPropertyWait(
+    DBusEventLoop &loop, sdbus::IProxy &proxy, std::string interface, std::string property, Predicate predicate,
+    DBusEventLoop::Clock::duration timeout
+)
+    : loop_(loop), proxy_(proxy), interface_(std::move(interface)), property_(std::move(property)),
+      predicate_(std::move(predicate)), timeout_(timeout) {}
+
+DBusPropertyWait::~DBusPropertyWait() {
+    if (timer_) {
+        loop_.cancelTimer(timer_);
+    }
+    // 超时或协程销毁时 Get 可能还没有回复，取消后回调不再运行，结束探针在这里触发
+    if (get_call_ && get_call_->isPending()) {
+        get_call_->cancel();
+        Probes::end(ProbeKind::DBus, "Get", proxy_.getObjectPath().c_str(), get_start_, -1);
+    }
+}
+
+void DBusPropertyWait::await_suspend(std::coroutine_handle<> handle) {
+    handle_ = handle;
+
+    if (Trace::global().replaying()) {
+        replay();
+        return;
+    }
+
+    // 先订阅属性变化信号
+    signal_slot_ = proxy_.uponSignal("PropertiesChanged")
+                       .onInterface("org.freedesktop.DBus.Properties")
+                       .call(
+                           [this](
+                               const std::string &interface, const std::map<std::string, sdbus::Variant> &changed,
+                               const std::vector<std::string> & /*invalidated*/
+                           ) {
+                               if (interface != interface_) {
+                                   return;
+                               }
+                               auto it = changed.find(property_);
+                               if (it != changed.end() && check(it->second) && Trace::global().recording()) {
+                                   auto now = std::chrono::steady_clock::now();
+                                   Trace::global().record(
+                                       Trace::Kind::DBus, "PropertiesChanged",
+                                       dbusTraceKey(proxy_, interface_, property_), now,
+                                       std::chrono::steady_clock::duration::zero(), dbusTraceReply(it->second)
+                                   );
+                               }
+                           },
+                           sdbus::return_slot
+                       );
+
+    // 再读取当前值，属性可能已经满足条件
+    get_start_ = std::chrono::steady_clock::now();
+    Probes::begin(ProbeKind::DBus, "Get", proxy_.getObjectPath().c_str());
+    get_call_ = proxy_.callMethodAsync("Get")
+                    .onInterface("org.freedesktop.DBus.Properties")
+                    .withTimeout(Deadline::global().dbusTimeout("reading " + property_))
+                    .withArguments(interface_, property_)
+                    .uponReplyInvoke([this](std::optional<sdbus::Error> error, sdbus::Variant value) {
+                        const auto elapsed = std::chrono::steady_clock::now() - get_start_;
+                        Instrumentation::record("dbus", "Get", elapsed);
+                        Probes::end(ProbeKind::DBus, "Get", proxy_.getObjectPath().c_str(), get_start_, error ? 1 : 0);
+                        if (Trace::global().recording()) {
+                            Trace::global().record(
+                                Trace::Kind::DBus, "Get",
+                                dbusTraceKey(proxy_, "org.freedesktop.DBus.Properties", "Get", interface_, property_),
+                                get_start_, elapsed, error ? dbusTraceError(*error) : dbusTraceReply(value)
+                            );
+                        }
+                        if (error) {
+                            if (!finished_) {
+                                error_ = std::move(error);
+                                finish(false);
+                            }
+                            return;
+                        }
+                        check(value);
+                    });
+
+    const DBusEventLoop::Clock::duration timeout = waitTimeout(timeout_);
+    if (timeout > DBusEventLoop::Clock::duration::zero()) {
+        timer_ = loop_.addTimer(DBusEventLoop::Clock::now() + timeout, [this] {
+            timer_ = 0;
+            finish(false);
+        });
+    }
+}
+
+bool DBusPropertyWait::await_resume() {
+    // 信号订阅在恢复后（sdbus 回调之外）才释放
+    signal_slot_ = {};
+    if (!matched_) {
+        Deadline::global().check("waiting for " + property_);
+    }
+    if (error_) {
+        throw *error_;
+    }
+    return matched_;
+}
+
+bool DBusPropertyWait::check(const sdbus::Variant &value) {
+    if (!finished_ && predicate_(value)) {
+        finish(true);
+        return true;
+    }
+    return false;
+}
+
+void DBusPropertyWait::replay() {
+    Trace &trace = Trace::global();
+
+    try {
+        auto [value] = dbusTraceDecode<sdbus::Variant>(trace.replay(
+            Trace::Kind::DBus, "Get",
+            dbusTraceKey(proxy_, "org.freedesktop.DBus.Properties", "Get", interface_, property_), &replay_delay_
+        ));
+        check(value);
+    } catch (const sdbus::Error &e) {
+        error_ = e;
+        finish(false);
+        return;
+    }
+
+    // 录制时条件由属性变化满足
+    if (!finished_) {
+        const std::string *changed =
+            trace.find(Trace::Kind::DBus, "PropertiesChanged", dbusTraceKey(proxy_, interface_, property_));
+        if (changed) {
+            auto [value] = dbusTraceDecode<sdbus::Variant>(*changed);
+            check(value);
+        }
+    }
+
+    // 录制时等待超时
+    finish(false);
+}
+
+void DBusPropertyWait::finish(bool matched) {
+    if (finished_) {
+        return;
+    }
+    finished_ = true;
+    matched_ = matched;
+
+    if (timer_) {
+        loop_.cancelTimer(timer_);
+        timer_ = 0;
+    }
+    // paced 回放在录制的耗时之后恢复，循环上的其他任务照常推进
+    if (replay_delay_ > DBusEventLoop::Clock::duration::zero()) {
+        timer_ = loop_.addTimer(DBusEventLoop::Clock::now() + replay_delay_, [this] {
+            timer_ = 0;
+            loop_.schedule(handle_);
+        });
+        return;
+    }
+    loop_.schedule(handle_);
+}
+
+DBusInterfaceWait::DBusInterfaceWait(
+    DBusEventLoop &loop, sdbus::IProxy &manager, std::string interface, std::string path_prefix,
+    DBusEventLoop::Clock::duration timeout, Match match
+)
+    : loop_(loop), manager_(manager), interface_(std::move(interface)), path_prefix_(std::move(path_prefix)),
+      timeout_(timeout), match_(std::move(match)) {}
+
+DBusInterfaceWait::~DBusInterfaceWait() {
+    if (timer_) {
+        loop_.cancelTimer(timer_);
+    }
+    if (list_call_ && list_call_->isPending()) {
+        list_call_->cancel();
+        Probes::end(ProbeKind::DBus, "GetManagedObjects", manager_.getObjectPath().c_str(), list_start_, -1);
+    }
+}
+
+void DBusInterfaceWait::await_suspend(std::coroutine_handle<> handle) {
+    handle_ = handle;
+
+    if (Trace::global().replaying()) {
+        replay();
+        return;
+    }
+
+    // 先订阅对象出现的信号
+    signal_slot_ = manager_.uponSignal("InterfacesAdded")
+                       .onInterface("org.freedesktop.DBus.ObjectManager")
+                       .call(
+                           [this](const sdbus::ObjectPath &path, const Interfaces &interfaces) {
+                               if (finished_ || !relevant(path, interfaces)) {
+                                   return;
+                               }
+                               if (Trace::global().recording()) {
+                                   auto now = std::chrono::steady_clock::now();
+                                   Trace::global().record(
+                                       Trace::Kind::DBus, "InterfacesAdded",
+                                       dbusTraceKey(manager_, interface_, path_prefix_), now,
+                                       std::chrono::steady_clock::duration::zero(), dbusTraceReply(path, interfaces)
+                                   );
+                               }
+                               check(path, interfaces);
+                           },
+                           sdbus::return_slot
+                       );
+
+    // 再列出已有对象，目标可能已经存在
+    list_start_ = std::chrono::steady_clock::now();
+    Probes::begin(ProbeKind::DBus, "GetManagedObjects", manager_.getObjectPath().c_str());
+    list_call_ = manager_.callMethodAsync("GetManagedObjects")
+                     .onInterface("org.freedesktop.DBus.ObjectManager")
+                     .withTimeout(Deadline::global().dbusTimeout("listing objects"))
+                     .uponReplyInvoke([this](std::optional<sdbus::Error> error, ManagedObjects objects) {
+                         const auto elapsed = std::chrono::steady_clock::now() - list_start_;
+                         Instrumentation::record("dbus", "GetManagedObjects", elapsed);
+                         Probes::end(
+                             ProbeKind::DBus, "GetManagedObjects", manager_.getObjectPath().c_str(), list_start_,
+                             error ? 1 : 0
+                         );
+                         if (Trace::global().recording()) {
+                             Trace::global().record(
+                                 Trace::Kind::DBus, "GetManagedObjects",
+                                 dbusTraceKey(manager_, "org.freedesktop.DBus.ObjectManager", "GetManagedObjects"),
+                                 list_start_, elapsed, error ? dbusTraceError(*error) : dbusTraceReply(objects)
+                             );
+                         }
+                         if (error) {
+                             if (!finished_) {
+                                 error_ = std::move(error);
+                                 finish("");
+                             }
+                             return;
+                         }
+                         for (const auto &[path, interfaces] : objects) {
+                             if (check(path, interfaces)) {
+                                 break;
+                             }
+                         }
+                     });
+
+    const DBusEventLoop::Clock::duration timeout = waitTimeout(timeout_);
+    if (timeout > DBusEventLoop::Clock::duration::zero()) {
+        timer_ = loop_.addTimer(DBusEventLoop::Clock::now() + timeout, [this] {
+            timer_ = 0;
+            finish("");
+        });
+    }
+}
+
+std::string DBusInterfaceWait::await_resume() {
+    // 信号订阅在恢复后（sdbus 回调之外）才释放
+    signal_slot_ = {};
+    if (path_.empty()) {
+        Deadline::global().check("waiting for " + interface_);
+    }
+    if (error_) {
+        throw *error_;
+    }
+    return path_;
+}
+
+bool DBusInterfaceWait::relevant(const sdbus::ObjectPath &path, const Interfaces &interfaces) const {
+    return path.compare(0, path_prefix_.size(), path_prefix_) == 0 && interfaces.count(interface_);
+}
+
+bool DBusInterfaceWait::check(const sdbus::ObjectPath &path, const Interfaces &interfaces) {
+    if (finished_ || !relevant(path, interfaces) || (match_ && !match_(path, interfaces))) {
+        return false;
+    }
+    finish(path);
+    return true;
+}
+
+void DBusInterfaceWait::replay() {
+    Trace &trace = Trace::global();
+
+    try {
+        auto [objects] = dbusTraceDecode<ManagedObjects>(trace.replay(
+            Trace::Kind::DBus, "GetManagedObjects",
+            dbusTraceKey(manager_, "org.freedesktop.DBus.ObjectManager", "GetManagedObjects"), &replay_delay_
+        ));
+        for (const auto &[path, interfaces] : objects) {
+            if (check(path, interfaces)) {
+                return;
+            }
+        }
+    } catch (const sdbus::Error &e) {
+        error_ = e;
+        finish("");
+        return;
+    }
+
+    // 录制时对象在等待期间依次出现
+    const std::string key = dbusTraceKey(manager_, interface_, path_prefix_);
+    while (trace.pending(Trace::Kind::DBus, "InterfacesAdded", key)) {
+        auto [path, interfaces] = dbusTraceDecode<sdbus::ObjectPath, Interfaces>(
+            *trace.find(Trace::Kind::DBus, "InterfacesAdded", key)
+        );
+        if (check(path, interfaces)) {
+            return;
+        }
+    }
+
+    // 录制时等待超时
+    finish("");
+}
+
+void DBusInterfaceWait::finish(const std::string &path) {
+    if (finished_) {
+        return;
+    }
+    finished_ = true;
+    path_ = path;
+
+    if (timer_) {
+        loop_.cancelTimer(timer_);
+        timer_ = 0;
+    }
+    // paced 回放在录制的耗时之后恢复，循环上的其他任务照常推进
+    if (replay_delay_ > DBusEventLoop::Clock::duration::zero()) {
+        timer_ = loop_.addTimer(DBusEventLoop::Clock::now() + replay_delay_, [this] {
+            timer_ = 0;
+            loop_.schedule(handle_);
+        });
+        return;
+    }
+    loop_.schedule(handle_);
+}
+
+std::unique_ptr<sdbus::IConnection> openSystemBus() {
+    if (!Trace::global().replaying()) {
+        return sdbus::createSystemBusConnection();
+    }
+
+    // 对端故意不关闭，连接既不会收到数据也不会看到 EOF；每条命令只打开少数几个连接
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds) < 0) {
+        throw DBusException("Failed to create replay connection: " + std::string(strerror(errno)));
+    }
+    return sdbus::createServerBus(fds[0]);
+}
@@ -0,0 +1,53 @@
+#include "deadline.h"
+
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <algorithm>
+
+Deadline &Deadline::global() {
+    static Deadline deadline;
+    return deadline;
+}
+
+Deadline::Clock::duration Deadline::remainingOr(Clock::duration fallback) const {
+    if (!when_) {
+        return fallback;
+    }
+    return std::max(*when_ - Clock::now(), Clock::duration::zero());
+}
+
+void Deadline::check(const std::string &what) const {
+    if (expired()) {
+        throw TimeoutException("Timeout expired while " + what);
+    }
+}
+
+std::chrono::microseconds Deadline::dbusTimeout(const std::string &what) const {
+    check(what);
+    auto remaining = std::chrono::ceil<std::chrono::microseconds>(remainingOr(DEFAULT_DBUS_TIMEOUT));
+    // 0 在 sd-bus 中表示使用默认超时，至少保留 1us
+    return std::clamp(remaining, std::chrono::microseconds(1), DEFAULT_DBUS_TIMEOUT);
+}
+
+int Deadline::pollTimeoutMs() const {
+    if (!when_) {
+        return -1;
+    }
+    auto ms = std::chrono::ceil<std::chrono::milliseconds>(remainingOr(Clock::duration::zero())).count();
+    return static_cast<int>(std::min<decltype(ms)>(ms, 0x7fffffff));
+}
+
+void Deadline::applyReceiveTimeout(int fd) const {
+    if (!when_) {
+        return;
+    }
+
+    auto remaining = std::chrono::ceil<std::chrono::microseconds>(remainingOr(Clock::duration::zero()));
+    // 全 0 的 SO_RCVTIMEO 表示永不超时，已到期时设置为最小值
+    remaining = std::max(remaining, std::chrono::microseconds(1));
+
+    struct timeval tv;
+    tv.tv_sec = static_cast<time_t>(remaining.count() / 1000000);
+    tv.tv_usec = static_cast<suseconds_t>(remaining.count() % 1000000);
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+}
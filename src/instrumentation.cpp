@@ -0,0 +1,124 @@
+#include "instrumentation.h"
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+void LatencyHistogram::record(uint64_t value_ns) {
+    buckets_[bucketIndex(value_ns)].fetch_add(1, std::memory_order_relaxed);
+    count_.fetch_add(1, std::memory_order_relaxed);
+    sum_.fetch_add(value_ns, std::memory_order_relaxed);
+
+    uint64_t current = max_.load(std::memory_order_relaxed);
+    while (value_ns > current && !max_.compare_exchange_weak(current, value_ns, std::memory_order_relaxed)) {
+    }
+}
+
+size_t LatencyHistogram::bucketIndex(uint64_t value_ns) {
+    // 小于 2*SUB_BUCKET_COUNT 的值每个整数一个桶，之后每个 2 的幂区间 SUB_BUCKET_COUNT 个桶
+    if (value_ns < 2 * SUB_BUCKET_COUNT) {
+        return static_cast<size_t>(value_ns);
+    }
+
+    const int exponent = 63 - __builtin_clzll(value_ns);
+    if (exponent > MAX_EXPONENT) {
+        return BUCKET_COUNT - 1;
+    }
+
+    const int shift = exponent - SUB_BUCKET_BITS;
+    return static_cast<size_t>(shift + 1) * SUB_BUCKET_COUNT + ((value_ns >> shift) - SUB_BUCKET_COUNT);
+}
+
+uint64_t LatencyHistogram::bucketUpperBound(size_t index) {
+    if (index < 2 * SUB_BUCKET_COUNT) {
+        return index;
+    }
+
+    const int shift = static_cast<int>(index / SUB_BUCKET_COUNT) - 1;
+    const uint64_t lower = (SUB_BUCKET_COUNT + index % SUB_BUCKET_COUNT) << shift;
+    return lower + (1ull << shift) - 1;
+}
+
+uint64_t LatencyHistogram::countAtOrBelow(uint64_t value_ns) const {
+    uint64_t total = 0;
+    const size_t last = bucketIndex(value_ns);
+    for (size_t i = 0; i <= last; ++i) {
+        // 值所在的桶只有上界不超过 value_ns 时才计入
+        if (i == last && bucketUpperBound(i) > value_ns) {
+            break;
+        }
+        total += buckets_[i].load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+uint64_t LatencyHistogram::valueAtQuantile(double q) const {
+    const uint64_t total = count();
+    if (total == 0) {
+        return 0;
+    }
+
+    q = q < 0 ? 0 : (q > 1 ? 1 : q);
+    uint64_t rank = static_cast<uint64_t>(q * static_cast<double>(total) + 0.5);
+    rank = rank == 0 ? 1 : rank;
+
+    uint64_t seen = 0;
+    for (size_t i = 0; i < BUCKET_COUNT; ++i) {
+        seen += buckets_[i].load(std::memory_order_relaxed);
+        if (seen >= rank) {
+            // 桶上界不超过实际最大值
+            uint64_t upper = bucketUpperBound(i);
+            return upper < max() ? upper : max();
+        }
+    }
+    return max();
+}
+
+namespace {
+
+struct Registry {
+    std::mutex mutex;
+    std::map<std::pair<std::string, std::string>, std::unique_ptr<LatencyHistogram>> histograms;
+};
+
+Registry &registry() {
+    static Registry instance;
+    return instance;
+}
+
+} // namespace
+
+LatencyHistogram &Instrumentation::histogram(const std::string &kind, const std::string &operation) {
+    Registry &reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+
+    auto &slot = reg.histograms[std::make_pair(kind, operation)];
+    if (!slot) {
+        slot = std::make_unique<LatencyHistogram>();
+    }
+    return *slot;
+}
+
+void Instrumentation::record(
+    const std::string &kind, const std::string &operation, std::chrono::steady_clock::duration elapsed
+) {
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+    histogram(kind, operation).record(ns > 0 ? static_cast<uint64_t>(ns) : 0);
+}
+
+void Instrumentation::forEach(
+    const std::function<void(const std::string &kind, const std::string &operation, const LatencyHistogram &)> &fn
+) {
+    Registry &reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+
+    for (const auto &[key, histogram] : reg.histograms) {
+        fn(key.first, key.second, *histogram);
+    }
+}
+
+LatencySpan::~LatencySpan() {
+    Instrumentation::record(kind_, operation_, std::chrono::steady_clock::now() - start_);
+    MemStats::leavePhase(mem_phase_);
+}
@@ -0,0 +1,62 @@
+#include "iwd_introspection.h"
+
+#include <algorithm>
+#include <regex>
+
+// 从 /net/connman/iwd 的内省数据中解析适配器路径
+std::string adapterPathFromIntrospection(const std::string &introspectionData) {
+    // 使用正则表达式查找第一个数字命名的节点（通常是phy索引）
+    std::regex nodeRegex("<node name=\"(\\d+)\"");
+    std::smatch match;
+
+    if (std::regex_search(introspectionData, match, nodeRegex) && match.size() > 1) {
+        return "/net/connman/iwd/" + match.str(1);
+    }
+
+    // 如果没找到数字命名的节点，尝试查找phy命名的节点
+    std::regex phyRegex("<node name=\"(phy\\d+)\"");
+    if (std::regex_search(introspectionData, match, phyRegex) && match.size() > 1) {
+        return "/net/connman/iwd/" + match.str(1);
+    }
+
+    // 没有找到 Adapter，由调用方决定后备路径
+    return "";
+}
+
+// 从适配器的内省数据中解析设备路径
+std::string devicePathFromIntrospection(const std::string &adapterPath, const std::string &introspectionData) {
+    // 使用正则表达式查找设备节点（通常是数字）
+    std::regex deviceRegex("<node name=\"(\\d+)\"");
+    std::smatch match;
+
+    if (std::regex_search(introspectionData, match, deviceRegex) && match.size() > 1) {
+        return adapterPath + "/" + match.str(1);
+    }
+
+    // 没有找到设备，由调用方决定后备路径
+    return "";
+}
+
+// 从 /net/connman/iwd 的内省数据中解析已知网络路径（非纯数字的子节点）
+std::vector<std::string> networkPathsFromIntrospection(const std::string &introspectionData) {
+    // 已知网络直接位于 /net/connman/iwd/ 下
+    std::regex nodeRegex("<node name=\"([^\"]+)\"");
+    std::smatch match;
+    std::string::const_iterator searchStart(introspectionData.cbegin());
+
+    std::vector<std::string> wifiConnections;
+    // 查找所有子节点
+    while (std::regex_search(searchStart, introspectionData.cend(), match, nodeRegex)) {
+        std::string networkNodeName = match[1].str();
+        searchStart = match.suffix().first;
+
+        // 跳过纯数字节点（适配器/设备）
+        if (std::all_of(networkNodeName.begin(), networkNodeName.end(), ::isdigit)) {
+            continue;
+        }
+
+        std::string networkPath = "/net/connman/iwd/" + networkNodeName;
+        wifiConnections.push_back(networkPath);
+    }
+    return wifiConnections;
+}
@@ -1,13 +1,20 @@
 #include "iwd_manager.h"
 #include "station.h"
 #include "process_util.h"
+#include "deadline.h"
+#include "property_cache.h"
+#include "diagnostics.h"
+#include "iwd_interfaces.h"
+#include "iwd_introspection.h"
 
 #include <sdbus-c++/sdbus-c++.h>
-#include <iostream>
-#include <regex>
+#include <algorithm>
+#include <chrono>
+#include <map>
 #include <memory>
+#include <optional>
 
-IwdManager::IwdManager() : connection_(sdbus::createSystemBusConnection()) {
+IwdManager::IwdManager() : connection_(openSystemBus()) {
     // 构造函数初始化列表中直接创建D-Bus连接
     // connection_会自动管理资源，无需手动释放
 }
@@ -19,7 +26,7 @@ bool IwdManager::connectToNetwork(const std::string &ssid, const std::string &pa
         // 尝试使用 D-Bus API 连接网络
         if (!connectToNetworkViaDBus(ssid, password)) {
             // 如果 D-Bus 方法失败，回退到 iwctl 命令行工具
-            std::cerr << "Falling back to iwctl method..." << std::endl;
+            diag() << "Falling back to iwctl method..." << std::endl;
             return connectToNetworkViaIWCTL(ssid, password);
         }
         return true;
@@ -32,118 +39,146 @@ bool IwdManager::connectToNetwork(const std::string &ssid, const std::string &pa
     }
 }
 
-std::string IwdManager::getAdapterObjectPath() {
-    // 根据iwd文档，Adapter的Object Path格式为/net/connman/iwd/{phy0,phy1,...}
-    // 使用sdbus-c++简化实现
+namespace {
+
+using PropertyMap = std::map<std::string, sdbus::Variant>;
+using ManagedObjects = std::map<sdbus::ObjectPath, std::map<std::string, PropertyMap>>;
 
+// 信号强度按 5dB 分档，同一档内的差异主要是测量抖动，改由最近连接时间决定先后
+int signalBucket(int signal) {
+    return signal / 500;
+}
+
+// Station.State 属于给定集合之一
+DBusPropertyWait::Predicate stateIn(std::vector<std::string> states) {
+    return [states = std::move(states)](const sdbus::Variant &value) {
+        return value.containsValueOfType<std::string>() &&
+               std::find(states.begin(), states.end(), value.get<std::string>()) != states.end();
+    };
+}
+
+} // namespace
+
+std::string IwdManager::getAdapterObjectPath() {
     // 检查D-Bus连接是否已初始化
     if (!connection_) {
-        std::cerr << "D-Bus connection not initialized" << std::endl;
+        diag() << "D-Bus connection not initialized" << std::endl;
         return "";
     }
 
-    try {
-        // 直接尝试获取iwd服务的内省数据
-        std::string introspectionData;
-        // 使用智能指针创建iwd服务代理对象
-        auto iwdProxy = sdbus::createProxy(
-            *connection_, sdbus::ServiceName{"net.connman.iwd"}, sdbus::ObjectPath{"/net/connman/iwd"}
-        );
-
-        iwdProxy->callMethod("Introspect")
-            .onInterface("org.freedesktop.DBus.Introspectable")
-            .storeResultsTo(introspectionData);
+    DBusEventLoop loop(*connection_);
+    return loop.run(getAdapterObjectPathAsync(loop));
+}
 
-        // 使用正则表达式查找第一个数字命名的节点（通常是phy索引）
-        std::regex nodeRegex("<node name=\"(\\d+)\"");
-        std::smatch match;
+std::string IwdManager::getDeviceObjectPath() {
+    // 检查D-Bus连接是否已初始化
+    if (!connection_) {
+        diag() << "D-Bus connection not initialized" << std::endl;
+        return "";
+    }
 
-        if (std::regex_search(introspectionData, match, nodeRegex) && match.size() > 1) {
-            return "/net/connman/iwd/" + match.str(1);
-        }
+    DBusEventLoop loop(*connection_);
+    return loop.run(getDeviceObjectPathAsync(loop));
+}
 
-        // 如果没找到数字命名的节点，尝试查找phy命名的节点
-        std::regex phyRegex("<node name=\"(phy\\d+)\"");
-        if (std::regex_search(introspectionData, match, phyRegex) && match.size() > 1) {
-            return "/net/connman/iwd/" + match.str(1);
+DBusTask<std::string> IwdManager::getAdapterObjectPathAsync(DBusEventLoop &loop) {
+    // 同一个 iwd 进程的拓扑不变，命中缓存时不需要内省
+    PropertyCache &cache = PropertyCache::global();
+    if (cache.enabled()) {
+        const std::string *cached = cache.lookup(*connection_, "/net/connman/iwd", PropertyCache::TOPOLOGY, "Adapter");
+        if (cached) {
+            co_return *cached;
         }
+    }
 
-        // 如果通过解析XML没有找到Adapter，返回默认的phy0
-        return "/net/connman/iwd/0";
+    // 根据iwd文档，Adapter的Object Path格式为/net/connman/iwd/{phy0,phy1,...}
+    auto iwdProxy =
+        sdbus::createProxy(*connection_, sdbus::ServiceName{"net.connman.iwd"}, sdbus::ObjectPath{"/net/connman/iwd"});
 
+    std::string introspectionData;
+    try {
+        introspectionData =
+            co_await dbusCallAsync<std::string>(loop, *iwdProxy, "org.freedesktop.DBus.Introspectable", "Introspect");
     } catch (const sdbus::Error &e) {
-        std::cerr << "Failed to get adapter object path: " << e.what() << std::endl;
+        diag() << "Failed to get adapter object path: " << e.what() << std::endl;
         // 返回默认路径作为后备
-        return "/net/connman/iwd/0";
+        co_return "/net/connman/iwd/0";
+    }
+
+    std::string adapterPath = adapterPathFromIntrospection(introspectionData);
+    if (adapterPath.empty()) {
+        // 内省中没有适配器节点时猜测默认的 phy0；猜测的路径不写入缓存
+        co_return "/net/connman/iwd/0";
     }
+    cache.store("/net/connman/iwd", PropertyCache::TOPOLOGY, "Adapter", adapterPath);
+    co_return adapterPath;
 }
 
-std::string IwdManager::getDeviceObjectPath() {
+DBusTask<std::string> IwdManager::getDeviceObjectPathAsync(DBusEventLoop &loop) {
     // 根据iwd文档，Device的Object Path格式为/net/connman/iwd/{phyX}/{deviceIndex}
-    // 其中phyX是adapter路径的一部分，deviceIndex是设备索引
-
-    // 检查D-Bus连接是否已初始化
-    if (!connection_) {
-        std::cerr << "D-Bus connection not initialized" << std::endl;
-        return "";
+    std::string adapterPath = co_await getAdapterObjectPathAsync(loop);
+    if (adapterPath.empty()) {
+        diag() << "Failed to get adapter object path" << std::endl;
+        co_return "";
     }
 
-    try {
-        // 首先获取adapter object path
-        std::string adapterPath = getAdapterObjectPath();
-        if (adapterPath.empty()) {
-            std::cerr << "Failed to get adapter object path" << std::endl;
-            return "";
+    PropertyCache &cache = PropertyCache::global();
+    if (cache.enabled()) {
+        if (const std::string *cached = cache.lookup(*connection_, adapterPath, PropertyCache::TOPOLOGY, "Device")) {
+            co_return *cached;
         }
+    }
 
-        // 获取adapter的内省数据以查找其下的设备
-        std::string introspectionData;
-        // 使用智能指针创建adapter代理对象
-        auto adapterProxy =
-            sdbus::createProxy(*connection_, sdbus::ServiceName{"net.connman.iwd"}, sdbus::ObjectPath{adapterPath});
-
-        adapterProxy->callMethod("Introspect")
-            .onInterface("org.freedesktop.DBus.Introspectable")
-            .storeResultsTo(introspectionData);
-
-        // 使用正则表达式查找设备节点（通常是数字）
-        std::regex deviceRegex("<node name=\"(\\d+)\"");
-        std::smatch match;
-
-        if (std::regex_search(introspectionData, match, deviceRegex) && match.size() > 1) {
-            return adapterPath + "/" + match.str(1);
-        }
-
-        // 如果没找到数字命名的节点，尝试其他可能的命名方式
-        // 在实际实现中，我们可能需要更复杂的逻辑来查找设备
-
-        // 作为后备方案，返回一个常见的设备路径
-        return adapterPath + "/1";
+    auto adapterProxy =
+        sdbus::createProxy(*connection_, sdbus::ServiceName{"net.connman.iwd"}, sdbus::ObjectPath{adapterPath});
 
+    std::string introspectionData;
+    try {
+        introspectionData = co_await dbusCallAsync<std::string>(
+            loop, *adapterProxy, "org.freedesktop.DBus.Introspectable", "Introspect"
+        );
     } catch (const sdbus::Error &e) {
-        std::cerr << "Failed to get device object path: " << e.what() << std::endl;
+        diag() << "Failed to get device object path: " << e.what() << std::endl;
         // 返回空字符串表示失败
-        return "";
+        co_return "";
+    }
+
+    std::string devicePath = devicePathFromIntrospection(adapterPath, introspectionData);
+    if (devicePath.empty()) {
+        // 同上，猜测的常见设备路径不写入缓存
+        co_return adapterPath + "/1";
     }
+    cache.store(adapterPath, PropertyCache::TOPOLOGY, "Device", devicePath);
+    co_return devicePath;
 }
 
 std::unique_ptr<Station> IwdManager::createStation() {
     // 获取设备对象路径
     std::string devicePath = getDeviceObjectPath();
     if (devicePath.empty()) {
-        std::cerr << "Failed to get device object path for Station" << std::endl;
+        diag() << "Failed to get device object path for Station" << std::endl;
         return nullptr;
     }
 
     try {
-        // 使用智能指针创建Station对象
-        return std::make_unique<Station>(devicePath);
+        // Station复用本对象的D-Bus连接
+        return std::make_unique<Station>(*connection_, devicePath);
     } catch (const std::exception &e) {
-        std::cerr << "Failed to create Station: " << e.what() << std::endl;
+        diag() << "Failed to create Station: " << e.what() << std::endl;
         return nullptr;
     }
 }
 
+DBusTask<std::unique_ptr<Station>> IwdManager::createStationAsync(DBusEventLoop &loop) {
+    std::string devicePath = co_await getDeviceObjectPathAsync(loop);
+    if (devicePath.empty()) {
+        diag() << "Failed to get device object path for Station" << std::endl;
+        co_return nullptr;
+    }
+
+    co_return std::make_unique<Station>(*connection_, devicePath);
+}
+
 bool IwdManager::connectToNetworkViaDBus(const std::string &ssid, const std::string &password) {
     // 检查D-Bus连接是否已初始化
     if (!connection_) {
@@ -151,50 +186,84 @@ bool IwdManager::connectToNetworkViaDBus(const std::string &ssid, const std::str
     }
 
     try {
-        // 创建Station对象
-        auto station = createStation();
-        if (!station) {
-            throw NetworkException("Failed to create station");
-        }
+        // 在当前线程上驱动协程版本直到完成
+        DBusEventLoop loop(*connection_);
+        return loop.run(connectToNetworkAsync(loop, ssid));
+    } catch (const sdbus::Error &e) {
+        throw DBusException("D-Bus error connecting to network: " + std::string(e.what()));
+    } catch (const NmcliException &e) {
+        // 重新抛出自定义异常
+        throw;
+    } catch (const std::exception &e) {
+        throw NetworkException("Error connecting to network: " + std::string(e.what()));
+    }
+}
 
-        // 扫描网络
-        if (!station->scan()) {
-            throw NetworkException("Failed to scan networks");
-        }
+DBusTask<bool> IwdManager::connectToNetworkAsync(DBusEventLoop &loop, const std::string &ssid) {
+    // 创建Station对象
+    std::unique_ptr<Station> station = co_await createStationAsync(loop);
+    if (!station) {
+        throw NetworkException("Failed to create station");
+    }
+
+    std::string networkPath = co_await findNetworkAsync(loop, *station, ssid);
+    co_return co_await connectNetworkAsync(loop, *station, networkPath);
+}
 
-        // 获取扫描结果
-        auto networks = station->getOrderedNetworks();
+DBusTask<std::string> IwdManager::findNetworkAsync(DBusEventLoop &loop, Station &station, const std::string &ssid) {
+    // 扫描网络并等待扫描完成，超时后使用已有的扫描结果；指定了 --wait 时最多等待剩余时间
+    if (!co_await station.scanAsync(loop, Deadline::global().remainingOr(std::chrono::seconds(10)))) {
+        diag() << "Scan timeout" << std::endl;
+    }
 
-        // 查找指定的网络
-        std::string networkObjectPath;
-        for (const auto &network : networks) {
-            if (network.ssid == ssid) {
-                networkObjectPath = network.object_path;
-                break;
+    // 获取扫描结果
+    auto networkList = co_await dbusCallAsync<std::vector<sdbus::Struct<sdbus::ObjectPath, int16_t>>>(
+        loop, *station.stationProxy_, "net.connman.iwd.Station", "GetOrderedNetworks"
+    );
+
+    // 查找指定的网络，名称可以来自跨进程缓存
+    PropertyCache &cache = PropertyCache::global();
+    const bool cached = cache.covers("net.connman.iwd.Network", "Name");
+    for (const auto &[objPath, signalStrength] : networkList) {
+        if (cached) {
+            if (const std::string *name = cache.lookup(*connection_, objPath, "net.connman.iwd.Network", "Name")) {
+                if (*name == ssid) {
+                    co_return std::string(objPath);
+                }
+                continue;
             }
         }
 
-        if (networkObjectPath.empty()) {
-            throw NetworkException("Network '" + ssid + "' not found");
+        auto proxy = sdbus::createProxy(*connection_, sdbus::ServiceName{"net.connman.iwd"}, objPath);
+        sdbus::Variant name = co_await dbusCallAsync<sdbus::Variant>(
+            loop, *proxy, "org.freedesktop.DBus.Properties", "Get", std::string("net.connman.iwd.Network"),
+            std::string("Name")
+        );
+        if (!name.containsValueOfType<std::string>()) {
+            continue;
         }
+        if (cached) {
+            cache.store(objPath, "net.connman.iwd.Network", "Name", name.get<std::string>());
+        }
+        if (name.get<std::string>() == ssid) {
+            co_return std::string(objPath);
+        }
+    }
 
-        // 创建网络代理对象
-        auto networkProxy = sdbus::createProxy(
-            *connection_, sdbus::ServiceName{"net.connman.iwd"}, sdbus::ObjectPath{networkObjectPath}
-        );
+    throw NetworkException("Network '" + ssid + "' not found");
+}
 
-        // 调用Connect方法连接网络
-        networkProxy->callMethod("Connect").onInterface("net.connman.iwd.Network");
+DBusTask<bool> IwdManager::connectNetworkAsync(DBusEventLoop &loop, Station &station, const std::string &networkPath) {
+    auto networkProxy =
+        sdbus::createProxy(*connection_, sdbus::ServiceName{"net.connman.iwd"}, sdbus::ObjectPath{networkPath});
 
-        return true;
-    } catch (const sdbus::Error &e) {
-        throw DBusException("D-Bus error connecting to network: " + std::string(e.what()));
-    } catch (const NmcliException &e) {
-        // 重新抛出自定义异常
-        throw;
-    } catch (const std::exception &e) {
-        throw NetworkException("Error connecting to network: " + std::string(e.what()));
-    }
+    // 调用Connect方法连接网络，并等待Station进入connected状态
+    co_await dbusCallAsync<>(loop, *networkProxy, "net.connman.iwd.Network", "Connect");
+
+    co_return co_await DBusPropertyWait(
+        loop, *station.stationProxy_, "net.connman.iwd.Station", "State",
+        DBusPropertyWait::equals<std::string>("connected"), Deadline::global().remainingOr(std::chrono::seconds(30))
+    );
 }
 
 bool IwdManager::connectToNetworkViaIWCTL(const std::string &ssid, const std::string &password) {
@@ -243,7 +312,7 @@ bool IwdManager::connectToNetworkViaIWCTL(const std::string &ssid, const std::st
 bool IwdManager::getWifiRadioState() {
     // 检查D-Bus连接是否已初始化
     if (!connection_) {
-        std::cerr << "D-Bus connection not initialized" << std::endl;
+        diag() << "D-Bus connection not initialized" << std::endl;
         return false;
     }
 
@@ -251,7 +320,7 @@ bool IwdManager::getWifiRadioState() {
         // 获取适配器对象路径
         std::string adapterPath = getAdapterObjectPath();
         if (adapterPath.empty()) {
-            std::cerr << "Failed to get adapter object path" << std::endl;
+            diag() << "Failed to get adapter object path" << std::endl;
             return false;
         }
 
@@ -260,11 +329,14 @@ bool IwdManager::getWifiRadioState() {
             sdbus::createProxy(*connection_, sdbus::ServiceName{"net.connman.iwd"}, sdbus::ObjectPath{adapterPath});
 
         // 获取Powered属性
-        bool powered = adapterProxy->getProperty("Powered").onInterface("net.connman.iwd.Adapter").get<bool>();
+        sdbus::Variant powered = dbusCall<sdbus::Variant>(
+            *adapterProxy, "org.freedesktop.DBus.Properties", "Get", "reading radio state",
+            std::string("net.connman.iwd.Adapter"), std::string("Powered")
+        );
 
-        return powered;
+        return powered.get<bool>();
     } catch (const sdbus::Error &e) {
-        std::cerr << "Failed to get WiFi radio state: " << e.what() << std::endl;
+        diag() << "Failed to get WiFi radio state: " << e.what() << std::endl;
         return false;
     }
 }
@@ -272,28 +344,367 @@ bool IwdManager::getWifiRadioState() {
 bool IwdManager::setWifiRadioState(bool enabled) {
     // 检查D-Bus连接是否已初始化
     if (!connection_) {
-        std::cerr << "D-Bus connection not initialized" << std::endl;
+        diag() << "D-Bus connection not initialized" << std::endl;
         return false;
     }
 
     try {
-        // 获取适配器对象路径
-        std::string adapterPath = getAdapterObjectPath();
-        if (adapterPath.empty()) {
-            std::cerr << "Failed to get adapter object path" << std::endl;
+        DBusEventLoop loop(*connection_);
+        if (!loop.run(setWifiRadioStateAsync(loop, enabled))) {
+            diag() << "Timed out waiting for WiFi radio state to change" << std::endl;
             return false;
         }
+        return true;
+    } catch (const sdbus::Error &e) {
+        diag() << "Failed to set WiFi radio state via D-Bus: " << e.what() << std::endl;
+        return false;
+    }
+}
 
-        // 创建适配器代理对象
-        auto adapterProxy =
-            sdbus::createProxy(*connection_, sdbus::ServiceName{"net.connman.iwd"}, sdbus::ObjectPath{adapterPath});
+DBusTask<bool> IwdManager::setWifiRadioStateAsync(DBusEventLoop &loop, bool enabled) {
+    // 获取适配器对象路径
+    std::string adapterPath = co_await getAdapterObjectPathAsync(loop);
+    if (adapterPath.empty()) {
+        diag() << "Failed to get adapter object path" << std::endl;
+        co_return false;
+    }
+
+    // 创建适配器代理对象
+    auto adapterProxy =
+        sdbus::createProxy(*connection_, sdbus::ServiceName{"net.connman.iwd"}, sdbus::ObjectPath{adapterPath});
+
+    // 设置Powered属性，再等待属性变化生效
+    co_await dbusCallAsync<>(
+        loop, *adapterProxy, "org.freedesktop.DBus.Properties", "Set", std::string("net.connman.iwd.Adapter"),
+        std::string("Powered"), sdbus::Variant(enabled)
+    );
+
+    co_return co_await DBusPropertyWait(
+        loop, *adapterProxy, "net.connman.iwd.Adapter", "Powered", DBusPropertyWait::equals(enabled),
+        Deadline::global().remainingOr(std::chrono::seconds(10))
+    );
+}
 
-        // 设置Powered属性
-        adapterProxy->setProperty("Powered").onInterface("net.connman.iwd.Adapter").toValue(enabled);
+DBusTask<std::optional<IwdManager::RadioPowerUp>> IwdManager::powerUpWifiAsync(DBusEventLoop &loop) {
+    using Clock = std::chrono::steady_clock;
 
+    RadioPowerUp result;
+    result.start = Clock::now();
+    // 三段等待共用一个期限
+    const Clock::time_point end = result.start + Deadline::global().remainingOr(std::chrono::seconds(10));
+
+    std::string adapterPath = co_await getAdapterObjectPathAsync(loop);
+    if (adapterPath.empty()) {
+        throw NetworkException("No WiFi adapter found");
+    }
+
+    auto adapterProxy =
+        sdbus::createProxy(*connection_, sdbus::ServiceName{"net.connman.iwd"}, sdbus::ObjectPath{adapterPath});
+    co_await dbusCallAsync<>(
+        loop, *adapterProxy, "org.freedesktop.DBus.Properties", "Set", std::string(IwdAdapterProperties::INTERFACE),
+        std::string("Powered"), sdbus::Variant(true)
+    );
+    if (!co_await DBusPropertyWait(
+            loop, *adapterProxy, IwdAdapterProperties::INTERFACE, "Powered", DBusPropertyWait::equals(true),
+            std::max<Clock::duration>(end - Clock::now(), Clock::duration(1))
+        )) {
+        co_return std::nullopt;
+    }
+    result.powered = Clock::now();
+
+    // 开启后 iwd 才在适配器路径下创建 Device/Station 对象
+    auto rootProxy = sdbus::createProxy(*connection_, sdbus::ServiceName{"net.connman.iwd"}, sdbus::ObjectPath{"/"});
+    const std::string stationPath = co_await DBusInterfaceWait(
+        loop, *rootProxy, IwdStationProperties::INTERFACE, adapterPath + "/",
+        std::max<Clock::duration>(end - Clock::now(), Clock::duration(1))
+    );
+    if (stationPath.empty()) {
+        co_return std::nullopt;
+    }
+    result.station = Clock::now();
+
+    auto stationProxy =
+        sdbus::createProxy(*connection_, sdbus::ServiceName{"net.connman.iwd"}, sdbus::ObjectPath{stationPath});
+    auto stateKnown = [&result](const sdbus::Variant &value) {
+        if (!value.containsValueOfType<std::string>() || value.get<std::string>().empty()) {
+            return false;
+        }
+        result.state = value.get<std::string>();
         return true;
+    };
+    if (!co_await DBusPropertyWait(
+            loop, *stationProxy, IwdStationProperties::INTERFACE, "State", stateKnown,
+            std::max<Clock::duration>(end - Clock::now(), Clock::duration(1))
+        )) {
+        co_return std::nullopt;
+    }
+    result.ready = Clock::now();
+
+    // Station 与 Device 在同一对象上
+    sdbus::Variant name = co_await dbusCallAsync<sdbus::Variant>(
+        loop, *stationProxy, "org.freedesktop.DBus.Properties", "Get", std::string(IwdDeviceProperties::INTERFACE),
+        std::string("Name")
+    );
+    result.device = iwdPropertyValue<std::string>(name, IwdDeviceProperties::INTERFACE, "Name");
+    co_return result;
+}
+
+DBusTask<std::vector<IwdManager::KnownNetwork>> IwdManager::listKnownNetworksAsync(DBusEventLoop &loop) {
+    auto rootProxy = sdbus::createProxy(*connection_, sdbus::ServiceName{"net.connman.iwd"}, sdbus::ObjectPath{"/"});
+    ManagedObjects objects =
+        co_await dbusCallAsync<ManagedObjects>(loop, *rootProxy, "org.freedesktop.DBus.ObjectManager", "GetManagedObjects");
+
+    std::vector<KnownNetwork> networks;
+    for (const auto &[path, interfaces] : objects) {
+        auto known = interfaces.find(IwdKnownNetworkProperties::INTERFACE);
+        if (known == interfaces.end()) {
+            continue;
+        }
+
+        // 属性不完整的对象（例如 iwd 正在创建它）只跳过这一个，不影响整个列表
+        IwdKnownNetworkProperties properties;
+        try {
+            properties = IwdKnownNetworkProperties::decode(known->second);
+        } catch (const DBusException &e) {
+            diag() << "Skipping known network " << std::string(path) << ": " << e.what() << std::endl;
+            continue;
+        }
+        KnownNetwork network;
+        network.path = path;
+        network.name = std::move(properties.name);
+        network.type = std::move(properties.type);
+        network.last_connected = properties.last_connected_time.value_or("");
+        networks.push_back(std::move(network));
+    }
+
+    co_return networks;
+}
+
+DBusTask<std::string> IwdManager::forgetKnownNetworkAsync(DBusEventLoop &loop, std::string path) {
+    auto proxy = sdbus::createProxy(*connection_, sdbus::ServiceName{"net.connman.iwd"}, sdbus::ObjectPath{path});
+
+    std::string error;
+    try {
+        co_await dbusCallAsync<>(loop, *proxy, "net.connman.iwd.KnownNetwork", "Forget");
     } catch (const sdbus::Error &e) {
-        std::cerr << "Failed to set WiFi radio state via D-Bus: " << e.what() << std::endl;
-        return false;
+        error = e.getMessage().empty() ? e.getName() : e.getMessage();
+    }
+    co_return error;
+}
+
+DBusTask<std::vector<IwdManager::KnownCandidate>> IwdManager::getKnownCandidatesAsync(
+    DBusEventLoop &loop, Station &station
+) {
+    // 一次 GetManagedObjects 取回所有 Network 和 KnownNetwork 对象的属性，不再逐个读取
+    auto rootProxy = sdbus::createProxy(*connection_, sdbus::ServiceName{"net.connman.iwd"}, sdbus::ObjectPath{"/"});
+    ManagedObjects objects =
+        co_await dbusCallAsync<ManagedObjects>(loop, *rootProxy, "org.freedesktop.DBus.ObjectManager", "GetManagedObjects");
+
+    auto networkList = co_await dbusCallAsync<std::vector<sdbus::Struct<sdbus::ObjectPath, int16_t>>>(
+        loop, *station.stationProxy_, "net.connman.iwd.Station", "GetOrderedNetworks"
+    );
+
+    std::vector<KnownCandidate> candidates;
+    for (const auto &[objPath, signalStrength] : networkList) {
+        auto object = objects.find(objPath);
+        if (object == objects.end()) {
+            continue;
+        }
+        auto network = object->second.find(IwdNetworkProperties::INTERFACE);
+        if (network == object->second.end()) {
+            continue;
+        }
+        // 属性不完整的对象只跳过这一个候选
+        IwdNetworkProperties networkProperties;
+        try {
+            networkProperties = IwdNetworkProperties::decode(network->second);
+        } catch (const DBusException &e) {
+            diag() << "Skipping network " << std::string(objPath) << ": " << e.what() << std::endl;
+            continue;
+        }
+
+        // 只有已知网络才有 KnownNetwork 属性
+        if (!networkProperties.known_network) {
+            continue;
+        }
+        auto knownObject = objects.find(*networkProperties.known_network);
+        if (knownObject == objects.end()) {
+            continue;
+        }
+        auto known = knownObject->second.find(IwdKnownNetworkProperties::INTERFACE);
+        if (known == knownObject->second.end()) {
+            continue;
+        }
+        IwdKnownNetworkProperties knownProperties;
+        try {
+            knownProperties = IwdKnownNetworkProperties::decode(known->second);
+        } catch (const DBusException &e) {
+            diag() << "Skipping known network " << std::string(knownObject->first) << ": " << e.what() << std::endl;
+            continue;
+        }
+
+        // 尊重用户关闭的自动连接
+        if (!knownProperties.auto_connect) {
+            continue;
+        }
+
+        KnownCandidate candidate;
+        candidate.network_path = objPath;
+        candidate.ssid = std::move(networkProperties.name);
+        candidate.security = std::move(networkProperties.type);
+        candidate.signal = signalStrength;
+        candidate.last_connected = knownProperties.last_connected_time.value_or("");
+        candidates.push_back(std::move(candidate));
     }
-}
\ No newline at end of file
+
+    // 先按信号分档，同档内最近连接过的优先（ISO 8601 时间可以直接按字符串比较），最后按精确信号强度
+    std::sort(candidates.begin(), candidates.end(), [](const KnownCandidate &a, const KnownCandidate &b) {
+        if (signalBucket(a.signal) != signalBucket(b.signal)) {
+            return signalBucket(a.signal) > signalBucket(b.signal);
+        }
+        if (a.last_connected != b.last_connected) {
+            return a.last_connected > b.last_connected;
+        }
+        return a.signal > b.signal;
+    });
+
+    co_return candidates;
+}
+
+DBusTask<std::string> IwdManager::connectBestAsync(DBusEventLoop &loop, Station &station, int *attempts) {
+    // 先使用已有的扫描结果以免等待扫描，没有可用的已知网络时再扫描一次
+    for (int pass = 0; pass < 2; ++pass) {
+        if (pass > 0) {
+            if (!co_await station.scanAsync(loop, Deadline::global().remainingOr(std::chrono::seconds(10)))) {
+                diag() << "Scan timeout" << std::endl;
+            }
+        }
+
+        std::vector<KnownCandidate> candidates = co_await getKnownCandidatesAsync(loop, station);
+        for (const auto &candidate : candidates) {
+            if (attempts) {
+                ++*attempts;
+            }
+
+            auto networkProxy = sdbus::createProxy(
+                *connection_, sdbus::ServiceName{"net.connman.iwd"}, sdbus::ObjectPath{candidate.network_path}
+            );
+
+            std::optional<sdbus::Error> error;
+            try {
+                co_await dbusCallAsync<>(loop, *networkProxy, "net.connman.iwd.Network", "Connect");
+            } catch (const sdbus::Error &e) {
+                error = e;
+            }
+
+            // iwd 已经在自动连接或已连接到该网络时不再抢占，等待它完成；其他错误换下一个候选
+            if (error && error->getName() != "net.connman.iwd.InProgress" &&
+                error->getName() != "net.connman.iwd.AlreadyConnected") {
+                diag() << "Failed to connect to '" << candidate.ssid << "': " << error->getMessage() << std::endl;
+                continue;
+            }
+
+            bool connected = co_await DBusPropertyWait(
+                loop, *station.stationProxy_, "net.connman.iwd.Station", "State",
+                DBusPropertyWait::equals<std::string>("connected"),
+                Deadline::global().remainingOr(std::chrono::seconds(30))
+            );
+            if (!connected) {
+                continue;
+            }
+
+            // 读取实际连接的网络，iwd 自动连接的网络可能不是这个候选
+            sdbus::Variant connectedPath = co_await dbusCallAsync<sdbus::Variant>(
+                loop, *station.stationProxy_, "org.freedesktop.DBus.Properties", "Get",
+                std::string("net.connman.iwd.Station"), std::string("ConnectedNetwork")
+            );
+            if (connectedPath.containsValueOfType<sdbus::ObjectPath>() &&
+                connectedPath.get<sdbus::ObjectPath>() != candidate.network_path) {
+                auto connectedProxy = sdbus::createProxy(
+                    *connection_, sdbus::ServiceName{"net.connman.iwd"}, connectedPath.get<sdbus::ObjectPath>()
+                );
+                sdbus::Variant name = co_await dbusCallAsync<sdbus::Variant>(
+                    loop, *connectedProxy, "org.freedesktop.DBus.Properties", "Get",
+                    std::string("net.connman.iwd.Network"), std::string("Name")
+                );
+                co_return name.containsValueOfType<std::string>() ? name.get<std::string>() : candidate.ssid;
+            }
+            co_return candidate.ssid;
+        }
+    }
+
+    co_return "";
+}
+
+DBusTask<void> IwdManager::watchAndReconnectAsync(
+    DBusEventLoop &loop, Station &station, std::function<void(const ReconnectEvent &)> on_reconnect
+) {
+    const DBusPropertyWait::Predicate disconnected = stateIn({"disconnecting", "disconnected"});
+    const DBusPropertyWait::Predicate settled = stateIn({"disconnected", "connecting", "connected"});
+    const DBusPropertyWait::Predicate decided = stateIn({"disconnected", "connected"});
+    const DBusPropertyWait::Predicate connected = stateIn({"connected", "roaming"});
+
+    // 启动时尚未连接的那次连接不是重连，第一次进入 connected 状态之后才开始计数；
+    // 启动时正在连接、断开或漫游的，先等它有结果再判断
+    co_await DBusPropertyWait(
+        loop, *station.stationProxy_, "net.connman.iwd.Station", "State", decided, std::chrono::seconds(30)
+    );
+    sdbus::Variant initial = co_await dbusCallAsync<sdbus::Variant>(
+        loop, *station.stationProxy_, "org.freedesktop.DBus.Properties", "Get", std::string("net.connman.iwd.Station"),
+        std::string("State")
+    );
+    bool was_connected = connected(initial);
+
+    // 断开的时间和已尝试的次数在出错重试时保留，报告的耗时仍从断开算起
+    std::optional<DBusEventLoop::Clock::time_point> start;
+    ReconnectEvent event;
+    event.attempts = 0;
+
+    while (true) {
+        // 常驻监视不因一次 D-Bus 错误结束（扫描被拒、断开期间对象消失、GetManagedObjects 失败等），
+        // 报告后稍等再从头重试；--wait 预算耗尽的 TimeoutException 照常结束
+        std::string error;
+        try {
+            if (!start) {
+                // 等待断开，当前未连接时立即返回
+                co_await DBusPropertyWait(
+                    loop, *station.stationProxy_, "net.connman.iwd.Station", "State", disconnected
+                );
+                start = DBusEventLoop::Clock::now();
+
+                // disconnecting 期间 iwd 会拒绝 Connect，等它结束
+                co_await DBusPropertyWait(
+                    loop, *station.stationProxy_, "net.connman.iwd.Station", "State", settled, std::chrono::seconds(5)
+                );
+            }
+
+            while (event.ssid.empty()) {
+                event.ssid = co_await connectBestAsync(loop, station, &event.attempts);
+                if (event.ssid.empty()) {
+                    // 范围内没有可用的已知网络，稍后重试
+                    co_await loop.sleepFor(std::chrono::seconds(2));
+                }
+            }
+        } catch (const sdbus::Error &e) {
+            error = e.getMessage().empty() ? e.getName() : e.getName() + ": " + e.getMessage();
+        } catch (const TimeoutException &) {
+            throw;
+        } catch (const NmcliException &e) {
+            error = e.what();
+        }
+        if (!error.empty()) {
+            diag() << "Reconnect watch error, retrying: " << error << std::endl;
+            co_await loop.sleepFor(std::chrono::seconds(2));
+            continue;
+        }
+
+        event.elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(DBusEventLoop::Clock::now() - *start);
+        if (was_connected) {
+            on_reconnect(event);
+        }
+        was_connected = true;
+        start.reset();
+        event = ReconnectEvent{};
+        event.attempts = 0;
+    }
+}
@@ -0,0 +1,139 @@
+#include "link_sampler.h"
+#include "instrumentation.h"
+#include "trace.h"
+
+#include <netlink/netlink.h>
+#include <netlink/genl/genl.h>
+#include <linux/nl80211.h>
+#include <net/if.h>
+#include <cstring>
+#include <ctime>
+
+namespace {
+
+// 单个 AP 的 station 信息通常不到 1KB，32KB 足以容纳一次完整的 dump
+constexpr size_t RECV_BUFFER_SIZE = 32 * 1024;
+
+uint64_t monotonicNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+uint32_t parseBitrate(struct nlattr *attr) {
+    struct nlattr *rate[NL80211_RATE_INFO_MAX + 1];
+    if (nla_parse_nested(rate, NL80211_RATE_INFO_MAX, attr, nullptr) < 0) {
+        return 0;
+    }
+    if (rate[NL80211_RATE_INFO_BITRATE32]) {
+        return nla_get_u32(rate[NL80211_RATE_INFO_BITRATE32]);
+    }
+    if (rate[NL80211_RATE_INFO_BITRATE]) {
+        return nla_get_u16(rate[NL80211_RATE_INFO_BITRATE]);
+    }
+    return 0;
+}
+
+// 直接在接收缓冲区上解析一条 station 消息，不复制、不分配
+bool parseStation(struct nlmsghdr *nlh, LinkSampler::Sample &out) {
+    struct genlmsghdr *gnlh = static_cast<struct genlmsghdr *>(nlmsg_data(nlh));
+    struct nlattr *tb[NL80211_ATTR_MAX + 1];
+    if (nla_parse(tb, NL80211_ATTR_MAX, genlmsg_attrdata(gnlh, 0), genlmsg_attrlen(gnlh, 0), nullptr) < 0) {
+        return false;
+    }
+
+    if (!tb[NL80211_ATTR_MAC] || !tb[NL80211_ATTR_STA_INFO]) {
+        return false;
+    }
+
+    struct nlattr *sinfo[NL80211_STA_INFO_MAX + 1];
+    if (nla_parse_nested(sinfo, NL80211_STA_INFO_MAX, tb[NL80211_ATTR_STA_INFO], nullptr) < 0) {
+        return false;
+    }
+
+    std::memcpy(out.bssid, nla_data(tb[NL80211_ATTR_MAC]), sizeof(out.bssid));
+
+    if (sinfo[NL80211_STA_INFO_SIGNAL]) {
+        out.signal = static_cast<int8_t>(nla_get_u8(sinfo[NL80211_STA_INFO_SIGNAL]));
+    }
+    if (sinfo[NL80211_STA_INFO_SIGNAL_AVG]) {
+        out.signal_avg = static_cast<int8_t>(nla_get_u8(sinfo[NL80211_STA_INFO_SIGNAL_AVG]));
+    }
+    if (sinfo[NL80211_STA_INFO_TX_BITRATE]) {
+        out.tx_bitrate = parseBitrate(sinfo[NL80211_STA_INFO_TX_BITRATE]);
+    }
+    if (sinfo[NL80211_STA_INFO_RX_BITRATE]) {
+        out.rx_bitrate = parseBitrate(sinfo[NL80211_STA_INFO_RX_BITRATE]);
+    }
+    if (sinfo[NL80211_STA_INFO_TX_RETRIES]) {
+        out.tx_retries = nla_get_u32(sinfo[NL80211_STA_INFO_TX_RETRIES]);
+    }
+    if (sinfo[NL80211_STA_INFO_TX_FAILED]) {
+        out.tx_failed = nla_get_u32(sinfo[NL80211_STA_INFO_TX_FAILED]);
+    }
+    if (sinfo[NL80211_STA_INFO_BEACON_LOSS]) {
+        out.beacon_loss = nla_get_u32(sinfo[NL80211_STA_INFO_BEACON_LOSS]);
+    }
+
+    return true;
+}
+
+} // namespace
+
+void LinkSampler::MsgDeleter::operator()(struct nl_msg *msg) const {
+    if (msg) {
+        nlmsg_free(msg);
+    }
+}
+
+LinkSampler::LinkSampler(const std::string &ifname)
+    : ifname_(ifname), request_(nlmsg_alloc()), exchange_(RECV_BUFFER_SIZE, "station info"),
+      latency_(Instrumentation::histogram("netlink", "NL80211_CMD_GET_STATION")) {
+    // 回放时接口不必存在
+    unsigned int ifindex = if_nametoindex(ifname.c_str());
+    if (ifindex == 0 && !Trace::global().replaying()) {
+        throw NetworkException("Unknown interface '" + ifname + "'");
+    }
+
+    if (!request_) {
+        throw NetworkException("Failed to allocate netlink message");
+    }
+
+    // 请求消息只构造一次，之后每次采样只更新序列号
+    genlmsg_put(request_.get(), NL_AUTO_PORT, 0, client_.familyId(), 0, NLM_F_DUMP, NL80211_CMD_GET_STATION, 0);
+    nla_put_u32(request_.get(), NL80211_ATTR_IFINDEX, ifindex);
+    nl_complete_msg(client_.socket(), request_.get());
+}
+
+LinkSampler::~LinkSampler() = default;
+
+bool LinkSampler::sample(Sample &out) {
+    const uint64_t start = monotonicNs();
+
+    out = Sample{};
+    out.timestamp_ns = start;
+
+    bool found = false;
+    const uint64_t elapsed = exchange_.run(
+        nl_socket_get_fd(client_.socket()), nlmsg_hdr(request_.get()), "NL80211_CMD_GET_STATION", ifname_,
+        [&](struct nlmsghdr *nlh) {
+            // station 模式下 dump 只会返回当前关联的 AP
+            if (!found) {
+                found = parseStation(nlh, out);
+            }
+        }
+    );
+    // 回放不计入采样开销
+    if (Trace::global().replaying()) {
+        return found;
+    }
+
+    overhead_.samples++;
+    overhead_.total_ns += elapsed;
+    if (elapsed > overhead_.max_ns) {
+        overhead_.max_ns = elapsed;
+    }
+    latency_.record(elapsed);
+
+    return found;
+}
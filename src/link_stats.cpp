@@ -0,0 +1,211 @@
+#include "link_stats.h"
+#include "rtnl_dump.h"
+
+#include <netlink/netlink.h>
+#include <netlink/msg.h>
+#include <netlink/attr.h>
+#include <linux/rtnetlink.h>
+#include <linux/if_link.h>
+#include <algorithm>
+#include <cstring>
+#include <ctime>
+
+namespace {
+
+// 内核每次 dump 最多填满 32KB 左右的 skb，接收缓冲区留出余量
+constexpr size_t RECV_BUFFER_SIZE = 64 * 1024;
+
+// 名称和运行状态的刷新间隔，接口集合变化时立即刷新
+constexpr uint64_t REFRESH_INTERVAL_NS = 1000000000ull;
+
+// 录制时与 listDevices 的 RTM_GETLINK 区分开
+constexpr const char *TRACE_KEY = "stats";
+
+uint64_t monotonicNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+// 计数器回绕或接口被重建时不产生巨大的增量
+uint64_t delta(uint64_t current, uint64_t previous) {
+    return current >= previous ? current - previous : 0;
+}
+
+} // namespace
+
+void LinkStatsSampler::SocketDeleter::operator()(struct nl_sock *sock) const {
+    if (sock) {
+        nl_close(sock);
+        nl_socket_free(sock);
+    }
+}
+
+LinkStatsSampler::LinkStatsSampler()
+    : sock_(nl_socket_alloc()), stats_request_(new unsigned char[NLMSG_SPACE(sizeof(struct if_stats_msg))]),
+      link_request_(new unsigned char[NLMSG_SPACE(sizeof(struct ifinfomsg)) + RTA_SPACE(sizeof(uint32_t))]),
+      exchange_(RECV_BUFFER_SIZE, "interface statistics"),
+      latency_(Instrumentation::histogram("netlink", "RTM_GETSTATS")) {
+    if (!sock_) {
+        throw NetworkException("Failed to allocate netlink socket");
+    }
+    if (nl_connect(sock_.get(), NETLINK_ROUTE) < 0) {
+        throw NetworkException("Failed to connect to rtnetlink");
+    }
+
+    // 两个请求都只构造一次，之后每次 dump 只更新序列号
+    std::memset(stats_request_.get(), 0, NLMSG_SPACE(sizeof(struct if_stats_msg)));
+    auto *stats = reinterpret_cast<struct nlmsghdr *>(stats_request_.get());
+    stats->nlmsg_len = NLMSG_LENGTH(sizeof(struct if_stats_msg));
+    stats->nlmsg_type = RTM_GETSTATS;
+    stats->nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+    auto *ifsm = static_cast<struct if_stats_msg *>(NLMSG_DATA(stats));
+    ifsm->family = AF_UNSPEC;
+    ifsm->filter_mask = IFLA_STATS_FILTER_BIT(IFLA_STATS_LINK_64);
+
+    // 刷新名称时不需要 IFLA_STATS/IFLA_STATS64，较新的内核可以跳过它们
+    const size_t link_size = NLMSG_SPACE(sizeof(struct ifinfomsg)) + RTA_SPACE(sizeof(uint32_t));
+    std::memset(link_request_.get(), 0, link_size);
+    auto *link = reinterpret_cast<struct nlmsghdr *>(link_request_.get());
+    link->nlmsg_len = static_cast<uint32_t>(link_size);
+    link->nlmsg_type = RTM_GETLINK;
+    link->nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+    static_cast<struct ifinfomsg *>(NLMSG_DATA(link))->ifi_family = AF_UNSPEC;
+    auto *ext_mask = reinterpret_cast<struct rtattr *>(link_request_.get() + NLMSG_SPACE(sizeof(struct ifinfomsg)));
+    ext_mask->rta_type = IFLA_EXT_MASK;
+    ext_mask->rta_len = RTA_LENGTH(sizeof(uint32_t));
+    const uint32_t filter = RTEXT_FILTER_SKIP_STATS;
+    std::memcpy(RTA_DATA(ext_mask), &filter, sizeof(filter));
+
+    present_.reserve(64);
+}
+
+LinkStatsSampler::~LinkStatsSampler() = default;
+
+void LinkStatsSampler::ensureCapacity(int ifindex) {
+    const size_t needed = static_cast<size_t>(ifindex) + 1;
+    if (needed > links_.size()) {
+        // ifindex 单调增长（容器频繁创建 veth 时尤其如此），按倍数扩容以免每个新接口都搬移一次
+        const size_t capacity = std::max(needed, links_.size() * 2);
+        links_.resize(capacity);
+    }
+}
+
+void LinkStatsSampler::refreshLinks() {
+    ++generation_;
+    const int fd = nl_socket_get_fd(sock_.get());
+    auto *request = reinterpret_cast<struct nlmsghdr *>(link_request_.get());
+    exchange_.run(fd, request, "RTM_GETLINK", TRACE_KEY, [this](struct nlmsghdr *nlh) {
+        if (nlh->nlmsg_type != RTM_NEWLINK) {
+            return;
+        }
+        auto *ifi = static_cast<struct ifinfomsg *>(nlmsg_data(nlh));
+        struct nlattr *tb[IFLA_MAX + 1];
+        if (ifi->ifi_index <= 0 || nlmsg_parse(nlh, sizeof(*ifi), tb, IFLA_MAX, nullptr) < 0 || !tb[IFLA_IFNAME]) {
+            return;
+        }
+
+        ensureCapacity(ifi->ifi_index);
+        Link &link = links_[ifi->ifi_index];
+        const char *name = nla_get_string(tb[IFLA_IFNAME]);
+        // 同一 ifindex 换了名字只可能是接口被重建，旧计数器不再可比
+        if (!link.present || link.name != name) {
+            link.has_baseline = false;
+        }
+        link.present = true;
+        link.generation = generation_;
+        link.name = name;
+
+        const char *kind = nullptr;
+        if (tb[IFLA_LINKINFO]) {
+            struct nlattr *info[IFLA_INFO_MAX + 1];
+            if (nla_parse_nested(info, IFLA_INFO_MAX, tb[IFLA_LINKINFO], nullptr) >= 0 && info[IFLA_INFO_KIND]) {
+                kind = nla_get_string(info[IFLA_INFO_KIND]);
+            }
+        }
+        link.type = RtnlDump::linkType(kind, ifi->ifi_type, link.name);
+        link.state = RtnlDump::operstateToString(tb[IFLA_OPERSTATE] ? nla_get_u8(tb[IFLA_OPERSTATE]) : 0);
+    });
+
+    present_.clear();
+    for (size_t ifindex = 0; ifindex < links_.size(); ++ifindex) {
+        Link &link = links_[ifindex];
+        if (link.present && link.generation != generation_) {
+            link.present = false;
+            link.has_baseline = false;
+        }
+        if (link.present) {
+            present_.push_back(static_cast<int>(ifindex));
+        }
+    }
+    last_refresh_ns_ = monotonicNs();
+}
+
+void LinkStatsSampler::sample() {
+    if (last_refresh_ns_ == 0) {
+        refreshLinks();
+    }
+
+    const uint64_t now = monotonicNs();
+    const double seconds = last_sample_ns_ ? static_cast<double>(now - last_sample_ns_) / 1e9 : 0.0;
+    last_sample_ns_ = now;
+
+    size_t seen_count = 0;
+    bool unknown = false;
+
+    const int fd = nl_socket_get_fd(sock_.get());
+    auto *request = reinterpret_cast<struct nlmsghdr *>(stats_request_.get());
+    const uint64_t elapsed = exchange_.run(fd, request, "RTM_GETSTATS", TRACE_KEY, [&](struct nlmsghdr *nlh) {
+        if (nlh->nlmsg_type != RTM_NEWSTATS) {
+            return;
+        }
+        const auto *ifsm = static_cast<const struct if_stats_msg *>(nlmsg_data(nlh));
+        const int ifindex = static_cast<int>(ifsm->ifindex);
+        if (ifindex <= 0 || static_cast<size_t>(ifindex) >= links_.size() || !links_[ifindex].present) {
+            // 上次刷新之后出现的接口，刷新后从下一次采样开始计算
+            unknown = true;
+            return;
+        }
+
+        struct nlattr *attr = nlmsg_find_attr(nlh, sizeof(*ifsm), IFLA_STATS_LINK_64);
+        if (!attr || nla_len(attr) < static_cast<int>(sizeof(struct rtnl_link_stats64))) {
+            return;
+        }
+        // 属性只保证 4 字节对齐
+        struct rtnl_link_stats64 stats;
+        std::memcpy(&stats, nla_data(attr), sizeof(stats));
+
+        Counters current;
+        current.rx_bytes = stats.rx_bytes;
+        current.tx_bytes = stats.tx_bytes;
+        current.rx_packets = stats.rx_packets;
+        current.tx_packets = stats.tx_packets;
+        current.rx_errors = stats.rx_errors + stats.rx_dropped;
+        current.tx_errors = stats.tx_errors + stats.tx_dropped;
+
+        Link &link = links_[ifindex];
+        if (link.has_baseline && seconds > 0) {
+            const Counters &previous = link.counters;
+            link.rates.rx_bytes = static_cast<double>(delta(current.rx_bytes, previous.rx_bytes)) / seconds;
+            link.rates.tx_bytes = static_cast<double>(delta(current.tx_bytes, previous.tx_bytes)) / seconds;
+            link.rates.rx_packets = static_cast<double>(delta(current.rx_packets, previous.rx_packets)) / seconds;
+            link.rates.tx_packets = static_cast<double>(delta(current.tx_packets, previous.tx_packets)) / seconds;
+            link.rates.rx_errors = delta(current.rx_errors, previous.rx_errors);
+            link.rates.tx_errors = delta(current.tx_errors, previous.tx_errors);
+        } else {
+            link.rates = Rates{};
+        }
+        link.counters = current;
+        link.has_baseline = true;
+
+        seen_count++;
+    });
+    if (elapsed > 0) {
+        latency_.record(elapsed);
+    }
+
+    // 有接口出现或消失时立即刷新；否则每秒刷新一次状态
+    if (unknown || seen_count != present_.size() || now - last_refresh_ns_ >= REFRESH_INTERVAL_NS) {
+        refreshLinks();
+    }
+}
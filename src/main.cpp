@@ -2,31 +2,96 @@
 #include <string>
 #include <vector>
 #include <algorithm>
+#include <climits>
+#include <chrono>
+#include <cstdio>
+#include <optional>
 
 #include <network_manager.h>
 #include <iwd_manager.h>
 #include <nmcli_exception.h>
+#include "string_util.h"
+#include <deadline.h>
+#include <trace.h>
+#include <state_shm.h>
+#include <property_cache.h>
+#include <mem_stats.h>
+#include <probes.h>
 
-// Helper function to split string by delimiter
-std::vector<std::string> split(const std::string &str, char delimiter) {
-    std::vector<std::string> tokens;
-    std::string token;
-    for (char c : str) {
-        if (c == delimiter) {
-            tokens.push_back(token);
-            token.clear();
-        } else {
-            token += c;
-        }
+// Parse a whole decimal integer; a missing argument (nullptr) or trailing garbage such as "5abc" is rejected
+static bool parseInteger(const char *text, long long &out) {
+    if (!text) {
+        return false;
+    }
+    const std::string value(text);
+    size_t pos = 0;
+    try {
+        out = std::stoll(value, &pos);
+    } catch (const std::exception &) {
+        return false;
     }
-    tokens.push_back(token);
-    return tokens;
+    return pos == value.size();
 }
 
-int main(int argc, char *argv[]) {
+// Parse --interval/--count for the sampling commands: interval > 0 milliseconds, count >= 0
+static bool parseSamplingOption(const std::string &opt, const char *text, int &out) {
+    long long value = 0;
+    if (!parseInteger(text, value)) {
+        std::cerr << "Error: " << opt << " requires a number" << std::endl;
+        return false;
+    }
+    if (opt == "--interval" && (value <= 0 || value > INT_MAX)) {
+        std::cerr << "Error: --interval requires a positive number of milliseconds" << std::endl;
+        return false;
+    }
+    if (opt == "--count" && (value < 0 || value > INT_MAX)) {
+        std::cerr << "Error: --count requires a non-negative number" << std::endl;
+        return false;
+    }
+    out = static_cast<int>(value);
+    return true;
+}
+
+// Parse a duration such as "90d", "12h", "30m", "45s" or a plain number of seconds
+static bool parseDuration(const std::string &text, std::chrono::seconds &out) {
+    size_t pos = 0;
+    long long value = 0;
+    try {
+        value = std::stoll(text, &pos);
+    } catch (const std::exception &) {
+        return false;
+    }
+    if (value < 0) {
+        return false;
+    }
+
+    const std::string unit = text.substr(pos);
+    long long scale = 0;
+    if (unit.empty() || unit == "s") {
+        scale = 1;
+    } else if (unit == "m") {
+        scale = 60;
+    } else if (unit == "h") {
+        scale = 3600;
+    } else if (unit == "d") {
+        scale = 86400;
+    } else if (unit == "w") {
+        scale = 7 * 86400;
+    } else {
+        return false;
+    }
+    out = std::chrono::seconds(value * scale);
+    return true;
+}
+
+int run(int argc, char *argv[]) {
     // Check if we have enough arguments
     if (argc < 2) {
-        std::cerr << "Usage: " << argv[0] << " [-t] [-f <fields>] <command> [options]" << std::endl;
+        std::cerr << "Usage: " << argv[0]
+                  << " [-t] [-f <fields>] [-w <seconds>] [--backend <iwd|nl80211>]"
+                     " [--record|--replay|--replay-paced <file>] [--from-shm[=<file>]] [--cache[=<file>]]"
+                     " [--netns <name|all>] [--mem-stats] [--trace <file>] <command> [options]"
+                  << std::endl;
         return 1;
     }
 
@@ -35,6 +100,7 @@ int main(int argc, char *argv[]) {
 
     // Parse command line arguments
     int i = 1;
+    std::string cache_path;
     while (i < argc) {
         std::string arg = argv[i];
 
@@ -49,11 +115,124 @@ int main(int argc, char *argv[]) {
                 std::cerr << "Error: -f option requires an argument" << std::endl;
                 return 1;
             }
+        } else if (arg == "-w" || arg == "--wait") {
+            if (i + 1 < argc) {
+                double seconds = 0;
+                try {
+                    seconds = std::stod(argv[i + 1]);
+                } catch (const std::exception &) {
+                    std::cerr << "Error: --wait requires a number of seconds" << std::endl;
+                    return 1;
+                }
+                if (seconds < 0) {
+                    std::cerr << "Error: --wait requires a non-negative number of seconds" << std::endl;
+                    return 1;
+                }
+                // 0 表示不限时；预算从这里开始计时，后续每个调用只使用剩余时间
+                if (seconds > 0) {
+                    Deadline::global() = Deadline::after(
+                        std::chrono::duration_cast<Deadline::Clock::duration>(std::chrono::duration<double>(seconds))
+                    );
+                }
+                i += 2;
+            } else {
+                std::cerr << "Error: --wait option requires an argument" << std::endl;
+                return 1;
+            }
+        } else if (arg == "--backend") {
+            if (i + 1 < argc) {
+                nm.backend = argv[i + 1];
+                if (nm.backend != "iwd" && nm.backend != "nl80211") {
+                    std::cerr << "Invalid backend: " << nm.backend << ". Use 'iwd' or 'nl80211'" << std::endl;
+                    return 1;
+                }
+                i += 2;
+            } else {
+                std::cerr << "Error: --backend option requires an argument" << std::endl;
+                return 1;
+            }
+        } else if (arg == "--record" || arg == "--replay" || arg == "--replay-paced") {
+            if (i + 1 >= argc) {
+                std::cerr << "Error: " << arg << " option requires a file" << std::endl;
+                return 1;
+            }
+            Trace &trace = Trace::global();
+            if (trace.recording() || trace.replaying()) {
+                std::cerr << "Error: only one of --record, --replay and --replay-paced can be given" << std::endl;
+                return 1;
+            }
+            try {
+                if (arg == "--record") {
+                    trace.startRecording(argv[i + 1]);
+                } else {
+                    trace.loadReplay(argv[i + 1], arg == "--replay-paced");
+                }
+            } catch (const NmcliException &e) {
+                std::cerr << "Error: " << e.what() << std::endl;
+                return 1;
+            }
+            i += 2;
+        } else if (arg == "--from-shm" || arg.rfind("--from-shm=", 0) == 0) {
+            // 读取 state publish 发布的快照，不访问 iwd 和内核
+            nm.shm_path = arg == "--from-shm" ? SHM_STATE_PATH : arg.substr(std::string("--from-shm=").size());
+            if (nm.shm_path.empty()) {
+                std::cerr << "Error: --from-shm= requires a file" << std::endl;
+                return 1;
+            }
+            i++;
+        } else if (arg == "--cache" || arg.rfind("--cache=", 0) == 0) {
+            // 跨进程缓存 iwd 的拓扑和不变属性，以 iwd 的唯一总线名校验
+            cache_path = arg == "--cache" ? PropertyCache::defaultPath() : arg.substr(std::string("--cache=").size());
+            if (cache_path.empty()) {
+                std::cerr << "Error: --cache requires XDG_RUNTIME_DIR or --cache=<file>" << std::endl;
+                return 1;
+            }
+            i++;
+        } else if (arg == "--netns") {
+            if (i + 1 < argc) {
+                nm.netns = argv[i + 1];
+                i += 2;
+            } else {
+                std::cerr << "Error: --netns option requires a namespace name or 'all'" << std::endl;
+                return 1;
+            }
+        } else if (arg == "--trace") {
+            // 区间边记录边写成 Chrome trace-event JSON，退出前补上结尾；USDT 探针不需要这个选项
+            if (i + 1 < argc) {
+                if (!ChromeTrace::global().enable(argv[i + 1])) {
+                    return 1;
+                }
+                i += 2;
+            } else {
+                std::cerr << "Error: --trace option requires a file" << std::endl;
+                return 1;
+            }
+        } else if (arg == "--mem-stats") {
+            // 统计堆分配，退出前输出到 stderr
+            MemStats::enable();
+            i++;
         } else {
             break;
         }
     }
 
+    if (!cache_path.empty()) {
+        // 命中缓存的调用不会出现在追踪文件里，录制和回放时都不使用缓存
+        if (Trace::global().recording() || Trace::global().replaying()) {
+            std::cerr << "Error: --cache cannot be combined with --record or --replay" << std::endl;
+            return 1;
+        }
+        PropertyCache::global().enable(cache_path);
+    }
+
+    if (!nm.netns.empty()) {
+        // 工作线程并行读取，录制文件和快照都只描述调用者所在的命名空间
+        if (Trace::global().recording() || Trace::global().replaying() || !nm.shm_path.empty()) {
+            std::cerr << "Error: --netns cannot be combined with --record, --replay or --from-shm" << std::endl;
+            return 1;
+        }
+    }
+
     // If we've processed all arguments, that's an error
     if (i >= argc) {
         std::cerr << "Error: No command specified" << std::endl;
@@ -63,9 +242,24 @@ int main(int argc, char *argv[]) {
     // Get the command
     std::string command = argv[i];
 
+    // 整条命令是最外层的分配统计阶段，其中的 D-Bus 和 netlink 调用各自是一个阶段
+    std::string phase = command;
+    if (i + 1 < argc && argv[i + 1][0] != '-') {
+        phase += std::string(" ") + argv[i + 1];
+    }
+    MemPhase commandPhase("command", phase);
+
+    if (!nm.netns.empty() && phase != "networking connectivity" && phase != "device status" && phase != "device") {
+        std::cerr << "Error: --netns only applies to 'networking connectivity' and 'device status'" << std::endl;
+        return 1;
+    }
+
     if (command == "networking") {
         if (i + 1 < argc && std::string(argv[i + 1]) == "connectivity") {
             // Handle "nmcli networking connectivity" command
+            if (!nm.netns.empty()) {
+                return nm.showNetnsConnectivity() ? 0 : 1;
+            }
             std::cout << nm.getConnectivity() << std::endl;
             return 0;
         }
@@ -74,8 +268,48 @@ int main(int argc, char *argv[]) {
         if (i + 1 < argc) {
             std::string subcommand = argv[i + 1];
             if (subcommand == "status" || subcommand == "") {
+                // Handle "device status [--interval <ms>] [--count <n>]" command
+                int interval_ms = 0;
+                int count = 0;
+                bool has_count = false;
+                for (int j = i + 2; j < argc; j++) {
+                    std::string opt = argv[j];
+                    if (opt == "--interval" || opt == "--count") {
+                        if (!parseSamplingOption(
+                                opt, j + 1 < argc ? argv[j + 1] : nullptr, opt == "--interval" ? interval_ms : count
+                            )) {
+                            return 1;
+                        }
+                        has_count = has_count || opt == "--count";
+                        j++;
+                    } else {
+                        std::cerr << "Error: Unexpected argument '" << opt << "' for device status" << std::endl;
+                        return 1;
+                    }
+                }
+                if (has_count && interval_ms == 0) {
+                    std::cerr << "Error: --count requires --interval" << std::endl;
+                    return 1;
+                }
+
+                if (interval_ms > 0) {
+                    // 快照中没有计数器
+                    if (!nm.shm_path.empty() || !nm.netns.empty()) {
+                        std::cerr << "Error: --interval cannot be used with --from-shm or --netns" << std::endl;
+                        return 1;
+                    }
+                    return nm.monitorDeviceStats(interval_ms, count) ? 0 : 1;
+                }
+
+                if (!nm.netns.empty()) {
+                    return nm.listNetnsDevices() ? 0 : 1;
+                }
+
                 // List devices
-                auto devices = nm.listDevices();
+                std::vector<NetworkManager::DeviceInfo> devices;
+                if (!nm.listDevices(devices)) {
+                    return 1;
+                }
 
                 // Determine which fields to display
                 bool show_device = nm.field_selection.empty() ||
@@ -115,26 +349,101 @@ int main(int argc, char *argv[]) {
                 // Print formatted table
                 nm.printFormattedTable(table_data, headers);
                 return 0;
+            } else if (subcommand == "show") {
+                // Handle "nmcli device show [ifname]" command
+                std::string ifname = i + 2 < argc ? argv[i + 2] : "";
+                return nm.showDevice(ifname) ? 0 : 1;
             } else if (subcommand == "wifi") {
                 // Handle "nmcli device wifi" subcommands
                 if (i + 2 < argc) {
                     std::string wifi_subcommand = argv[i + 2];
                     if (wifi_subcommand == "list") {
-                        // Check for --rescan option
-                        bool rescan = false;
+                        // Check for --rescan, --max-age and --limit options
+                        RescanPolicy rescan = RescanPolicy::No;
+                        std::chrono::seconds max_age(30);
+                        size_t limit = 0;
                         for (int j = i + 3; j < argc; j++) {
-                            if (std::string(argv[j]) == "--rescan" || std::string(argv[j]) == "--rescan=yes") {
-                                rescan = true;
-                                break;
-                            } else if (std::string(argv[j]) == "--rescan=no") {
-                                rescan = false;
-                                break;
+                            std::string opt = argv[j];
+                            // --rescan takes yes/no/auto as the next argument or after '='; bare --rescan means yes
+                            std::string value;
+                            if (opt.rfind("--rescan=", 0) == 0) {
+                                value = opt.substr(std::string("--rescan=").size());
+                            } else if (opt == "--rescan") {
+                                value = "yes";
+                                if (j + 1 < argc) {
+                                    std::string next = argv[j + 1];
+                                    if (next == "yes" || next == "no" || next == "auto") {
+                                        value = next;
+                                        j++;
+                                    }
+                                }
+                            }
+
+                            if (!value.empty()) {
+                                if (value == "yes") {
+                                    rescan = RescanPolicy::Yes;
+                                } else if (value == "no") {
+                                    rescan = RescanPolicy::No;
+                                } else if (value == "auto") {
+                                    rescan = RescanPolicy::Auto;
+                                } else {
+                                    std::cerr << "Error: --rescan must be yes, no or auto" << std::endl;
+                                    return 1;
+                                }
+                            } else if (opt == "--max-age" && j + 1 < argc) {
+                                if (!parseDuration(argv[++j], max_age)) {
+                                    std::cerr << "Error: --max-age requires a duration such as 30 or 2m" << std::endl;
+                                    return 1;
+                                }
+                            } else if (opt == "--limit") {
+                                // 0 means no limit; "-1" must not wrap around to an unlimited size_t
+                                long long value = 0;
+                                if (!parseInteger(j + 1 < argc ? argv[j + 1] : nullptr, value) || value < 0) {
+                                    std::cerr << "Error: --limit requires a non-negative number" << std::endl;
+                                    return 1;
+                                }
+                                limit = static_cast<size_t>(value);
+                                j++;
                             }
                         }
 
                         // Handle "nmcli device wifi list" command
-                        nm.listWifiNetworks(rescan);
-                        return 0;
+                        return nm.listWifiNetworks(rescan, limit, max_age) ? 0 : 1;
+                    } else if (wifi_subcommand == "link") {
+                        // Handle "device wifi link [ifname] [--interval <ms>] [--count <n>] [--binary]" command
+                        std::string ifname;
+                        int interval_ms = 0;
+                        int count = 0;
+                        bool has_count = false;
+                        bool binary = false;
+                        for (int j = i + 3; j < argc; j++) {
+                            std::string opt = argv[j];
+                            if (opt == "--interval" || opt == "--count") {
+                                // Same rules as device status: interval > 0 when given, count >= 0
+                                if (!parseSamplingOption(
+                                        opt, j + 1 < argc ? argv[j + 1] : nullptr,
+                                        opt == "--interval" ? interval_ms : count
+                                    )) {
+                                    return 1;
+                                }
+                                has_count = has_count || opt == "--count";
+                                j++;
+                            } else if (opt == "--binary") {
+                                binary = true;
+                            } else if (opt.rfind("-", 0) == 0 || !ifname.empty()) {
+                                std::cerr << "Error: Unexpected argument '" << opt << "' for device wifi link"
+                                          << std::endl;
+                                return 1;
+                            } else {
+                                ifname = opt;
+                            }
+                        }
+                        if (has_count && interval_ms == 0) {
+                            std::cerr << "Error: --count requires --interval" << std::endl;
+                            return 1;
+                        }
+
+                        return nm.sampleWifiLink(ifname, interval_ms, count, binary) ? 0 : 1;
                     } else if (wifi_subcommand == "connect") {
                         // Handle "nmcli device wifi connect" command
                         if (i + 3 < argc) {
@@ -182,8 +491,15 @@ int main(int argc, char *argv[]) {
                 }
             }
         } else {
+            if (!nm.netns.empty()) {
+                return nm.listNetnsDevices() ? 0 : 1;
+            }
+
             // List devices (default action)
-            auto devices = nm.listDevices();
+            std::vector<NetworkManager::DeviceInfo> devices;
+            if (!nm.listDevices(devices)) {
+                return 1;
+            }
 
             // Determine which fields to display
             bool show_device =
@@ -229,12 +545,16 @@ int main(int argc, char *argv[]) {
         if (i + 1 < argc) {
             std::string subcommand = argv[i + 1];
             if (subcommand == "show") {
-                // Show connections
-                nm.showConnections();
-                return 0;
+                // Show connections; --active lists only what is currently connected
+                bool active = i + 2 < argc && std::string(argv[i + 2]) == "--active";
+                return nm.showConnections(active) ? 0 : 1;
             } else if (subcommand == "up") {
                 // Handle "nmcli connection up" command
-                if (i + 2 < argc) {
+                if (i + 2 < argc && std::string(argv[i + 2]) == "--best") {
+                    // Handle "connection up --best [--watch]": pick the best known network in range
+                    bool watch = i + 3 < argc && std::string(argv[i + 3]) == "--watch";
+                    return nm.activateBestConnection(watch) ? 0 : 1;
+                } else if (i + 2 < argc) {
                     std::string ssid = argv[i + 2];
 
                     // Check for optional [id|uuid] parameter
@@ -243,7 +563,16 @@ int main(int argc, char *argv[]) {
                         ssid = argv[i + 3];
                     }
 
-                    if (nm.activateConnection(ssid)) {
+                    // --until-ready: wait for association, an address and a default route, and report each stage.
+                    // The time budget is still the global -w/--wait <seconds>.
+                    bool until_ready = false;
+                    for (int j = i + 3; j < argc; j++) {
+                        if (std::string(argv[j]) == "--until-ready") {
+                            until_ready = true;
+                        }
+                    }
+
+                    if (nm.activateConnection(ssid, until_ready)) {
                         std::cout << "Connection '" << ssid << "' activated successfully" << std::endl;
                         return 0;
                     } else {
@@ -277,33 +606,61 @@ int main(int argc, char *argv[]) {
                     return 1;
                 }
             } else if (subcommand == "delete") {
-                // Handle "nmcli connection delete" command
-                if (i + 2 < argc) {
-                    std::string ssid = argv[i + 2];
-
-                    // Check for optional [id|uuid] parameter
-                    if ((ssid == "id" || ssid == "uuid") && i + 3 < argc) {
-                        // If the next argument is "id" or "uuid", then the actual SSID is the one after that
-                        ssid = argv[i + 3];
+                // Handle "connection delete [id|uuid] <name|glob>... [--older-than <duration>]" command
+                std::vector<std::string> patterns;
+                std::optional<std::chrono::seconds> older_than;
+                for (int j = i + 2; j < argc; j++) {
+                    std::string opt = argv[j];
+                    if (opt == "--older-than") {
+                        std::chrono::seconds age;
+                        if (j + 1 >= argc || !parseDuration(argv[j + 1], age)) {
+                            std::cerr << "Error: --older-than requires a duration such as 90d, 12h or 30m" << std::endl;
+                            return 1;
+                        }
+                        older_than = age;
+                        j++;
+                    } else if ((opt == "id" || opt == "uuid") && j + 1 < argc) {
+                        // The name follows the optional [id|uuid] keyword
+                        continue;
+                    } else {
+                        patterns.push_back(opt);
                     }
+                }
 
-                    if (nm.deleteConnection(ssid)) {
-                        std::cout << "Connection '" << ssid << "' deleted successfully" << std::endl;
-                        return 0;
+                if (patterns.empty() && !older_than) {
+                    std::cerr << "Error: SSID required for connection delete command" << std::endl;
+                    return 1;
+                }
+                return nm.deleteConnections(patterns, older_than) ? 0 : 1;
+            } else if (subcommand == "import") {
+                // Handle "connection import <file|-> [--storage-dir <dir>] [--replace]" command
+                std::string file;
+                std::string storage_dir;
+                bool replace = false;
+                for (int j = i + 2; j < argc; j++) {
+                    std::string opt = argv[j];
+                    if (opt == "--storage-dir" && j + 1 < argc) {
+                        storage_dir = argv[++j];
+                    } else if (opt == "--replace") {
+                        replace = true;
+                    } else if (file.empty()) {
+                        file = opt;
                     } else {
-                        std::cerr << "Failed to delete connection '" << ssid << "'" << std::endl;
+                        std::cerr << "Invalid connection import option: " << opt << std::endl;
                         return 1;
                     }
-                } else {
-                    std::cerr << "Error: SSID required for connection delete command" << std::endl;
+                }
+
+                if (file.empty()) {
+                    std::cerr << "Error: connection import requires a CSV or JSON file (or - for stdin)" << std::endl;
                     return 1;
                 }
+                return nm.importConnections(file, storage_dir, replace) ? 0 : 1;
             }
             // 其他子命令可以在这里添加
         } else {
             // Default action for connection command is show
-            nm.showConnections();
-            return 0;
+            return nm.showConnections() ? 0 : 1;
         }
     } else if (command == "radio") {
         // Handle "nmcli radio" command
@@ -317,15 +674,31 @@ int main(int argc, char *argv[]) {
                         return 1;
                     }
                     bool setState = state == "on";
-                    if (!nm.setWifiRadio(setState)) {
+                    // --until-ready: after powering on, wait until the station exists and report each stage.
+                    // Named apart from the global -w/--wait budget, which only bounds how long this may take
+                    bool until_ready = false;
+                    for (int j = i + 3; j < argc; j++) {
+                        std::string option = argv[j];
+                        if (option == "--until-ready") {
+                            until_ready = true;
+                        } else {
+                            std::cerr << "Error: Unexpected argument '" << option << "' for radio wifi" << std::endl;
+                            return 1;
+                        }
+                    }
+                    if (!nm.setWifiRadio(setState, until_ready)) {
                         std::cerr << "Failed to set WiFi radio " << state << std::endl;
                         return 1;
                     }
                     return 0;
                 } else {
                     // Show current WiFi radio state
-                    bool state = nm.getWifiRadioState();
-                    std::cout << (state ? "enabled" : "disabled") << std::endl;
+                    std::optional<bool> state = nm.getWifiRadioState();
+                    if (!state) {
+                        std::cout << "unknown" << std::endl;
+                        return 1;
+                    }
+                    std::cout << (*state ? "enabled" : "disabled") << std::endl;
                     return 0;
                 }
             } else if (subcommand == "all" || subcommand == "wwan") {
@@ -338,13 +711,147 @@ int main(int argc, char *argv[]) {
             }
         } else {
             // Show all radio states
-            bool wifiState = nm.getWifiRadioState();
-            std::cout << (wifiState ? "enabled" : "disabled") << std::endl;
+            std::optional<bool> wifiState = nm.getWifiRadioState();
+            if (!wifiState) {
+                std::cout << "unknown" << std::endl;
+                return 1;
+            }
+            std::cout << (*wifiState ? "enabled" : "disabled") << std::endl;
             // TODO: Add WWAN and other radio types when implemented
             return 0;
         }
+    } else if (command == "metrics") {
+        // Handle "metrics --textfile <path> [--interval <ms>]" command
+        std::string path;
+        int interval_ms = 15000;
+        for (int j = i + 1; j < argc; j++) {
+            std::string opt = argv[j];
+            if (opt == "--textfile" && j + 1 < argc) {
+                path = argv[++j];
+            } else if (opt == "--interval" && j + 1 < argc) {
+                try {
+                    interval_ms = std::stoi(argv[++j]);
+                } catch (const std::exception &) {
+                    std::cerr << "Error: --interval requires a number" << std::endl;
+                    return 1;
+                }
+                if (interval_ms <= 0) {
+                    std::cerr << "Error: --interval requires a positive number of milliseconds" << std::endl;
+                    return 1;
+                }
+            } else {
+                std::cerr << "Invalid metrics option: " << opt << std::endl;
+                return 1;
+            }
+        }
+
+        if (path.empty()) {
+            std::cerr << "Error: metrics requires --textfile <path>" << std::endl;
+            return 1;
+        }
+        return nm.exportMetrics(path, interval_ms) ? 0 : 1;
+    } else if (command == "state") {
+        // Handle "state publish [--path <file>] [--interval <ms>]" command
+        if (i + 1 >= argc || std::string(argv[i + 1]) != "publish") {
+            std::cerr << "Invalid state subcommand, use 'state publish'" << std::endl;
+            return 1;
+        }
+        if (!nm.shm_path.empty()) {
+            std::cerr << "Error: --from-shm cannot be used with state publish" << std::endl;
+            return 1;
+        }
+
+        std::string path = SHM_STATE_PATH;
+        int interval_ms = 5000;
+        for (int j = i + 2; j < argc; j++) {
+            std::string opt = argv[j];
+            if (opt == "--path" && j + 1 < argc) {
+                path = argv[++j];
+            } else if (opt == "--interval" && j + 1 < argc) {
+                try {
+                    interval_ms = std::stoi(argv[++j]);
+                } catch (const std::exception &) {
+                    std::cerr << "Error: --interval requires a number" << std::endl;
+                    return 1;
+                }
+                if (interval_ms <= 0) {
+                    std::cerr << "Error: --interval requires a positive number of milliseconds" << std::endl;
+                    return 1;
+                }
+            } else {
+                std::cerr << "Invalid state publish option: " << opt << std::endl;
+                return 1;
+            }
+        }
+        return nm.publishState(path, interval_ms) ? 0 : 1;
     }
 
     std::cerr << "Unsupported command: " << command << std::endl;
     return 1;
 }
+
+// 总量和分配最多的阶段
+static void printMemStats() {
+    const MemStats::Totals totals = MemStats::totals();
+    std::fprintf(
+        stderr, "%llu allocations, %llu frees, %.1f KiB allocated, peak live heap %.1f KiB\n",
+        static_cast<unsigned long long>(totals.allocations), static_cast<unsigned long long>(totals.frees),
+        totals.bytes / 1024.0, totals.peak / 1024.0
+    );
+
+    // ALLOCS/KIB 不含嵌套阶段；最外层阶段（整条命令）另列含嵌套阶段的合计
+    const auto phases = MemStats::phases();
+    std::fprintf(stderr, "%-40s %10s %12s %12s %12s\n", "PHASE", "ALLOCS", "KIB", "TOTAL-ALLOCS", "TOTAL-KIB");
+    for (size_t i = 0; i < phases.size() && i < 10; ++i) {
+        const MemStats::Phase &phase = phases[i];
+        if (phase.inclusive_allocations > 0) {
+            std::fprintf(
+                stderr, "%-40s %10llu %12.1f %12llu %12.1f\n", phase.label.c_str(),
+                static_cast<unsigned long long>(phase.allocations), phase.bytes / 1024.0,
+                static_cast<unsigned long long>(phase.inclusive_allocations), phase.inclusive_bytes / 1024.0
+            );
+        } else {
+            std::fprintf(
+                stderr, "%-40s %10llu %12.1f %12s %12s\n", phase.label.c_str(),
+                static_cast<unsigned long long>(phase.allocations), phase.bytes / 1024.0, "-", "-"
+            );
+        }
+    }
+}
+
+int main(int argc, char *argv[]) {
+    const auto start = Probes::Clock::now();
+    int status;
+    try {
+        status = run(argc, argv);
+    } catch (const TimeoutException &e) {
+        // 与 nmcli 一致，超时的退出码为 3
+        std::cerr << "Error: " << e.what() << std::endl;
+        status = 3;
+    }
+    // 各命令把途中的超时当作普通错误报告，截止时间到期后的失败统一按超时退出
+    if (status != 0 && Deadline::global().expired()) {
+        status = 3;
+    }
+
+    // 缓存只在退出前写回一次
+    PropertyCache::global().flush();
+
+    ChromeTrace &chromeTrace = ChromeTrace::global();
+    if (chromeTrace.enabled()) {
+        // 整条命令作为最外层区间，result 为退出码
+        std::string commandLine = argv[0];
+        for (int i = 1; i < argc; i++) {
+            commandLine += std::string(" ") + argv[i];
+        }
+        chromeTrace.add("command", "nmcli-alt", commandLine.c_str(), start, Probes::Clock::now() - start, status);
+        if (!chromeTrace.write() && status == 0) {
+            status = 1;
+        }
+    }
+
+    if (MemStats::enabled()) {
+        printMemStats();
+    }
+    return status;
+}
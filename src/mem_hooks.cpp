@@ -0,0 +1,148 @@
+#include "mem_stats.h"
+
+#include <cstdlib>
+#include <new>
+#include <malloc.h>
+
+/**
+ * 全局 operator new/delete 的替换实现，把分配计入 MemStats
+ *
+ * 只链接进 nmcli-alt 和基准测试：嵌入 libnmcli-alt 的程序不应被替换全局分配函数。
+ * 未启用 --mem-stats 时每次分配只多一次原子读。
+ */
+
+namespace {
+
+void *allocate(size_t size) noexcept {
+    void *ptr = std::malloc(size ? size : 1);
+    if (ptr) {
+        MemStats::recordAllocation(malloc_usable_size(ptr));
+    }
+    return ptr;
+}
+
+void *allocateAligned(size_t size, std::align_val_t alignment) noexcept {
+    // aligned_alloc 要求大小是对齐值的整数倍
+    const size_t align = static_cast<size_t>(alignment);
+    const size_t rounded = (size + align - 1) / align * align;
+    void *ptr = std::aligned_alloc(align, rounded ? rounded : align);
+    if (ptr) {
+        MemStats::recordAllocation(malloc_usable_size(ptr));
+    }
+    return ptr;
+}
+
+void *allocateOrThrow(size_t size) {
+    for (;;) {
+        if (void *ptr = allocate(size)) {
+            return ptr;
+        }
+        std::new_handler handler = std::get_new_handler();
+        if (!handler) {
+            throw std::bad_alloc();
+        }
+        handler();
+    }
+}
+
+void *allocateAlignedOrThrow(size_t size, std::align_val_t alignment) {
+    for (;;) {
+        if (void *ptr = allocateAligned(size, alignment)) {
+            return ptr;
+        }
+        std::new_handler handler = std::get_new_handler();
+        if (!handler) {
+            throw std::bad_alloc();
+        }
+        handler();
+    }
+}
+
+void release(void *ptr) noexcept {
+    if (ptr) {
+        MemStats::recordFree(malloc_usable_size(ptr));
+        std::free(ptr);
+    }
+}
+
+} // namespace
+
+void *operator new(size_t size) {
+    return allocateOrThrow(size);
+}
+
+void *operator new[](size_t size) {
+    return allocateOrThrow(size);
+}
+
+void *operator new(size_t size, const std::nothrow_t &) noexcept {
+    return allocate(size);
+}
+
+void *operator new[](size_t size, const std::nothrow_t &) noexcept {
+    return allocate(size);
+}
+
+void *operator new(size_t size, std::align_val_t alignment) {
+    return allocateAlignedOrThrow(size, alignment);
+}
+
+void *operator new[](size_t size, std::align_val_t alignment) {
+    return allocateAlignedOrThrow(size, alignment);
+}
+
+void *operator new(size_t size, std::align_val_t alignment, const std::nothrow_t &) noexcept {
+    return allocateAligned(size, alignment);
+}
+
+void *operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t &) noexcept {
+    return allocateAligned(size, alignment);
+}
+
+void operator delete(void *ptr) noexcept {
+    release(ptr);
+}
+
+void operator delete[](void *ptr) noexcept {
+    release(ptr);
+}
+
+void operator delete(void *ptr, size_t) noexcept {
+    release(ptr);
+}
+
+void operator delete[](void *ptr, size_t) noexcept {
+    release(ptr);
+}
+
+void operator delete(void *ptr, const std::nothrow_t &) noexcept {
+    release(ptr);
+}
+
+void operator delete[](void *ptr, const std::nothrow_t &) noexcept {
+    release(ptr);
+}
+
+void operator delete(void *ptr, std::align_val_t) noexcept {
+    release(ptr);
+}
+
+void operator delete[](void *ptr, std::align_val_t) noexcept {
+    release(ptr);
+}
+
+void operator delete(void *ptr, size_t, std::align_val_t) noexcept {
+    release(ptr);
+}
+
+void operator delete[](void *ptr, size_t, std::align_val_t) noexcept {
+    release(ptr);
+}
+
+void operator delete(void *ptr, std::align_val_t, const std::nothrow_t &) noexcept {
+    release(ptr);
+}
+
+void operator delete[](void *ptr, std::align_val_t, const std::nothrow_t &) noexcept {
+    release(ptr);
+}
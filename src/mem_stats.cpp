@@ -0,0 +1,182 @@
+#include "mem_stats.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+
+namespace {
+
+constexpr int MAX_PHASES = 128;
+constexpr int UNATTRIBUTED = 0; // 不在任何阶段内的分配
+constexpr int OTHER = 1;        // 阶段表满后新出现的阶段
+
+struct PhaseSlot {
+    char label[64];
+    std::atomic<uint64_t> allocations{0};
+    std::atomic<uint64_t> bytes{0};
+    std::atomic<uint64_t> inclusive_allocations{0};
+    std::atomic<uint64_t> inclusive_bytes{0};
+};
+
+std::atomic<bool> active{false};
+std::atomic<uint64_t> allocationCount{0};
+std::atomic<uint64_t> freeCount{0};
+std::atomic<uint64_t> allocatedBytes{0};
+std::atomic<uint64_t> liveBytes{0};
+std::atomic<uint64_t> peakBytes{0};
+
+// 标签在持有 phaseMutex 时写入，写完后才发布新的 phaseCount，读取端只访问 phaseCount 以内的槽位
+std::array<PhaseSlot, MAX_PHASES> phaseSlots;
+std::atomic<int> phaseCount{0};
+std::mutex phaseMutex;
+
+thread_local int currentPhase = UNATTRIBUTED;
+// 当前线程最外层的阶段，嵌套阶段中的分配也计入它的合计
+thread_local int outerPhase = UNATTRIBUTED;
+
+void updatePeak(uint64_t live) {
+    uint64_t current = peakBytes.load(std::memory_order_relaxed);
+    while (live > current && !peakBytes.compare_exchange_weak(current, live, std::memory_order_relaxed)) {
+    }
+}
+
+} // namespace
+
+void MemStats::enable() {
+    std::lock_guard<std::mutex> lock(phaseMutex);
+    if (phaseCount.load(std::memory_order_relaxed) == 0) {
+        std::snprintf(phaseSlots[UNATTRIBUTED].label, sizeof(phaseSlots[UNATTRIBUTED].label), "(unattributed)");
+        std::snprintf(phaseSlots[OTHER].label, sizeof(phaseSlots[OTHER].label), "other");
+        phaseCount.store(OTHER + 1, std::memory_order_release);
+    }
+    active.store(true, std::memory_order_relaxed);
+}
+
+bool MemStats::enabled() {
+    return active.load(std::memory_order_relaxed);
+}
+
+MemStats::Totals MemStats::totals() {
+    Totals totals;
+    totals.allocations = allocationCount.load(std::memory_order_relaxed);
+    totals.frees = freeCount.load(std::memory_order_relaxed);
+    totals.bytes = allocatedBytes.load(std::memory_order_relaxed);
+    totals.live = liveBytes.load(std::memory_order_relaxed);
+    totals.peak = peakBytes.load(std::memory_order_relaxed);
+    return totals;
+}
+
+void MemStats::resetPeak() {
+    peakBytes.store(liveBytes.load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+std::vector<MemStats::Phase> MemStats::phases() {
+    // 先取出数值再分配结果，避免统计自身的分配混入正在读取的计数
+    std::array<uint64_t, MAX_PHASES> counts{};
+    std::array<uint64_t, MAX_PHASES> bytes{};
+    std::array<uint64_t, MAX_PHASES> inclusive_counts{};
+    std::array<uint64_t, MAX_PHASES> inclusive_bytes{};
+    const int count = phaseCount.load(std::memory_order_acquire);
+    for (int i = 0; i < count; ++i) {
+        counts[i] = phaseSlots[i].allocations.load(std::memory_order_relaxed);
+        bytes[i] = phaseSlots[i].bytes.load(std::memory_order_relaxed);
+        inclusive_counts[i] = phaseSlots[i].inclusive_allocations.load(std::memory_order_relaxed);
+        inclusive_bytes[i] = phaseSlots[i].inclusive_bytes.load(std::memory_order_relaxed);
+    }
+
+    std::vector<Phase> phases;
+    for (int i = 0; i < count; ++i) {
+        if (counts[i] > 0 || inclusive_counts[i] > 0) {
+            phases.push_back({phaseSlots[i].label, counts[i], bytes[i], inclusive_counts[i], inclusive_bytes[i]});
+        }
+    }
+    std::sort(phases.begin(), phases.end(), [](const Phase &a, const Phase &b) {
+        return std::max(a.bytes, a.inclusive_bytes) > std::max(b.bytes, b.inclusive_bytes);
+    });
+    return phases;
+}
+
+void MemStats::recordAllocation(size_t bytes) noexcept {
+    if (!active.load(std::memory_order_relaxed)) {
+        return;
+    }
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    allocatedBytes.fetch_add(bytes, std::memory_order_relaxed);
+    updatePeak(liveBytes.fetch_add(bytes, std::memory_order_relaxed) + bytes);
+
+    PhaseSlot &slot = phaseSlots[currentPhase];
+    slot.allocations.fetch_add(1, std::memory_order_relaxed);
+    slot.bytes.fetch_add(bytes, std::memory_order_relaxed);
+
+    if (outerPhase != UNATTRIBUTED) {
+        PhaseSlot &outer = phaseSlots[outerPhase];
+        outer.inclusive_allocations.fetch_add(1, std::memory_order_relaxed);
+        outer.inclusive_bytes.fetch_add(bytes, std::memory_order_relaxed);
+    }
+}
+
+void MemStats::recordFree(size_t bytes) noexcept {
+    if (!active.load(std::memory_order_relaxed)) {
+        return;
+    }
+    freeCount.fetch_add(1, std::memory_order_relaxed);
+    // 启用前分配、启用后释放的内存没有计入存活字节，不能减到 0 以下
+    uint64_t live = liveBytes.load(std::memory_order_relaxed);
+    while (!liveBytes.compare_exchange_weak(
+        live, live > bytes ? live - bytes : 0, std::memory_order_relaxed, std::memory_order_relaxed
+    )) {
+    }
+}
+
+int MemStats::enterPhase(const char *kind, const std::string &operation) noexcept {
+    const int previous = currentPhase;
+    if (!active.load(std::memory_order_relaxed)) {
+        return previous;
+    }
+
+    char label[sizeof(PhaseSlot::label)];
+    std::snprintf(label, sizeof(label), "%s %s", kind, operation.c_str());
+
+    // 同一个阶段通常会反复进入，先不加锁查找已发布的槽位
+    int count = phaseCount.load(std::memory_order_acquire);
+    for (int i = OTHER + 1; i < count; ++i) {
+        if (std::strcmp(phaseSlots[i].label, label) == 0) {
+            currentPhase = i;
+            if (previous == UNATTRIBUTED) {
+                outerPhase = i;
+            }
+            return previous;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(phaseMutex);
+    count = phaseCount.load(std::memory_order_relaxed);
+    int slot = OTHER;
+    for (int i = OTHER + 1; i < count; ++i) {
+        if (std::strcmp(phaseSlots[i].label, label) == 0) {
+            slot = i;
+            break;
+        }
+    }
+    if (slot == OTHER && count < MAX_PHASES) {
+        std::memcpy(phaseSlots[count].label, label, sizeof(label));
+        phaseCount.store(count + 1, std::memory_order_release);
+        slot = count;
+    }
+    currentPhase = slot;
+    if (previous == UNATTRIBUTED) {
+        outerPhase = slot;
+    }
+    return previous;
+}
+
+void MemStats::leavePhase(int previous) noexcept {
+    currentPhase = previous;
+    // 回到阶段之外，说明离开的是最外层阶段
+    if (previous == UNATTRIBUTED) {
+        outerPhase = UNATTRIBUTED;
+    }
+}
@@ -0,0 +1,217 @@
+#include "metrics_exporter.h"
+#include "instrumentation.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <utility>
+
+namespace {
+
+// 调用延迟直方图导出的桶上界，单位为秒；内部 HDR 桶的相对误差远小于相邻上界的间距
+constexpr double LATENCY_BUCKETS[] = {0.0001, 0.00025, 0.0005, 0.001, 0.0025, 0.005, 0.01, 0.025,
+                                      0.05,   0.1,     0.25,   0.5,   1,      2.5,   5,     10};
+
+std::string escapeLabel(const std::string &value) {
+    std::string escaped;
+    escaped.reserve(value.size());
+    for (char c : value) {
+        if (c == '\\') {
+            escaped += "\\\\";
+        } else if (c == '"') {
+            escaped += "\\\"";
+        } else if (c == '\n') {
+            escaped += "\\n";
+        } else {
+            escaped += c;
+        }
+    }
+    return escaped;
+}
+
+std::string formatDouble(double value) {
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%.9g", value);
+    return buf;
+}
+
+void header(std::string &out, const char *name, const char *type, const char *help) {
+    out += "# HELP ";
+    out += name;
+    out += ' ';
+    out += help;
+    out += "\n# TYPE ";
+    out += name;
+    out += ' ';
+    out += type;
+    out += '\n';
+}
+
+void sample(std::string &out, const char *name, const std::string &labels, const std::string &value) {
+    out += name;
+    if (!labels.empty()) {
+        out += '{';
+        out += labels;
+        out += '}';
+    }
+    out += ' ';
+    out += value;
+    out += '\n';
+}
+
+void writeAll(int fd, const std::string &data) {
+    size_t written = 0;
+    while (written < data.size()) {
+        ssize_t n = ::write(fd, data.data() + written, data.size() - written);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw NmcliException("Failed to write metrics: " + std::string(strerror(errno)));
+        }
+        written += static_cast<size_t>(n);
+    }
+}
+
+} // namespace
+
+MetricsExporter::MetricsExporter(std::string path) : path_(std::move(path)), tmp_path_(path_ + ".tmp") {}
+
+std::string MetricsExporter::render(const StateSnapshot &snapshot) const {
+    std::string out;
+
+    header(out, "nmcli_alt_link_up", "gauge", "Whether the link operational state is up.");
+    for (const auto &link : snapshot.links) {
+        if (link.type == "loopback") {
+            continue;
+        }
+        sample(
+            out, "nmcli_alt_link_up",
+            "device=\"" + escapeLabel(link.device) + "\",type=\"" + escapeLabel(link.type) + "\"",
+            link.operstate == "up" ? "1" : "0"
+        );
+    }
+
+    header(out, "nmcli_alt_link_operstate", "gauge", "Link operational state, 1 for the current state.");
+    for (const auto &link : snapshot.links) {
+        if (link.type == "loopback") {
+            continue;
+        }
+        sample(
+            out, "nmcli_alt_link_operstate",
+            "device=\"" + escapeLabel(link.device) + "\",state=\"" + escapeLabel(link.operstate) + "\"", "1"
+        );
+    }
+
+    header(out, "nmcli_alt_wifi_connected", "gauge", "Whether the wifi device is connected to a network.");
+    for (const auto &wifi : snapshot.wifi) {
+        sample(
+            out, "nmcli_alt_wifi_connected",
+            "device=\"" + escapeLabel(wifi.device) + "\",ssid=\"" + escapeLabel(wifi.ssid) + "\"",
+            wifi.connected ? "1" : "0"
+        );
+    }
+
+    header(out, "nmcli_alt_wifi_signal_dbm", "gauge", "Signal strength of the associated access point in dBm.");
+    for (const auto &wifi : snapshot.wifi) {
+        if (wifi.has_signal) {
+            sample(
+                out, "nmcli_alt_wifi_signal_dbm",
+                "device=\"" + escapeLabel(wifi.device) + "\",ssid=\"" + escapeLabel(wifi.ssid) + "\"",
+                std::to_string(wifi.signal_dbm)
+            );
+        }
+    }
+
+    header(out, "nmcli_alt_wifi_signal_quality", "gauge", "Signal quality of the associated access point (0-100).");
+    for (const auto &wifi : snapshot.wifi) {
+        if (wifi.has_signal) {
+            sample(
+                out, "nmcli_alt_wifi_signal_quality",
+                "device=\"" + escapeLabel(wifi.device) + "\",ssid=\"" + escapeLabel(wifi.ssid) + "\"",
+                std::to_string(wifi.quality)
+            );
+        }
+    }
+
+    header(out, "nmcli_alt_iwd_available", "gauge", "Whether iwd is reachable on the system bus.");
+    sample(out, "nmcli_alt_iwd_available", "", snapshot.iwd_available ? "1" : "0");
+
+    if (snapshot.radio_enabled) {
+        header(out, "nmcli_alt_radio_wifi_enabled", "gauge", "Whether the wifi radio is powered.");
+        sample(out, "nmcli_alt_radio_wifi_enabled", "", *snapshot.radio_enabled ? "1" : "0");
+    }
+
+    header(out, "nmcli_alt_connectivity", "gauge", "Network connectivity, 1 for the current state.");
+    sample(out, "nmcli_alt_connectivity", "state=\"" + escapeLabel(snapshot.connectivity) + "\"", "1");
+
+    header(
+        out, "nmcli_alt_call_duration_seconds", "histogram", "Latency of D-Bus and netlink calls made by nmcli-alt."
+    );
+    Instrumentation::forEach(
+        [&out](const std::string &kind, const std::string &operation, const LatencyHistogram &histogram) {
+            const std::string labels = "kind=\"" + escapeLabel(kind) + "\",operation=\"" + escapeLabel(operation) + "\"";
+            for (double le : LATENCY_BUCKETS) {
+                uint64_t count = histogram.countAtOrBelow(static_cast<uint64_t>(le * 1e9));
+                sample(
+                    out, "nmcli_alt_call_duration_seconds_bucket", labels + ",le=\"" + formatDouble(le) + "\"",
+                    std::to_string(count)
+                );
+            }
+            sample(
+                out, "nmcli_alt_call_duration_seconds_bucket", labels + ",le=\"+Inf\"",
+                std::to_string(histogram.count())
+            );
+            sample(
+                out, "nmcli_alt_call_duration_seconds_sum", labels,
+                formatDouble(static_cast<double>(histogram.sum()) / 1e9)
+            );
+            sample(out, "nmcli_alt_call_duration_seconds_count", labels, std::to_string(histogram.count()));
+        }
+    );
+
+    header(out, "nmcli_alt_metrics_writes_total", "counter", "Number of times this file has been rewritten.");
+    sample(out, "nmcli_alt_metrics_writes_total", "", std::to_string(writes_ + 1));
+
+    auto now = std::chrono::system_clock::now().time_since_epoch();
+    header(out, "nmcli_alt_metrics_last_update_timestamp_seconds", "gauge", "Time this file was last written.");
+    sample(
+        out, "nmcli_alt_metrics_last_update_timestamp_seconds", "",
+        formatDouble(std::chrono::duration_cast<std::chrono::milliseconds>(now).count() / 1e3)
+    );
+
+    return out;
+}
+
+void MetricsExporter::write(const StateSnapshot &snapshot) {
+    const std::string data = render(snapshot);
+
+    // 临时文件与目标在同一目录，rename 是原子的；collector 只读取 *.prom，不会读到临时文件
+    int fd = open(tmp_path_.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        throw NmcliException("Failed to open " + tmp_path_ + ": " + std::string(strerror(errno)));
+    }
+
+    try {
+        writeAll(fd, data);
+    } catch (...) {
+        close(fd);
+        unlink(tmp_path_.c_str());
+        throw;
+    }
+
+    if (close(fd) < 0) {
+        unlink(tmp_path_.c_str());
+        throw NmcliException("Failed to write metrics: " + std::string(strerror(errno)));
+    }
+
+    if (rename(tmp_path_.c_str(), path_.c_str()) < 0) {
+        unlink(tmp_path_.c_str());
+        throw NmcliException("Failed to replace " + path_ + ": " + std::string(strerror(errno)));
+    }
+
+    writes_++;
+}
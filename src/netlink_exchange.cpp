@@ -0,0 +1,133 @@
+#include "netlink_exchange.h"
+#include "deadline.h"
+#include "probes.h"
+#include "trace.h"
+
+#include <netlink/netlink.h>
+#include <netlink/msg.h>
+#include <sys/socket.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <utility>
+#include <vector>
+
+namespace {
+
+uint64_t monotonicNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+} // namespace
+
+NetlinkExchange::NetlinkExchange(size_t buffer_size, std::string description)
+    : buffer_(new unsigned char[buffer_size]), buffer_size_(buffer_size), description_(std::move(description)),
+      seq_(static_cast<uint32_t>(time(nullptr))) {}
+
+NetlinkExchange::~NetlinkExchange() = default;
+
+uint64_t NetlinkExchange::run(
+    int fd, struct nlmsghdr *request, const char *operation, const std::string &key, Callback callback, void *context
+) {
+    Trace &trace = Trace::global();
+    if (trace.replaying()) {
+        TraceDecoder decoder(trace.replay(Trace::Kind::Netlink, operation, key));
+        decoder.u32();
+        for (uint32_t count = decoder.u32(); count > 0; --count) {
+            // 复制到接收缓冲区，解析时满足 netlink 消息的对齐要求
+            std::string_view chunk = decoder.bytes();
+            size_t size = std::min(chunk.size(), buffer_size_);
+            std::memcpy(buffer_.get(), chunk.data(), size);
+            if (parseChunk(static_cast<int>(size), false, callback, context)) {
+                break;
+            }
+        }
+        return 0;
+    }
+
+    const uint64_t start = monotonicNs();
+    request->nlmsg_seq = ++seq_;
+
+    // 只在指定了 --wait 时多一次 setsockopt
+    Deadline::global().applyReceiveTimeout(fd);
+    ProbeSpan probe(ProbeKind::Netlink, operation);
+    if (send(fd, request, request->nlmsg_len, 0) < 0) {
+        probe.setResult(-errno);
+        throw NetworkException("Failed to send " + description_ + " request: " + strerror(errno));
+    }
+
+    // 只有录制时才保存原始响应，正常采样不分配内存
+    std::vector<std::string> chunks;
+    bool done = false;
+    while (!done) {
+        // MSG_TRUNC 让 recv 返回消息的实际长度，超出缓冲区的响应不能按截断后的内容解析
+        ssize_t received = recv(fd, buffer_.get(), buffer_size_, MSG_TRUNC);
+        if (received < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            probe.setResult(-errno);
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                Deadline::global().check("waiting for " + description_);
+            }
+            throw NetworkException("Failed to receive " + description_ + ": " + strerror(errno));
+        }
+        if (static_cast<size_t>(received) > buffer_size_) {
+            probe.setResult(-EMSGSIZE);
+            throw NetworkException(
+                "Reply of " + std::to_string(received) + " bytes to the " + description_ +
+                " request exceeds the receive buffer"
+            );
+        }
+
+        if (trace.recording()) {
+            chunks.emplace_back(reinterpret_cast<const char *>(buffer_.get()), static_cast<size_t>(received));
+        }
+        done = parseChunk(static_cast<int>(received), true, callback, context);
+    }
+
+    const uint64_t elapsed = monotonicNs() - start;
+    if (trace.recording()) {
+        std::string payload;
+        TraceEncoder encoder(payload);
+        encoder.u32(0);
+        encoder.u32(static_cast<uint32_t>(chunks.size()));
+        for (const auto &chunk : chunks) {
+            encoder.bytes(chunk);
+        }
+        trace.record(
+            Trace::Kind::Netlink, operation, key, Trace::Clock::now() - std::chrono::nanoseconds(elapsed),
+            std::chrono::nanoseconds(elapsed), payload
+        );
+    }
+    return elapsed;
+}
+
+bool NetlinkExchange::parseChunk(int size, bool check_seq, Callback callback, void *context) {
+    int remaining = size;
+    for (struct nlmsghdr *nlh = reinterpret_cast<struct nlmsghdr *>(buffer_.get()); nlmsg_ok(nlh, remaining);
+         nlh = nlmsg_next(nlh, &remaining)) {
+        // 丢弃被中断的上一次请求遗留的响应；回放的消息带有录制时的序列号
+        if (check_seq && nlh->nlmsg_seq != seq_) {
+            continue;
+        }
+
+        if (nlh->nlmsg_type == NLMSG_DONE) {
+            return true;
+        }
+
+        if (nlh->nlmsg_type == NLMSG_ERROR) {
+            const struct nlmsgerr *err = static_cast<const struct nlmsgerr *>(nlmsg_data(nlh));
+            if (err->error < 0) {
+                throw NetworkException("Kernel rejected the " + description_ + " request: " + strerror(-err->error));
+            }
+            return true;
+        }
+
+        callback(context, nlh);
+    }
+    return false;
+}
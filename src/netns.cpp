@@ -0,0 +1,118 @@
+#include "netns.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <exception>
+#include <mutex>
+#include <thread>
+
+namespace {
+
+// 每个命名空间只有几次短 dump，主要开销在内核里，线程数超过核数仍能缩短总耗时
+constexpr size_t MIN_WORKERS = 4;
+constexpr size_t MAX_WORKERS = 64;
+
+bool validName(const std::string &name) {
+    return !name.empty() && name != "." && name != ".." && name.find('/') == std::string::npos;
+}
+
+// 在当前线程中进入命名空间并读取；只在工作线程上调用，线程结束时命名空间随之丢弃
+void scanOne(NetnsSnapshot &snapshot) {
+    if (!validName(snapshot.name)) {
+        snapshot.error = "invalid namespace name";
+        return;
+    }
+
+    const std::string path = std::string(NETNS_RUN_DIR) + "/" + snapshot.name;
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        snapshot.error = "cannot open " + path + ": " + strerror(errno);
+        return;
+    }
+    int rc = setns(fd, CLONE_NEWNET);
+    int saved_errno = errno;
+    close(fd);
+    if (rc < 0) {
+        snapshot.error = "cannot enter namespace: " + std::string(strerror(saved_errno));
+        return;
+    }
+
+    // socket 在这里创建，因此属于目标命名空间
+    RtnlDump dump;
+    snapshot.links = dump.collect(false);
+    snapshot.has_default_route = dump.hasDefaultRoute();
+}
+
+} // namespace
+
+std::vector<std::string> listNamedNetns() {
+    std::vector<std::string> names;
+    DIR *dir = opendir(NETNS_RUN_DIR);
+    if (!dir) {
+        return names;
+    }
+    while (struct dirent *entry = readdir(dir)) {
+        std::string name = entry->d_name;
+        if (validName(name)) {
+            names.push_back(std::move(name));
+        }
+    }
+    closedir(dir);
+    std::sort(names.begin(), names.end());
+    return names;
+}
+
+std::vector<NetnsSnapshot> scanNetns(const std::vector<std::string> &names) {
+    std::vector<NetnsSnapshot> results(names.size());
+    for (size_t i = 0; i < names.size(); ++i) {
+        results[i].name = names[i];
+    }
+    if (results.empty()) {
+        return results;
+    }
+
+    const size_t hardware = std::max(1u, std::thread::hardware_concurrency());
+    const size_t workers = std::min(results.size(), std::clamp(hardware * 2, MIN_WORKERS, MAX_WORKERS));
+
+    // 工作线程按序领取下一个命名空间，慢的命名空间不会拖住固定分到同一线程的其他命名空间
+    std::atomic<size_t> next{0};
+    std::mutex timeout_mutex;
+    std::exception_ptr timeout;
+    auto work = [&] {
+        for (size_t i = next++; i < results.size(); i = next++) {
+            try {
+                scanOne(results[i]);
+            } catch (const TimeoutException &) {
+                // 预算已耗尽，其余命名空间也不再读取
+                std::lock_guard<std::mutex> lock(timeout_mutex);
+                if (!timeout) {
+                    timeout = std::current_exception();
+                }
+                next = results.size();
+            } catch (const std::exception &e) {
+                results[i].error = e.what();
+            }
+        }
+    };
+
+    // 调用线程不进入任何命名空间，之后在调用者命名空间中的操作不受影响
+    std::vector<std::thread> threads;
+    threads.reserve(workers);
+    for (size_t i = 0; i < workers; ++i) {
+        threads.emplace_back(work);
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    if (timeout) {
+        std::rethrow_exception(timeout);
+    }
+    return results;
+}
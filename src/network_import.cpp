@@ -0,0 +1,590 @@
+#include "network_import.h"
+
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <utility>
+
+namespace {
+
+std::string lower(std::string value) {
+    std::transform(value.begin(), value.end(), value.begin(), [](unsigned char c) { return std::tolower(c); });
+    return value;
+}
+
+std::string trim(const std::string &value) {
+    const size_t begin = value.find_first_not_of(" \t\r\n");
+    if (begin == std::string::npos) {
+        return "";
+    }
+    return value.substr(begin, value.find_last_not_of(" \t\r\n") - begin + 1);
+}
+
+// nmcli 和 iwd 的常见写法归一为 iwd 的三种配置类型，无法识别时原样返回交给校验报告
+std::string normalizeSecurity(const std::string &security, const std::string &passphrase) {
+    const std::string value = lower(trim(security));
+    if (value.empty()) {
+        return passphrase.empty() ? "open" : "psk";
+    }
+    if (value == "open" || value == "none") {
+        return "open";
+    }
+    if (value == "psk" || value == "wpa" || value == "wpa2" || value == "wpa3" || value == "wpa-psk" ||
+        value == "sae" || value == "wpa2-psk" || value == "wpa3-sae") {
+        return "psk";
+    }
+    if (value == "8021x" || value == "802.1x" || value == "eap" || value == "wpa-eap" || value == "enterprise") {
+        return "8021x";
+    }
+    return value;
+}
+
+void assignField(NetworkProfile &profile, const std::string &key, std::string value) {
+    const std::string name = lower(trim(key));
+    if (name == "ssid" || name == "name") {
+        profile.ssid = std::move(value);
+    } else if (name == "security" || name == "type") {
+        profile.security = std::move(value);
+    } else if (name == "passphrase" || name == "password" || name == "psk") {
+        profile.passphrase = std::move(value);
+    } else if (name == "identity") {
+        profile.identity = std::move(value);
+    } else if (name == "eap") {
+        profile.eap_method = std::move(value);
+    } else {
+        throw NmcliException("Unknown column '" + key + "'");
+    }
+}
+
+// RFC 4180：逗号分隔，字段可以用双引号包围，引号内的 "" 表示一个引号，换行也可以出现在引号内
+std::vector<std::vector<std::string>> parseCsv(const std::string &text, std::vector<int> &lines) {
+    std::vector<std::vector<std::string>> rows;
+    std::vector<std::string> row;
+    std::string field;
+    bool quoted = false;
+    bool fieldStarted = false;
+    int line = 1;
+    int rowLine = 1;
+
+    auto endRow = [&] {
+        if (fieldStarted || !row.empty()) {
+            row.push_back(std::move(field));
+            rows.push_back(std::move(row));
+            lines.push_back(rowLine);
+        }
+        row.clear();
+        field.clear();
+        fieldStarted = false;
+    };
+
+    for (size_t i = 0; i < text.size(); ++i) {
+        const char c = text[i];
+        if (quoted) {
+            if (c == '"' && i + 1 < text.size() && text[i + 1] == '"') {
+                field += '"';
+                ++i;
+            } else if (c == '"') {
+                quoted = false;
+            } else {
+                if (c == '\n') {
+                    ++line;
+                }
+                field += c;
+            }
+        } else if (c == '"' && field.empty()) {
+            quoted = true;
+            fieldStarted = true;
+        } else if (c == ',') {
+            row.push_back(std::move(field));
+            field.clear();
+            fieldStarted = true;
+        } else if (c == '\n' || c == '\r') {
+            if (c == '\r' && i + 1 < text.size() && text[i + 1] == '\n') {
+                ++i;
+            }
+            endRow();
+            rowLine = ++line;
+        } else {
+            field += c;
+            fieldStarted = true;
+        }
+    }
+    if (quoted) {
+        throw NmcliException("Unterminated quoted field starting on line " + std::to_string(rowLine));
+    }
+    endRow();
+    return rows;
+}
+
+std::vector<NetworkProfile> parseCsvProfiles(const std::string &text) {
+    std::vector<int> lines;
+    auto rows = parseCsv(text, lines);
+    if (rows.empty()) {
+        return {};
+    }
+
+    const std::vector<std::string> header = rows.front();
+    if (std::none_of(header.begin(), header.end(), [](const std::string &column) {
+            return lower(trim(column)) == "ssid" || lower(trim(column)) == "name";
+        })) {
+        throw NmcliException("CSV header must name an ssid column");
+    }
+
+    std::vector<NetworkProfile> profiles;
+    profiles.reserve(rows.size() - 1);
+    for (size_t r = 1; r < rows.size(); ++r) {
+        const auto &row = rows[r];
+        if (row.size() == 1 && trim(row[0]).empty()) {
+            continue;
+        }
+        if (row.size() > header.size()) {
+            throw NmcliException("Line " + std::to_string(lines[r]) + ": too many fields");
+        }
+        NetworkProfile profile;
+        profile.line = lines[r];
+        for (size_t c = 0; c < row.size(); ++c) {
+            assignField(profile, header[c], row[c]);
+        }
+        profiles.push_back(std::move(profile));
+    }
+    return profiles;
+}
+
+/**
+ * 只支持导入需要的 JSON 子集：对象数组，值为字符串、数字、布尔或 null
+ */
+class JsonReader {
+  public:
+    explicit JsonReader(const std::string &text) : text_(text) {}
+
+    std::vector<NetworkProfile> profiles() {
+        std::vector<NetworkProfile> profiles;
+        expect('[');
+        if (peek() == ']') {
+            ++pos_;
+            return profiles;
+        }
+        for (;;) {
+            profiles.push_back(object(static_cast<int>(profiles.size()) + 1));
+            if (peek() == ',') {
+                ++pos_;
+                continue;
+            }
+            expect(']');
+            break;
+        }
+        if (peek() != '\0') {
+            fail("trailing data");
+        }
+        return profiles;
+    }
+
+  private:
+    NetworkProfile object(int index) {
+        NetworkProfile profile;
+        profile.line = index;
+        expect('{');
+        if (peek() == '}') {
+            ++pos_;
+            return profile;
+        }
+        for (;;) {
+            std::string key = string();
+            expect(':');
+            assignField(profile, key, value());
+            if (peek() == ',') {
+                ++pos_;
+                continue;
+            }
+            expect('}');
+            return profile;
+        }
+    }
+
+    std::string value() {
+        const char c = peek();
+        if (c == '"') {
+            return string();
+        }
+        for (const char *literal : {"true", "false", "null"}) {
+            if (text_.compare(pos_, std::strlen(literal), literal) == 0) {
+                pos_ += std::strlen(literal);
+                return literal[0] == 'n' ? "" : literal;
+            }
+        }
+        const size_t start = pos_;
+        while (pos_ < text_.size() && (std::isdigit(static_cast<unsigned char>(text_[pos_])) ||
+                                       std::strchr("+-.eE", text_[pos_]) != nullptr)) {
+            ++pos_;
+        }
+        if (pos_ == start) {
+            fail("expected a value");
+        }
+        return text_.substr(start, pos_ - start);
+    }
+
+    std::string string() {
+        expect('"');
+        std::string out;
+        while (pos_ < text_.size() && text_[pos_] != '"') {
+            char c = text_[pos_++];
+            if (c != '\\') {
+                out += c;
+                continue;
+            }
+            if (pos_ >= text_.size()) {
+                break;
+            }
+            c = text_[pos_++];
+            switch (c) {
+            case 'b':
+                out += '\b';
+                break;
+            case 'f':
+                out += '\f';
+                break;
+            case 'n':
+                out += '\n';
+                break;
+            case 'r':
+                out += '\r';
+                break;
+            case 't':
+                out += '\t';
+                break;
+            case 'u':
+                appendUtf8(out, codepoint());
+                break;
+            default:
+                out += c;
+            }
+        }
+        if (pos_ >= text_.size()) {
+            fail("unterminated string");
+        }
+        ++pos_;
+        return out;
+    }
+
+    uint32_t hex4() {
+        if (pos_ + 4 > text_.size()) {
+            fail("truncated \\u escape");
+        }
+        uint32_t value = 0;
+        for (int i = 0; i < 4; ++i) {
+            const char c = text_[pos_++];
+            value <<= 4;
+            if (c >= '0' && c <= '9') {
+                value |= c - '0';
+            } else if (c >= 'a' && c <= 'f') {
+                value |= c - 'a' + 10;
+            } else if (c >= 'A' && c <= 'F') {
+                value |= c - 'A' + 10;
+            } else {
+                fail("invalid \\u escape");
+            }
+        }
+        return value;
+    }
+
+    // UTF-16 代理对合并为一个码点；落单或不成对的代理项无法表示为 UTF-8，拒绝
+    uint32_t codepoint() {
+        const uint32_t value = hex4();
+        if (value >= 0xdc00 && value < 0xe000) {
+            fail("unpaired low surrogate in \\u escape");
+        }
+        if (value < 0xd800 || value >= 0xdc00) {
+            return value;
+        }
+        if (text_.compare(pos_, 2, "\\u") != 0) {
+            fail("unpaired high surrogate in \\u escape");
+        }
+        pos_ += 2;
+        const uint32_t low = hex4();
+        if (low < 0xdc00 || low >= 0xe000) {
+            fail("high surrogate not followed by a low surrogate in \\u escape");
+        }
+        return 0x10000 + ((value - 0xd800) << 10) + (low - 0xdc00);
+    }
+
+    static void appendUtf8(std::string &out, uint32_t cp) {
+        if (cp < 0x80) {
+            out += static_cast<char>(cp);
+        } else if (cp < 0x800) {
+            out += static_cast<char>(0xc0 | (cp >> 6));
+            out += static_cast<char>(0x80 | (cp & 0x3f));
+        } else if (cp < 0x10000) {
+            out += static_cast<char>(0xe0 | (cp >> 12));
+            out += static_cast<char>(0x80 | ((cp >> 6) & 0x3f));
+            out += static_cast<char>(0x80 | (cp & 0x3f));
+        } else {
+            out += static_cast<char>(0xf0 | (cp >> 18));
+            out += static_cast<char>(0x80 | ((cp >> 12) & 0x3f));
+            out += static_cast<char>(0x80 | ((cp >> 6) & 0x3f));
+            out += static_cast<char>(0x80 | (cp & 0x3f));
+        }
+    }
+
+    char peek() {
+        while (pos_ < text_.size() && std::isspace(static_cast<unsigned char>(text_[pos_]))) {
+            ++pos_;
+        }
+        return pos_ < text_.size() ? text_[pos_] : '\0';
+    }
+
+    void expect(char c) {
+        if (peek() != c) {
+            fail(std::string("expected '") + c + "'");
+        }
+        ++pos_;
+    }
+
+    [[noreturn]] void fail(const std::string &what) {
+        throw NmcliException("Invalid JSON at offset " + std::to_string(pos_) + ": " + what);
+    }
+
+    const std::string &text_;
+    size_t pos_ = 0;
+};
+
+// iwd 设置文件的值：反斜杠、换行、制表符、回车转义，行首空格写作 \s 以免被去掉
+std::string escapeSettingValue(const std::string &value) {
+    std::string out;
+    out.reserve(value.size());
+    for (size_t i = 0; i < value.size(); ++i) {
+        const char c = value[i];
+        switch (c) {
+        case '\\':
+            out += "\\\\";
+            break;
+        case '\n':
+            out += "\\n";
+            break;
+        case '\t':
+            out += "\\t";
+            break;
+        case '\r':
+            out += "\\r";
+            break;
+        case ' ':
+            out += i == 0 ? "\\s" : " ";
+            break;
+        default:
+            out += c;
+        }
+    }
+    return out;
+}
+
+bool isHexPsk(const std::string &value) {
+    return value.size() == 64 &&
+           std::all_of(value.begin(), value.end(), [](unsigned char c) { return std::isxdigit(c); });
+}
+
+std::string errorText() {
+    return std::string(strerror(errno));
+}
+
+bool writeAll(int fd, const std::string &data) {
+    size_t offset = 0;
+    while (offset < data.size()) {
+        ssize_t n = write(fd, data.data() + offset, data.size() - offset);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        offset += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+} // namespace
+
+std::vector<NetworkProfile> parseNetworkProfiles(const std::string &text) {
+    const size_t first = text.find_first_not_of(" \t\r\n");
+    std::vector<NetworkProfile> profiles;
+    if (first != std::string::npos && text[first] == '[') {
+        profiles = JsonReader(text).profiles();
+    } else {
+        // 跳过 UTF-8 BOM，表格软件导出的 CSV 经常带有
+        profiles = parseCsvProfiles(text.compare(0, 3, "\xEF\xBB\xBF") == 0 ? text.substr(3) : text);
+    }
+
+    for (auto &profile : profiles) {
+        profile.security = normalizeSecurity(profile.security, profile.passphrase);
+        if (profile.security == "8021x" && profile.eap_method.empty()) {
+            profile.eap_method = "PEAP";
+        }
+    }
+    return profiles;
+}
+
+std::string validateNetworkProfile(const NetworkProfile &profile) {
+    if (profile.ssid.empty() || profile.ssid.size() > 32) {
+        return "SSID must be 1 to 32 bytes";
+    }
+    if (profile.security == "open") {
+        return profile.passphrase.empty() ? "" : "open network cannot have a passphrase";
+    }
+    if (profile.security == "psk") {
+        if (isHexPsk(profile.passphrase)) {
+            return "";
+        }
+        if (profile.passphrase.size() < 8 || profile.passphrase.size() > 63) {
+            return "passphrase must be 8 to 63 characters or a 64-digit hex key";
+        }
+        if (std::any_of(profile.passphrase.begin(), profile.passphrase.end(), [](unsigned char c) {
+                return c < 32 || c > 126;
+            })) {
+            return "passphrase must be printable ASCII";
+        }
+        return "";
+    }
+    if (profile.security == "8021x") {
+        if (profile.identity.empty() || profile.passphrase.empty()) {
+            return "802.1x network needs an identity and a password";
+        }
+        const std::string eap = lower(profile.eap_method);
+        if (eap != "peap" && eap != "ttls") {
+            return "EAP method must be PEAP or TTLS";
+        }
+        return "";
+    }
+    return "unknown security type '" + profile.security + "'";
+}
+
+std::string iwdProfileFileName(const std::string &ssid, const std::string &security) {
+    const bool safe = std::all_of(ssid.begin(), ssid.end(), [](unsigned char c) {
+        return std::isalnum(c) || c == '-' || c == '_' || c == ' ';
+    });
+    if (safe) {
+        return ssid + "." + security;
+    }
+
+    static const char digits[] = "0123456789abcdef";
+    std::string name = "=";
+    for (unsigned char c : ssid) {
+        name += digits[c >> 4];
+        name += digits[c & 0x0f];
+    }
+    return name + "." + security;
+}
+
+std::string iwdProfileContents(const NetworkProfile &profile) {
+    std::string out;
+    if (profile.security == "psk") {
+        out += "[Security]\n";
+        out += isHexPsk(profile.passphrase) ? "PreSharedKey=" : "Passphrase=";
+        out += escapeSettingValue(profile.passphrase) + "\n";
+    } else if (profile.security == "8021x") {
+        // 两种隧道方法的键名只有前缀不同
+        const std::string method = lower(profile.eap_method) == "ttls" ? "TTLS" : "PEAP";
+        const std::string identity = escapeSettingValue(profile.identity);
+        out += "[Security]\n";
+        out += "EAP-Method=" + method + "\n";
+        out += "EAP-Identity=" + identity + "\n";
+        out += "EAP-" + method + "-Phase2-Method=MSCHAPV2\n";
+        out += "EAP-" + method + "-Phase2-Identity=" + identity + "\n";
+        out += "EAP-" + method + "-Phase2-Password=" + escapeSettingValue(profile.passphrase) + "\n";
+    }
+    if (!out.empty()) {
+        out += "\n";
+    }
+    out += "[Settings]\nAutoConnect=true\n";
+    return out;
+}
+
+ProfileWriteResult writeIwdProfiles(const std::string &dir, const std::vector<NetworkProfile> &profiles, bool replace) {
+    ProfileWriteResult result;
+
+    int dirfd = open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dirfd < 0) {
+        throw NmcliException("Failed to open " + dir + ": " + errorText());
+    }
+
+    // 输入内同一个配置文件出现两次时以后一次为准会掩盖输入错误，直接报告
+    std::map<std::string, int> seen;
+    std::vector<std::pair<std::string, std::string>> pending; // 临时文件名、最终文件名
+    std::vector<const NetworkProfile *> pendingProfiles;
+    const std::string suffix = "." + std::to_string(getpid()) + ".tmp";
+
+    auto fail = [&result](const NetworkProfile &profile, const std::string &what) {
+        result.errors.push_back(
+            (profile.line > 0 ? "#" + std::to_string(profile.line) + " " : "") + "'" + profile.ssid + "': " + what
+        );
+    };
+
+    for (const auto &profile : profiles) {
+        std::string error = validateNetworkProfile(profile);
+        if (!error.empty()) {
+            fail(profile, error);
+            continue;
+        }
+
+        const std::string name = iwdProfileFileName(profile.ssid, profile.security);
+        auto [it, inserted] = seen.emplace(name, profile.line);
+        if (!inserted) {
+            fail(profile, "duplicate of #" + std::to_string(it->second));
+            continue;
+        }
+
+        struct stat st;
+        if (!replace && fstatat(dirfd, name.c_str(), &st, 0) == 0) {
+            result.skipped++;
+            continue;
+        }
+
+        // 凭据只允许 iwd（root）读取，与 iwd 自己保存的文件一致
+        const std::string tmp = "." + name + suffix;
+        int fd = openat(dirfd, tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+        if (fd < 0) {
+            fail(profile, "failed to create " + tmp + ": " + errorText());
+            continue;
+        }
+        const bool ok = writeAll(fd, iwdProfileContents(profile));
+        const std::string writeError = ok ? "" : errorText();
+        close(fd);
+        if (!ok) {
+            unlinkat(dirfd, tmp.c_str(), 0);
+            fail(profile, "failed to write " + tmp + ": " + writeError);
+            continue;
+        }
+        pending.emplace_back(tmp, name);
+        pendingProfiles.push_back(&profile);
+    }
+
+    // 一次落盘所有临时文件，rename 之后 iwd 读到的一定是完整内容
+    if (!pending.empty() && syncfs(dirfd) < 0) {
+        const std::string reason = errorText();
+        for (const auto &[tmp, name] : pending) {
+            unlinkat(dirfd, tmp.c_str(), 0);
+        }
+        close(dirfd);
+        throw NmcliException("Failed to sync " + dir + ": " + reason);
+    }
+
+    for (size_t i = 0; i < pending.size(); ++i) {
+        const auto &[tmp, name] = pending[i];
+        if (renameat(dirfd, tmp.c_str(), dirfd, name.c_str()) < 0) {
+            fail(*pendingProfiles[i], "failed to rename to " + name + ": " + errorText());
+            unlinkat(dirfd, tmp.c_str(), 0);
+            continue;
+        }
+        result.written++;
+        result.written_ssid.push_back(pendingProfiles[i]->ssid);
+    }
+
+    if (result.written > 0) {
+        fsync(dirfd);
+    }
+    close(dirfd);
+    return result;
+}
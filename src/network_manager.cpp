@@ -1,6 +1,26 @@
 #include <network_manager.h>
 #include <iwd_manager.h>
+#include <iwd_interfaces.h>
 #include <station.h>
+#include <nl80211_client.h>
+#include <link_sampler.h>
+#include <link_stats.h>
+#include <rtnl_dump.h>
+#include <rtnl_monitor.h>
+#include <scan_coordinator.h>
+#include <signal_quality.h>
+#include <deadline.h>
+#include <diagnostics.h>
+#include <instrumentation.h>
+#include <metrics_exporter.h>
+#include <netns.h>
+#include <probes.h>
+#include <network_import.h>
+#include <property_cache.h>
+#include <state_publisher.h>
+#include <state_watcher.h>
+#include <state_shm.h>
+#include <trace.h>
 #include <netlink/netlink.h>
 #include <netlink/route/route.h>
 #include <netlink/route/link.h>
@@ -16,11 +36,26 @@
 #include <thread>
 #include <string>
 #include <sstream>
+#include <fstream>
+#include <iterator>
+#include <set>
 #include <iomanip>
 #include <functional>
 #include <regex>
-
-static std::string stringToUUID(const std::string &input) {
+#include <map>
+#include <optional>
+#include <array>
+#include <numeric>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <cerrno>
+#include <ctime>
+#include <unistd.h>
+#include <net/if.h>
+#include <fnmatch.h>
+
+std::string stringToUUID(const std::string &input) {
     // 使用多个哈希函数模拟MD5的128位输出
     size_t hash1 = std::hash<std::string>{}(input);
     size_t hash2 = std::hash<std::string>{}(input + "_salt1");
@@ -69,11 +104,88 @@ static std::string stringToUUID(const std::string &input) {
     return ss.str();
 }
 
+// Set by SIGINT/SIGTERM to stop long-running sampling loops
+static volatile std::sig_atomic_t stop_requested = 0;
+
+static void requestStop(int) {
+    stop_requested = 1;
+}
+
+static void installStopHandler() {
+    // No SA_RESTART so that clock_nanosleep returns early on Ctrl-C
+    struct sigaction action {};
+    action.sa_handler = requestStop;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGINT, &action, nullptr);
+    sigaction(SIGTERM, &action, nullptr);
+}
+
+// Waits until iwd has a KnownNetwork for every name in missing, following InterfacesAdded;
+// returns how many are still missing when the wait ends
+static DBusTask<size_t> waitForKnownNetworks(
+    DBusEventLoop &loop, sdbus::IProxy &root, std::set<std::string> missing, DBusEventLoop::Clock::duration timeout
+) {
+    auto loaded = [&missing](const sdbus::ObjectPath &, const DBusInterfaceWait::Interfaces &interfaces) {
+        const auto &properties = interfaces.at("net.connman.iwd.KnownNetwork");
+        auto name = properties.find("Name");
+        if (name != properties.end() && name->second.containsValueOfType<std::string>()) {
+            missing.erase(name->second.get<std::string>());
+        }
+        return missing.empty();
+    };
+    co_await DBusInterfaceWait(loop, root, "net.connman.iwd.KnownNetwork", "/net/connman/iwd/", timeout, loaded);
+    co_return missing.size();
+}
+
+// LastConnectedTime (ISO 8601, UTC) is earlier than cutoff; a network that never connected counts as older
+// than any cutoff, while an unparsable time never does so that nothing is deleted by accident
+static bool lastConnectedBefore(const std::string &last_connected, std::time_t cutoff) {
+    if (last_connected.empty()) {
+        return true;
+    }
+    struct tm tm {};
+    const char *end = strptime(last_connected.c_str(), "%Y-%m-%dT%H:%M:%S", &tm);
+    if (!end) {
+        return false;
+    }
+    return timegm(&tm) < cutoff;
+}
+
 NetworkManager::NetworkManager() = default;
 
 NetworkManager::~NetworkManager() = default;
 
+bool NetworkManager::readSharedState(ShmState &state) {
+    // Mapped once; every read after that is a plain memory copy
+    if (!shm_reader_) {
+        shm_reader_ = std::make_unique<ShmStateReader>(shm_path.c_str());
+    }
+    if (!shm_reader_->valid()) {
+        std::cerr << "Error: no state published at " << shm_path << " (see 'state publish')" << std::endl;
+        return false;
+    }
+    if (!shm_reader_->read(state)) {
+        std::cerr << "Error: no consistent, well-formed state snapshot in " << shm_path << std::endl;
+        return false;
+    }
+    if (state.generation == 0) {
+        std::cerr << "Error: no state published at " << shm_path << " yet" << std::endl;
+        return false;
+    }
+    if (!shmStateFresh(state)) {
+        std::cerr << "Error: state in " << shm_path << " was last published " << shmStateAgeMs(state) / 1000
+                  << "s ago, is 'state publish' still running?" << std::endl;
+        return false;
+    }
+    return true;
+}
+
 std::string NetworkManager::getConnectivity() {
+    if (!shm_path.empty()) {
+        ShmState state;
+        return readSharedState(state) ? std::string(state.connectivity) : "unknown";
+    }
+
     // 使用智能指针和自定义删除器管理资源
     struct SocketDeleter {
         void operator()(struct nl_sock *sock) const {
@@ -106,7 +218,14 @@ std::string NetworkManager::getConnectivity() {
     // 使用unique_ptr管理route cache资源
     std::unique_ptr<struct nl_cache, CacheDeleter> route_cache;
     struct nl_cache *route_cache_raw = nullptr;
-    if (rtnl_route_alloc_cache(sock.get(), AF_UNSPEC, 0, &route_cache_raw) < 0) {
+    Deadline::global().applyReceiveTimeout(nl_socket_get_fd(sock.get()));
+    int err = Trace::global().netlinkCache(
+        sock.get(), "route/route", "RTM_GETROUTE",
+        [&sock](struct nl_cache **cache) { return rtnl_route_alloc_cache(sock.get(), AF_UNSPEC, 0, cache); },
+        &route_cache_raw
+    );
+    Deadline::global().check("checking connectivity");
+    if (err < 0) {
         return "unknown";
     }
 
@@ -140,28 +259,150 @@ std::string NetworkManager::getConnectivity() {
     return has_default_route ? "full" : "none";
 }
 
-bool NetworkManager::setWifiRadio(bool enabled) {
+std::vector<NetnsSnapshot> NetworkManager::scanSelectedNetns(bool &complete) {
+    std::vector<std::string> names;
+    if (netns == "all") {
+        names = listNamedNetns();
+    } else {
+        names.push_back(netns);
+    }
+
+    auto snapshots = scanNetns(names);
+    complete = true;
+    for (const auto &snapshot : snapshots) {
+        if (!snapshot.error.empty()) {
+            std::cerr << "Error: netns " << snapshot.name << ": " << snapshot.error << std::endl;
+            complete = false;
+        }
+    }
+    return snapshots;
+}
+
+bool NetworkManager::showNetnsConnectivity() {
+    bool complete = false;
+    auto snapshots = scanSelectedNetns(complete);
+
+    std::vector<std::vector<std::string>> table_data;
+    for (const auto &snapshot : snapshots) {
+        if (snapshot.error.empty()) {
+            table_data.push_back({snapshot.name, snapshot.has_default_route ? "full" : "none"});
+        }
+    }
+    printFormattedTable(table_data, {"NETNS", "CONNECTIVITY"});
+    return complete;
+}
+
+bool NetworkManager::listNetnsDevices() {
+    static const std::vector<std::string> all_fields = {"NETNS", "DEVICE", "TYPE", "STATE"};
+    std::vector<size_t> columns;
+    std::vector<std::string> headers;
+    for (size_t i = 0; i < all_fields.size(); ++i) {
+        if (field_selection.empty() ||
+            std::find(field_selection.begin(), field_selection.end(), all_fields[i]) != field_selection.end()) {
+            columns.push_back(i);
+            headers.push_back(all_fields[i]);
+        }
+    }
+
+    bool complete = false;
+    auto snapshots = scanSelectedNetns(complete);
+
+    std::vector<std::vector<std::string>> table_data;
+    for (const auto &snapshot : snapshots) {
+        for (const auto &[ifindex, link] : snapshot.links) {
+            const std::string values[] = {
+                snapshot.name, link.name, link.type, RtnlDump::operstateToString(link.operstate)
+            };
+            std::vector<std::string> row;
+            row.reserve(columns.size());
+            for (size_t column : columns) {
+                row.push_back(values[column]);
+            }
+            table_data.push_back(std::move(row));
+        }
+    }
+    printFormattedTable(table_data, headers);
+    return complete;
+}
+
+bool NetworkManager::setWifiRadio(bool enabled, bool until_ready) {
     try {
         IwdManager iwdManager;
-        return iwdManager.setWifiRadioState(enabled);
+        if (!until_ready || !enabled) {
+            // Powering off already waits for Powered to become false
+            return iwdManager.setWifiRadioState(enabled);
+        }
+
+        DBusEventLoop loop(iwdManager.connection());
+        std::optional<IwdManager::RadioPowerUp> powerUp = loop.run(iwdManager.powerUpWifiAsync(loop));
+        if (!powerUp) {
+            Deadline::global().check("waiting for the WiFi station");
+            std::cerr << "Timed out waiting for the WiFi station to become available" << std::endl;
+            return false;
+        }
+
+        // Same per-stage breakdown as connection up --until-ready
+        std::vector<std::vector<std::string>> table_data;
+        auto previous = powerUp->start;
+        auto addStage = [&](const std::string &stage, std::chrono::steady_clock::time_point when,
+                            const std::string &detail) {
+            auto since_start = std::chrono::duration_cast<std::chrono::milliseconds>(when - powerUp->start).count();
+            auto delta = std::chrono::duration_cast<std::chrono::milliseconds>(when - previous).count();
+            table_data.push_back({stage, std::to_string(since_start), std::to_string(delta), detail});
+            previous = when;
+        };
+        addStage("powered", powerUp->powered, "-");
+        addStage("station", powerUp->station, powerUp->device);
+        addStage("state", powerUp->ready, powerUp->state);
+
+        printFormattedTable(table_data, {"STAGE", "ELAPSED(ms)", "DELTA(ms)", "DETAIL"});
+        return true;
     } catch (const std::exception &e) {
         std::cerr << "Error setting WiFi radio state: " << e.what() << std::endl;
         return false;
     }
 }
 
-bool NetworkManager::getWifiRadioState() {
+std::optional<bool> NetworkManager::getWifiRadioState() {
+    if (!shm_path.empty()) {
+        ShmState state;
+        if (!readSharedState(state)) {
+            return std::nullopt;
+        }
+        if (state.radio_enabled < 0) {
+            std::cerr << "Error: WiFi radio state unknown, iwd was not available to the publisher" << std::endl;
+            return std::nullopt;
+        }
+        return state.radio_enabled == 1;
+    }
+
     try {
         IwdManager iwdManager;
         return iwdManager.getWifiRadioState();
     } catch (const std::exception &e) {
         std::cerr << "Error getting WiFi radio state: " << e.what() << std::endl;
-        return false;
+        return std::nullopt;
     }
 }
 
-std::vector<NetworkManager::DeviceInfo> NetworkManager::listDevices() {
-    std::vector<DeviceInfo> devices;
+bool NetworkManager::listDevices(std::vector<DeviceInfo> &devices) {
+    devices.clear();
+
+    if (!shm_path.empty()) {
+        ShmState state;
+        if (!readSharedState(state)) {
+            return false;
+        }
+        for (uint32_t i = 0; i < state.link_count; ++i) {
+            const ShmLinkRecord &link = state.links[i];
+            devices.push_back({link.device, link.type, link.operstate});
+        }
+        if (state.links_truncated) {
+            std::cerr << "Warning: " << shm_path << " holds only the first " << SHM_MAX_LINKS << " devices"
+                      << std::endl;
+        }
+        return true;
+    }
 
     // 使用在getConnectivity方法中定义的智能指针和自定义删除器管理资源
     struct SocketDeleter {
@@ -184,19 +425,29 @@ std::vector<NetworkManager::DeviceInfo> NetworkManager::listDevices() {
     // 使用unique_ptr管理netlink socket资源
     std::unique_ptr<struct nl_sock, SocketDeleter> sock(nl_socket_alloc());
     if (!sock) {
-        return devices;
+        diag() << "Error: failed to allocate netlink socket" << std::endl;
+        return false;
     }
 
     // Connect to netlink
     if (nl_connect(sock.get(), NETLINK_ROUTE) < 0) {
-        return devices;
+        diag() << "Error: failed to connect to netlink" << std::endl;
+        return false;
     }
 
     // 使用unique_ptr管理link cache资源
     std::unique_ptr<struct nl_cache, CacheDeleter> link_cache;
     struct nl_cache *link_cache_raw = nullptr;
-    if (rtnl_link_alloc_cache(sock.get(), AF_UNSPEC, &link_cache_raw) < 0) {
-        return devices;
+    Deadline::global().applyReceiveTimeout(nl_socket_get_fd(sock.get()));
+    int err = Trace::global().netlinkCache(
+        sock.get(), "route/link", "RTM_GETLINK",
+        [&sock](struct nl_cache **cache) { return rtnl_link_alloc_cache(sock.get(), AF_UNSPEC, cache); },
+        &link_cache_raw
+    );
+    Deadline::global().check("listing devices");
+    if (err < 0) {
+        diag() << "Error listing devices: " << nl_geterror(err) << std::endl;
+        return false;
     }
 
     // 将原始指针包装到unique_ptr中
@@ -237,10 +488,124 @@ std::vector<NetworkManager::DeviceInfo> NetworkManager::listDevices() {
         devices.push_back(device_info);
     }
 
-    return devices;
+    return true;
+}
+
+std::string NetworkManager::getIwdConnectionName() {
+    try {
+        IwdManager iwdManager;
+        auto station = iwdManager.createStation();
+        if (!station) {
+            return "";
+        }
+
+        std::string connectedNetworkPath = station->getConnectedNetwork();
+        if (connectedNetworkPath.empty()) {
+            return "";
+        }
+
+        auto networkProxy = station->objectProxy(sdbus::ObjectPath{connectedNetworkPath});
+        return IwdNetworkProxy(*networkProxy).name();
+    } catch (const std::exception &) {
+        return "";
+    }
+}
+
+bool NetworkManager::showDevice(const std::string &ifname) {
+    std::map<int, RtnlDump::LinkRecord> links;
+    try {
+        // Links, addresses and routes come from one rtnetlink socket and are joined by ifindex
+        RtnlDump rtnl;
+        links = rtnl.collect();
+    } catch (const std::exception &e) {
+        std::cerr << "Error reading device information: " << e.what() << std::endl;
+        return false;
+    }
+
+    // A selected field matches either a whole section (GENERAL) or a single field (GENERAL.MTU)
+    auto is_selected = [this](const std::string &field) {
+        if (field_selection.empty()) {
+            return true;
+        }
+        std::string section = field.substr(0, field.find('.'));
+        std::string base = field.substr(0, field.find('['));
+        return std::find(field_selection.begin(), field_selection.end(), section) != field_selection.end() ||
+               std::find(field_selection.begin(), field_selection.end(), base) != field_selection.end();
+    };
+
+    bool found = false;
+    bool wifi_connection_loaded = false;
+    std::string wifi_connection;
+
+    for (const auto &entry : links) {
+        const RtnlDump::LinkRecord &link = entry.second;
+        if (!ifname.empty() && link.name != ifname) {
+            continue;
+        }
+
+        std::vector<std::pair<std::string, std::string>> fields;
+        fields.emplace_back("GENERAL.DEVICE", link.name);
+        fields.emplace_back("GENERAL.TYPE", link.type);
+        fields.emplace_back("GENERAL.HWADDR", link.hwaddr);
+        fields.emplace_back("GENERAL.MTU", std::to_string(link.mtu));
+        fields.emplace_back("GENERAL.STATE", RtnlDump::operstateToString(link.operstate));
+
+        std::string connection;
+        if (link.type == "wifi") {
+            // Only ask iwd once, even when several wifi devices are shown
+            if (!wifi_connection_loaded) {
+                wifi_connection = getIwdConnectionName();
+                wifi_connection_loaded = true;
+            }
+            connection = wifi_connection;
+        } else if (link.type == "loopback") {
+            connection = "lo";
+        }
+        fields.emplace_back("GENERAL.CONNECTION", connection);
+
+        int ipv4_index = 0;
+        int ipv6_index = 0;
+        for (const auto &address : link.addresses) {
+            int &index = address.family == AF_INET ? ipv4_index : ipv6_index;
+            std::string name =
+                (address.family == AF_INET ? "IP4.ADDRESS[" : "IP6.ADDRESS[") + std::to_string(++index) + "]";
+            fields.emplace_back(std::move(name), address.address + "/" + std::to_string(address.prefixlen));
+        }
+        fields.emplace_back("IP4.GATEWAY", link.ipv4_gateway);
+        fields.emplace_back("IP6.GATEWAY", link.ipv6_gateway);
+
+        // Devices are separated by a blank line, like nmcli
+        if (found && !terse_output) {
+            std::cout << std::endl;
+        }
+        found = true;
+
+        for (const auto &field : fields) {
+            if (!is_selected(field.first)) {
+                continue;
+            }
+            const std::string &value = field.second.empty() ? std::string("--") : field.second;
+            if (terse_output) {
+                std::cout << field.first << ":" << value << std::endl;
+            } else {
+                std::cout << std::left << std::setw(40) << (field.first + ":") << value << std::endl;
+            }
+        }
+    }
+
+    if (!found) {
+        std::cerr << "Error: Device '" << ifname << "' not found." << std::endl;
+        return false;
+    }
+
+    return true;
 }
 
-bool NetworkManager::activateConnection(const std::string &ssid) {
+bool NetworkManager::activateConnection(const std::string &ssid, bool until_ready) {
+    if (until_ready) {
+        return activateConnectionAndWait(ssid);
+    }
+
     try {
         // Create IwdManager instance
         IwdManager iwdManager;
@@ -264,6 +629,215 @@ bool NetworkManager::activateConnection(const std::string &ssid) {
     }
 }
 
+bool NetworkManager::activateConnectionAndWait(const std::string &ssid) {
+    using Clock = std::chrono::steady_clock;
+
+    try {
+        IwdManager iwdManager;
+        auto station = iwdManager.createStation();
+        if (!station) {
+            throw NetworkException("Failed to create Station instance");
+        }
+
+        // Replay needs neither the interface nor the kernel: the monitor stays silent and the
+        // recorded dumps below provide the address and the route
+        const std::string ifname = station->getDeviceName();
+        const int ifindex = static_cast<int>(if_nametoindex(ifname.c_str()));
+        if (ifindex == 0 && !Trace::global().replaying()) {
+            throw NetworkException("Unknown interface '" + ifname + "'");
+        }
+
+        // Subscribe before Connect so that no address or route notification can be missed
+        RtnlMonitor monitor(ifindex);
+        DBusEventLoop loop(iwdManager.connection());
+
+        std::optional<Clock::time_point> associated, addressed, routed;
+        std::string address, gateway;
+        bool resync = false;
+
+        // rtnetlink notifications are handled on the same loop as the D-Bus signals, so stages that
+        // complete before iwd reports "connected" (iwd's own netconfig) still get their own timestamp
+        const uint64_t watch = loop.addWatch(monitor.fd(), [&] {
+            monitor.drain([&](const RtnlMonitor::Event &event) {
+                if (event.type == RtnlMonitor::EventType::AddressAdded && !addressed) {
+                    addressed = Clock::now();
+                    address = event.detail;
+                } else if (event.type == RtnlMonitor::EventType::DefaultRouteAdded && !routed) {
+                    routed = Clock::now();
+                    gateway = event.detail;
+                } else if (event.type == RtnlMonitor::EventType::Overflow) {
+                    resync = true;
+                }
+            });
+        });
+
+        // Address and route that already exist (e.g. reconnecting to the current network) or that were
+        // lost to a socket overflow are picked up from a single dump
+        auto checkExisting = [&] {
+            RtnlDump dump;
+            auto links = dump.collect();
+            auto link = std::find_if(links.begin(), links.end(), [&](const auto &entry) {
+                return entry.second.name == ifname;
+            });
+            if (link == links.end()) {
+                return;
+            }
+            const Clock::time_point now = Clock::now();
+            for (const auto &addr : link->second.addresses) {
+                if (!addressed && RtnlDump::usableAddress(addr.family, addr.scope, addr.flags)) {
+                    addressed = now;
+                    address = addr.address;
+                }
+            }
+            const std::string &gw =
+                link->second.ipv4_gateway.empty() ? link->second.ipv6_gateway : link->second.ipv4_gateway;
+            if (!routed && !gw.empty()) {
+                routed = now;
+                gateway = gw;
+            }
+        };
+
+        // Scanning and looking up the network are not part of the measured connect time
+        std::string networkPath = loop.run(iwdManager.findNetworkAsync(loop, *station, ssid));
+
+        const Clock::time_point start = Clock::now();
+        if (!loop.run(iwdManager.connectNetworkAsync(loop, *station, networkPath))) {
+            Deadline::global().check("waiting for association");
+            std::cerr << "Timed out waiting for '" << ssid << "' to associate" << std::endl;
+            loop.removeWatch(watch);
+            return false;
+        }
+        associated = Clock::now();
+
+        if (!addressed || !routed) {
+            checkExisting();
+        }
+
+        bool timed_out = false;
+        const uint64_t timer = loop.addTimer(
+            Clock::now() + Deadline::global().remainingOr(std::chrono::seconds(30)), [&] { timed_out = true; }
+        );
+        loop.runUntil([&] {
+            if (resync) {
+                resync = false;
+                checkExisting();
+            }
+            return (addressed && routed) || timed_out;
+        });
+        loop.cancelTimer(timer);
+        loop.removeWatch(watch);
+
+        if (!addressed || !routed) {
+            Deadline::global().check(addressed ? "waiting for a default route" : "waiting for an address");
+            std::cerr << "Timed out waiting for " << (addressed ? "a default route" : "an address") << " on "
+                      << ifname << std::endl;
+            return false;
+        }
+
+        // Per-stage breakdown; a stage can finish before the previous one when iwd configures the network itself
+        std::vector<std::vector<std::string>> table_data;
+        Clock::time_point previous = start;
+        auto addStage = [&](const std::string &stage, Clock::time_point when, const std::string &detail) {
+            auto since_start = std::chrono::duration_cast<std::chrono::milliseconds>(when - start).count();
+            auto delta = std::chrono::duration_cast<std::chrono::milliseconds>(when - previous).count();
+            table_data.push_back(
+                {stage, std::to_string(since_start), std::to_string(std::max<decltype(delta)>(delta, 0)), detail}
+            );
+            previous = std::max(previous, when);
+        };
+        addStage("association", *associated, ifname);
+        addStage("address", *addressed, address);
+        addStage("route", *routed, gateway.empty() ? "-" : "via " + gateway);
+
+        printFormattedTable(table_data, {"STAGE", "ELAPSED(ms)", "DELTA(ms)", "DETAIL"});
+        return true;
+    } catch (const sdbus::Error &e) {
+        std::cerr << "D-Bus error connecting to '" << ssid << "': " << e.what() << std::endl;
+        return false;
+    } catch (const std::exception &e) {
+        std::cerr << "Error connecting to '" << ssid << "': " << e.what() << std::endl;
+        return false;
+    }
+}
+
+bool NetworkManager::activateBestConnection(bool watch) {
+    try {
+        IwdManager iwdManager;
+        auto station = iwdManager.createStation();
+        if (!station) {
+            throw NetworkException("Failed to create Station instance");
+        }
+
+        DBusEventLoop loop(iwdManager.connection());
+
+        if (!watch) {
+            const auto start = std::chrono::steady_clock::now();
+            int attempts = 0;
+            std::string ssid = loop.run(iwdManager.connectBestAsync(loop, *station, &attempts));
+            if (ssid.empty()) {
+                std::cerr << "No known network in range could be activated" << std::endl;
+                return false;
+            }
+
+            auto elapsed =
+                std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+            if (terse_output) {
+                std::cout << ssid << ":" << elapsed.count() << ":" << attempts << std::endl;
+            } else {
+                std::cout << "Connection '" << ssid << "' activated successfully in " << elapsed.count() << " ms ("
+                          << attempts << (attempts == 1 ? " attempt)" : " attempts)") << std::endl;
+            }
+            return true;
+        }
+
+        installStopHandler();
+
+        // Time-to-connect statistics over the whole watch session
+        uint64_t reconnects = 0;
+        std::chrono::milliseconds total{0};
+        std::chrono::milliseconds fastest = std::chrono::milliseconds::max();
+        std::chrono::milliseconds slowest{0};
+
+        auto task = iwdManager.watchAndReconnectAsync(loop, *station, [&](const IwdManager::ReconnectEvent &event) {
+            reconnects++;
+            total += event.elapsed;
+            fastest = std::min(fastest, event.elapsed);
+            slowest = std::max(slowest, event.elapsed);
+
+            if (terse_output) {
+                std::cout << event.ssid << ":" << event.elapsed.count() << ":" << event.attempts << std::endl;
+            } else {
+                std::cout << "Reconnected to '" << event.ssid << "' in " << event.elapsed.count()
+                          << " ms from disconnect (" << event.attempts
+                          << (event.attempts == 1 ? " attempt)" : " attempts)") << std::endl;
+            }
+        });
+
+        // The watch task never finishes on its own; a signal interrupts poll() and ends the loop
+        task.start();
+        loop.runUntil([&task] { return stop_requested || task.done(); });
+        if (task.done()) {
+            task.result();
+        }
+
+        if (reconnects > 0) {
+            std::fprintf(
+                stderr, "%llu reconnects, time to connect min %lld ms, avg %lld ms, max %lld ms\n",
+                static_cast<unsigned long long>(reconnects), static_cast<long long>(fastest.count()),
+                static_cast<long long>(total.count() / static_cast<long long>(reconnects)),
+                static_cast<long long>(slowest.count())
+            );
+        }
+        return true;
+    } catch (const sdbus::Error &e) {
+        std::cerr << "D-Bus error activating best connection: " << e.what() << std::endl;
+        return false;
+    } catch (const std::exception &e) {
+        std::cerr << "Error activating best connection: " << e.what() << std::endl;
+        return false;
+    }
+}
+
 bool NetworkManager::deactivateConnection(const std::string &ssid) {
     try {
         // Create IwdManager instance
@@ -286,9 +860,8 @@ bool NetworkManager::deactivateConnection(const std::string &ssid) {
         }
 
         // Get the SSID of the connected network
-        std::string connectedSSID = station->getPropertyFromObjectPath<std::string>(
-            sdbus::ObjectPath{connectedNetworkPath}, "net.connman.iwd.Network", "Name"
-        );
+        auto networkProxy = station->objectProxy(sdbus::ObjectPath{connectedNetworkPath});
+        std::string connectedSSID = IwdNetworkProxy(*networkProxy).name();
 
         // Check if the connected network matches the requested SSID
         if (connectedSSID != ssid) {
@@ -305,67 +878,176 @@ bool NetworkManager::deactivateConnection(const std::string &ssid) {
     }
 }
 
-bool NetworkManager::deleteConnection(const std::string &ssid) {
+bool NetworkManager::deleteConnections(
+    const std::vector<std::string> &patterns, std::optional<std::chrono::seconds> older_than
+) {
     try {
-        // Create IwdManager instance
         IwdManager iwdManager;
+        DBusEventLoop loop(iwdManager.connection());
 
-        // Create Station instance
-        auto station = iwdManager.createStation();
-        if (!station) {
-            std::cerr << "Failed to create Station instance" << std::endl;
-            return false;
+        // Every target is resolved from one KnownNetwork enumeration
+        const auto networks = loop.run(iwdManager.listKnownNetworksAsync(loop));
+
+        std::optional<std::time_t> cutoff;
+        if (older_than) {
+            cutoff = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now() - *older_than);
         }
-        auto wifiConnections = station->getAllConnection();
 
-        for (const auto &networkPath : wifiConnections) {
-            std::string networkSSID = station->getPropertyFromObjectPath<std::string>(
-                sdbus::ObjectPath{networkPath}, "net.connman.iwd.KnownNetwork", "Name"
-            );
+        std::vector<bool> pattern_matched(patterns.size(), false);
+        std::vector<bool> pattern_selected(patterns.size(), false);
+        std::vector<const IwdManager::KnownNetwork *> targets;
+        for (const auto &network : networks) {
+            const bool recent = cutoff && !lastConnectedBefore(network.last_connected, *cutoff);
+            bool selected = patterns.empty() && !recent;
+            for (size_t p = 0; p < patterns.size(); ++p) {
+                // Exact comparison first: SSIDs may contain glob characters such as '['
+                if (network.name == patterns[p] || fnmatch(patterns[p].c_str(), network.name.c_str(), 0) == 0) {
+                    pattern_matched[p] = true;
+                    if (!recent) {
+                        pattern_selected[p] = true;
+                        selected = true;
+                    }
+                }
+            }
+            if (selected) {
+                targets.push_back(&network);
+            }
+        }
 
-            if (networkSSID == ssid) {
-                // Call the Forget method on the KnownNetwork object
-                station->callMethodFromObjectPath<bool>(
-                    sdbus::ObjectPath{networkPath}, "net.connman.iwd.KnownNetwork", "Forget"
-                );
-                std::cout << "Successfully deleted connection '" << ssid << "'" << std::endl;
-                return true;
+        bool ok = true;
+        for (size_t p = 0; p < patterns.size(); ++p) {
+            if (!pattern_matched[p]) {
+                std::cerr << "Network '" << patterns[p] << "' not found in known networks" << std::endl;
+                ok = false;
+            } else if (!pattern_selected[p]) {
+                // Every match was used more recently than --older-than allows; not an error
+                std::cout << "Network '" << patterns[p] << "' skipped: connected within the --older-than period"
+                          << std::endl;
             }
         }
 
-        std::cerr << "Network '" << ssid << "' not found in known networks" << std::endl;
+        // All Forget calls are sent before the first reply is awaited, so the batch costs about one round trip
+        std::vector<DBusTask<std::string>> forgets;
+        forgets.reserve(targets.size());
+        for (const auto *network : targets) {
+            forgets.push_back(iwdManager.forgetKnownNetworkAsync(loop, network->path));
+        }
+        loop.runAll(forgets);
+
+        for (size_t n = 0; n < targets.size(); ++n) {
+            const std::string error = forgets[n].result();
+            if (error.empty()) {
+                std::cout << "Connection '" << targets[n]->name << "' deleted successfully" << std::endl;
+            } else {
+                std::cerr << "Failed to delete connection '" << targets[n]->name << "': " << error << std::endl;
+                ok = false;
+            }
+        }
+
+        if (targets.empty() && patterns.empty() && !terse_output) {
+            std::cerr << "No known networks to delete" << std::endl;
+        }
+        return ok;
+    } catch (const sdbus::Error &e) {
+        std::cerr << "D-Bus error deleting connections: " << e.what() << std::endl;
+        return false;
+    } catch (const std::exception &e) {
+        std::cerr << "Error deleting connections: " << e.what() << std::endl;
         return false;
+    }
+}
+
+bool NetworkManager::importConnections(const std::string &file, const std::string &storage_dir, bool replace) {
+    try {
+        std::string text;
+        if (file == "-") {
+            text.assign(std::istreambuf_iterator<char>(std::cin), std::istreambuf_iterator<char>());
+        } else {
+            std::ifstream input(file, std::ios::binary);
+            if (!input) {
+                std::cerr << "Failed to open " << file << std::endl;
+                return false;
+            }
+            text.assign(std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>());
+        }
+
+        const auto profiles = parseNetworkProfiles(text);
+        const std::string dir = storage_dir.empty() ? IWD_STORAGE_DIR : storage_dir;
+        const ProfileWriteResult result = writeIwdProfiles(dir, profiles, replace);
+
+        for (const auto &error : result.errors) {
+            std::cerr << "Failed to import " << error << std::endl;
+        }
+        if (!terse_output) {
+            std::cout << "Imported " << result.written << " of " << profiles.size() << " networks into " << dir;
+            if (result.skipped > 0) {
+                std::cout << " (" << result.skipped << " already present, use --replace to overwrite)";
+            }
+            std::cout << std::endl;
+        }
+
+        // iwd watches its storage directory with inotify; confirm the new profiles became KnownNetworks
+        // as their InterfacesAdded signals arrive. A custom --storage-dir is usually a staging area,
+        // so it is not checked.
+        if (storage_dir.empty() && result.written > 0) {
+            IwdManager iwdManager;
+            DBusEventLoop loop(iwdManager.connection());
+            auto root = sdbus::createProxy(
+                iwdManager.connection(), sdbus::ServiceName{"net.connman.iwd"}, sdbus::ObjectPath{"/"}
+            );
+            const size_t missing = loop.run(waitForKnownNetworks(
+                loop, *root, std::set<std::string>(result.written_ssid.begin(), result.written_ssid.end()),
+                Deadline::global().remainingOr(std::chrono::seconds(2))
+            ));
+            if (missing > 0) {
+                std::cerr << "iwd has not loaded " << missing << " imported networks yet; check that " << dir
+                          << " is its storage directory" << std::endl;
+            }
+        }
+
+        return result.errors.empty();
     } catch (const sdbus::Error &e) {
-        std::cerr << "D-Bus error deleting connection '" << ssid << "': " << e.what() << std::endl;
+        std::cerr << "D-Bus error importing connections: " << e.what() << std::endl;
         return false;
     } catch (const std::exception &e) {
-        std::cerr << "Error deleting connection '" << ssid << "': " << e.what() << std::endl;
+        std::cerr << "Error importing connections: " << e.what() << std::endl;
         return false;
     }
 }
 
-void NetworkManager::showConnections() {
+std::vector<NetworkManager::ConnectionInfo> NetworkManager::collectConnections(bool active_only) {
     std::vector<ConnectionInfo> connections;
     IwdManager iwdManager;
     auto station = iwdManager.createStation();
     if (!station) {
-        std::cerr << "Failed to create Station instance" << std::endl;
-        return;
+        throw NetworkException("Failed to create Station instance");
     }
 
     std::string currentSSID;
     auto wired_cnt = 0;
-    auto devices = listDevices();
+    std::vector<DeviceInfo> devices;
+    if (!listDevices(devices)) {
+        throw NetworkException("Failed to list devices");
+    }
     for (const auto &device : devices) {
+        // --active: only devices that carry traffic; loopback reports operstate "unknown"
+        if (active_only && device.state != "up" && device.state != "unknown") {
+            continue;
+        }
+
         ConnectionInfo conn;
         if (device.type == "ethernet") {
             conn.name = "Wired connection " + std::to_string(wired_cnt);
         } else if (device.type == "loopback") {
             conn.name = "lo";
         } else if (device.type == "wifi") {
-            conn.name = station->getPropertyFromObjectPath<std::string>(
-                sdbus::ObjectPath{station->getConnectedNetwork()}, "net.connman.iwd.Network", "Name"
-            );
+            // A disconnected wifi device has no active connection; its saved networks are listed below
+            const std::string networkPath = station->getConnectedNetwork();
+            if (networkPath.empty()) {
+                continue;
+            }
+            auto networkProxy = station->objectProxy(sdbus::ObjectPath{networkPath});
+            conn.name = IwdNetworkProxy(*networkProxy).name();
             currentSSID = conn.name;
         } else {
             conn.name = device.name;
@@ -376,11 +1058,12 @@ void NetworkManager::showConnections() {
         connections.push_back(conn);
     }
 
-    auto wifiConnections = station->getAllConnection();
+    // Saved but inactive networks; --active skips the enumeration and its per-network reads entirely,
+    // so its cost does not grow with the number of known networks
+    auto wifiConnections = active_only ? std::vector<std::string>() : station->getAllConnection();
     for (const auto &networkPath : wifiConnections) {
-        std::string networkSSID = station->getPropertyFromObjectPath<std::string>(
-            sdbus::ObjectPath{networkPath}, "net.connman.iwd.KnownNetwork", "Name"
-        );
+        auto knownProxy = station->objectProxy(sdbus::ObjectPath{networkPath});
+        std::string networkSSID = IwdKnownNetworkProxy(*knownProxy).name();
         if (networkSSID == currentSSID)
             continue;
         ConnectionInfo conn;
@@ -389,6 +1072,17 @@ void NetworkManager::showConnections() {
         conn.type = "wifi";
         connections.push_back(conn);
     }
+    return connections;
+}
+
+bool NetworkManager::showConnections(bool active_only) {
+    std::vector<ConnectionInfo> connections;
+    try {
+        connections = collectConnections(active_only);
+    } catch (const std::exception &e) {
+        std::cerr << "Error listing connections: " << e.what() << std::endl;
+        return false;
+    }
 
     // Determine which fields to display
     bool show_name = field_selection.empty() ||
@@ -430,80 +1124,128 @@ void NetworkManager::showConnections() {
 
     // Print formatted table
     printFormattedTable(table_data, headers);
+    return true;
+}
+
+// Decimal text for every quality value, so listing rows don't format integers one by one
+static const std::array<std::string, 101> &qualityText() {
+    static const std::array<std::string, 101> text = [] {
+        std::array<std::string, 101> values;
+        for (size_t i = 0; i < values.size(); ++i) {
+            values[i] = std::to_string(i);
+        }
+        return values;
+    }();
+    return text;
 }
 
 int NetworkManager::dbmToQualitySegmented(int rssi_dbm) {
     /*
      * 分段线性映射，更符合实际感知
+     * -50dBm 以上为 100%，-50 到 -90 每 1dB 对应 2%，-90dBm 以下为 0
      */
-    if (rssi_dbm >= -50) {
-        return 100;
-    } else if (rssi_dbm >= -60) {
-        // -50 到 -60: 100% -> 80%
-        return 80 + ((rssi_dbm + 60) * 20) / 10;
-    } else if (rssi_dbm >= -70) {
-        // -60 到 -70: 80% -> 60%
-        return 60 + ((rssi_dbm + 70) * 20) / 10;
-    } else if (rssi_dbm >= -80) {
-        // -70 到 -80: 60% -> 40%
-        return 40 + ((rssi_dbm + 80) * 20) / 10;
-    } else if (rssi_dbm >= -90) {
-        // -80 到 -90: 40% -> 20%
-        return 20 + ((rssi_dbm + 90) * 20) / 10;
-    } else {
-        return 0;
+    return dbmToQuality(rssi_dbm);
+}
+
+ScanSnapshot NetworkManager::getIwdNetworks(RescanPolicy rescan, std::chrono::seconds max_age, bool &scan_timed_out) {
+    // Create IwdManager instance
+    IwdManager iwdManager;
+
+    // Create Station instance
+    auto station = iwdManager.createStation();
+    if (!station) {
+        throw NetworkException("Failed to create Station instance");
+    }
+
+    // Scans are coordinated with other nmcli-alt processes: a scan already in progress (ours or iwd's own)
+    // is joined, and --rescan auto skips scanning while the last completed one is younger than --max-age.
+    // All waiting follows the Scanning property, driven by D-Bus signals.
+    if (rescan != RescanPolicy::No) {
+        DBusEventLoop loop(iwdManager.connection());
+        // Without --wait the scan is capped at 10 s; with it, by whatever budget is left
+        const auto timeout = Deadline::global().remainingOr(std::chrono::seconds(10));
+        ScanCoordinator::Scanner scanner{
+            [&] { return station->isScanning(); },
+            [&](bool scanning, ScanCoordinator::Clock::duration wait_timeout) {
+                return loop.run(station->waitScanningAsync(loop, scanning, wait_timeout));
+            },
+            [&] { return loop.run(station->scanAsync(loop, timeout)); },
+        };
+        ScanCoordinator coordinator;
+        scan_timed_out = !coordinator.run(rescan, max_age, timeout, scanner);
     }
+
+    // Get ordered networks
+    return station->getScanSnapshot();
 }
 
-void NetworkManager::listWifiNetworks(bool rescan) {
-    try {
-        // Create IwdManager instance
-        IwdManager iwdManager;
+ScanSnapshot NetworkManager::getNl80211Networks() {
+    // Read the kernel's cached BSS table directly, bypassing iwd
+    Nl80211Client nl80211;
+    std::vector<Station::NetworkInfo> bss_networks;
+    for (const auto &iface : nl80211.listInterfaces()) {
+        auto iface_networks = nl80211.getNetworks(iface.ifindex);
+        bss_networks.insert(
+            bss_networks.end(), std::make_move_iterator(iface_networks.begin()),
+            std::make_move_iterator(iface_networks.end())
+        );
+    }
 
-        // Create Station instance
-        auto station = iwdManager.createStation();
-        if (!station) {
-            std::cerr << "Failed to create Station instance" << std::endl;
-            return;
-        }
+    ScanSnapshot snapshot(bss_networks.size());
+    for (const auto &network : bss_networks) {
+        snapshot.add(network.object_path, network.ssid, network.security, network.signal_strength, network.in_use);
+    }
+    return snapshot;
+}
 
-        // If rescan is requested, perform a scan
-        if (rescan) {
-            if (station->scan()) {
-                // Wait for scan to complete by polling the Scanning property
-                int attempts = 0;
-                const int maxAttempts = 20; // Maximum 10 seconds (20 * 500ms)
-                while (attempts < maxAttempts) {
-                    if (!station->isScanning()) {
-                        break;
-                    }
-                    std::this_thread::sleep_for(std::chrono::milliseconds(500));
-                    attempts++;
-                }
+NetworkManager::WifiListing
+NetworkManager::collectWifiNetworks(RescanPolicy rescan, size_t limit, std::chrono::seconds max_age) {
+    bool scan_timed_out = false;
+    WifiListing listing{
+        backend == "nl80211" ? getNl80211Networks() : getIwdNetworks(rescan, max_age, scan_timed_out), {}, {}, false
+    };
+    listing.scan_timed_out = scan_timed_out;
+    const ScanSnapshot &networks = listing.networks;
+
+    // Rows are ordered through an index permutation so that the columns stay in place.
+    // iwd and the nl80211 backend already return networks strongest first, so a full sort
+    // is only needed when that does not hold; with a limit only the top N are ordered.
+    const int16_t *signals = networks.signals();
+    auto stronger = [signals](uint32_t a, uint32_t b) { return signals[a] > signals[b]; };
+
+    listing.order.resize(networks.size());
+    std::iota(listing.order.begin(), listing.order.end(), 0);
+
+    if (limit > 0 && limit < networks.size()) {
+        std::partial_sort(listing.order.begin(), listing.order.begin() + limit, listing.order.end(), stronger);
+        listing.order.resize(limit);
+    } else if (!std::is_sorted(listing.order.begin(), listing.order.end(), stronger)) {
+        std::sort(listing.order.begin(), listing.order.end(), stronger);
+    }
 
-                if (attempts >= maxAttempts) {
-                    std::cerr << "Scan timeout" << std::endl;
-                }
-            } else {
-                std::cerr << "Failed to initiate scan" << std::endl;
-            }
+    // Convert the whole contiguous signal column to quality in one vectorized pass
+    listing.quality.resize(networks.size());
+    signalToQuality(signals, listing.quality.data(), networks.size());
+    return listing;
+}
+
+bool NetworkManager::listWifiNetworks(RescanPolicy rescan, size_t limit, std::chrono::seconds max_age) {
+    try {
+        if (backend == "nl80211" && rescan != RescanPolicy::No) {
+            std::cerr << "Rescan is not supported by the nl80211 backend, listing cached results" << std::endl;
         }
 
-        // Get ordered networks
-        auto networks = station->getOrderedNetworks();
+        const WifiListing listing = collectWifiNetworks(rescan, limit, max_age);
+        if (listing.scan_timed_out) {
+            std::cerr << "Scan timeout" << std::endl;
+        }
+        const ScanSnapshot &networks = listing.networks;
 
         // Print "Found X networks" message in non-terse mode
         if (!terse_output) {
             std::cout << "Found " << networks.size() << " networks" << std::endl;
         }
 
-        // Sort networks by signal strength in descending order (strongest first)
-        // Note: The networks should already be ordered by signal strength from getOrderedNetworks,
-        // but we'll sort them explicitly to ensure correct ordering
-        std::sort(networks.begin(), networks.end(), [](const Station::NetworkInfo &a, const Station::NetworkInfo &b) {
-            return a.signal_strength > b.signal_strength;
-        });
-
         // Determine which fields to display
         bool show_ssid = field_selection.empty() ||
                          std::find(field_selection.begin(), field_selection.end(), "SSID") != field_selection.end();
@@ -530,36 +1272,360 @@ void NetworkManager::listWifiNetworks(bool rescan) {
             headers.push_back("IN-USE");
 
         // Add network data
-        for (const auto &network : networks) {
+        const auto &quality_text = qualityText();
+        table_data.reserve(listing.order.size());
+        for (const uint32_t i : listing.order) {
             std::vector<std::string> row;
+            row.reserve(headers.size());
             if (show_ssid)
-                row.push_back(network.ssid);
+                row.emplace_back(networks.ssid(i));
             if (show_security)
-                row.push_back(network.security);
-            if (show_signal) {
-                // Convert from dBm*100 to dBm, then convert to quality percentage
-                int signal_dbm = network.signal_strength / 100;
-                int signal_quality = dbmToQualitySegmented(signal_dbm);
-                row.push_back(std::to_string(signal_quality));
-            }
+                row.emplace_back(networks.security(i));
+            if (show_signal)
+                row.push_back(quality_text[listing.quality[i]]);
             if (show_inuse)
-                row.push_back(network.in_use ? "*" : "");
-            table_data.push_back(row);
+                row.push_back(networks.inUse(i) ? "*" : "");
+            table_data.push_back(std::move(row));
         }
 
         // Print formatted table
         printFormattedTable(table_data, headers);
+        return true;
     } catch (const std::exception &e) {
         std::cerr << "Error listing WiFi networks: " << e.what() << std::endl;
+        return false;
     }
 }
 
+bool NetworkManager::sampleWifiLink(const std::string &ifname, int interval_ms, int count, bool binary) {
+    try {
+        std::string device = ifname;
+        if (device.empty()) {
+            Nl80211Client nl80211;
+            auto interfaces = nl80211.listInterfaces();
+            if (interfaces.empty()) {
+                std::cerr << "No wifi device found" << std::endl;
+                return false;
+            }
+            device = interfaces.front().name;
+        }
+
+        LinkSampler sampler(device);
+        installStopHandler();
+
+        if (!binary && !terse_output) {
+            std::cout << "TIME(ms)    BSSID              SIGNAL  AVG  TX-RATE  RX-RATE  RETRIES  FAILED  BEACON-LOSS"
+                      << std::endl;
+        }
+
+        // Everything below runs without heap allocation: fixed line buffer, one write per sample
+        char line[160];
+        LinkSampler::Sample sample;
+
+        struct timespec cpu_start, wall_start, next;
+        clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &cpu_start);
+        clock_gettime(CLOCK_MONOTONIC, &wall_start);
+        next = wall_start;
+        const uint64_t origin_ns = static_cast<uint64_t>(wall_start.tv_sec) * 1000000000ull + wall_start.tv_nsec;
+
+        int taken = 0;
+        // A --wait budget bounds the sampling run like a stop request would
+        const Deadline &deadline = Deadline::global();
+        while (!stop_requested && !deadline.expired() && (count <= 0 || taken < count)) {
+            if (sampler.sample(sample)) {
+                if (binary) {
+                    if (write(STDOUT_FILENO, &sample, sizeof(sample)) < 0) {
+                        break;
+                    }
+                } else {
+                    int len = std::snprintf(
+                        line, sizeof(line),
+                        "%-10llu  %02x:%02x:%02x:%02x:%02x:%02x  %6d  %3d  %5u.%u  %5u.%u  %7u  %6u  %11u\n",
+                        static_cast<unsigned long long>((sample.timestamp_ns - origin_ns) / 1000000ull),
+                        sample.bssid[0], sample.bssid[1], sample.bssid[2], sample.bssid[3], sample.bssid[4],
+                        sample.bssid[5], sample.signal, sample.signal_avg, sample.tx_bitrate / 10,
+                        sample.tx_bitrate % 10, sample.rx_bitrate / 10, sample.rx_bitrate % 10, sample.tx_retries,
+                        sample.tx_failed, sample.beacon_loss
+                    );
+                    if (write(STDOUT_FILENO, line, static_cast<size_t>(len)) < 0) {
+                        break;
+                    }
+                }
+            } else if (!binary) {
+                static const char not_connected[] = "-- not connected --\n";
+                if (write(STDOUT_FILENO, not_connected, sizeof(not_connected) - 1) < 0) {
+                    break;
+                }
+            }
+            taken++;
+
+            if (interval_ms <= 0 || (count > 0 && taken >= count)) {
+                break;
+            }
+            // The next sample would land past the deadline
+            if (deadline.remainingOr(std::chrono::milliseconds(interval_ms)) < std::chrono::milliseconds(interval_ms)) {
+                break;
+            }
+
+            // Sleep until an absolute deadline so that sampling cost does not drift the cadence
+            next.tv_nsec += static_cast<long>(interval_ms % 1000) * 1000000L;
+            next.tv_sec += interval_ms / 1000 + next.tv_nsec / 1000000000L;
+            next.tv_nsec %= 1000000000L;
+            clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, nullptr);
+        }
+
+        struct timespec cpu_end, wall_end;
+        clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &cpu_end);
+        clock_gettime(CLOCK_MONOTONIC, &wall_end);
+
+        // Self-measured overhead report, kept on stderr so it never mixes with sample records
+        const auto &overhead = sampler.overhead();
+        double cpu_ms = (cpu_end.tv_sec - cpu_start.tv_sec) * 1e3 + (cpu_end.tv_nsec - cpu_start.tv_nsec) / 1e6;
+        double wall_ms = (wall_end.tv_sec - wall_start.tv_sec) * 1e3 + (wall_end.tv_nsec - wall_start.tv_nsec) / 1e6;
+        if (overhead.samples > 0) {
+            std::fprintf(
+                stderr, "%llu samples, avg %.1f us, max %.1f us per sample, CPU %.3f%% of %.0f ms\n",
+                static_cast<unsigned long long>(overhead.samples),
+                overhead.total_ns / 1e3 / static_cast<double>(overhead.samples), overhead.max_ns / 1e3,
+                wall_ms > 0 ? cpu_ms * 100.0 / wall_ms : 0.0, wall_ms
+            );
+        }
+
+        return true;
+    } catch (const std::exception &e) {
+        std::cerr << "Error sampling WiFi link: " << e.what() << std::endl;
+        return false;
+    }
+}
+
+// Appends one table cell; text columns are left-aligned, counters right-aligned so digits line up between frames
+static void appendCell(std::string &out, const char *text, size_t width, bool right, bool last) {
+    const size_t len = std::strlen(text);
+    const size_t pad = width > len ? width - len : 0;
+    if (right) {
+        out.append(pad, ' ');
+    }
+    out.append(text, len);
+    if (!last) {
+        out.append(right ? 2 : pad + 2, ' ');
+    }
+}
+
+bool NetworkManager::monitorDeviceStats(int interval_ms, int count) {
+    try {
+        LinkStatsSampler sampler;
+        installStopHandler();
+
+        enum Column { Device, Type, State, RxBytes, TxBytes, RxPackets, TxPackets, RxErrors, TxErrors, ColumnCount };
+        static const char *const column_names[ColumnCount] = {"DEVICE",   "TYPE",     "STATE",  "RX-B/s", "TX-B/s",
+                                                               "RX-PKT/s", "TX-PKT/s", "RX-ERR", "TX-ERR"};
+        // Wide enough for 100 Gbit/s in bytes so counters rarely shift the layout
+        static const size_t numeric_widths[ColumnCount] = {0, 0, 0, 11, 11, 9, 9, 6, 6};
+
+        std::vector<int> columns;
+        for (int column = 0; column < ColumnCount; ++column) {
+            if (field_selection.empty() ||
+                std::find(field_selection.begin(), field_selection.end(), column_names[column]) !=
+                    field_selection.end()) {
+                columns.push_back(column);
+            }
+        }
+        if (columns.empty()) {
+            std::cerr << "Error: no valid fields selected" << std::endl;
+            return false;
+        }
+
+        // The first frame reports rates over the first interval, so take a baseline now
+        sampler.sample();
+
+        // Everything below reuses the same frame buffer; each frame goes out in one write
+        std::string frame;
+        char cell[32];
+        size_t widths[ColumnCount] = {};
+
+        struct timespec next;
+        clock_gettime(CLOCK_MONOTONIC, &next);
+        const auto interval = std::chrono::milliseconds(interval_ms);
+        const Deadline &deadline = Deadline::global();
+        int shown = 0;
+        while (!stop_requested && !deadline.expired() && (count <= 0 || shown < count)) {
+            // The next frame would land past the deadline
+            if (deadline.remainingOr(interval) < interval) {
+                break;
+            }
+            // Absolute deadlines keep the cadence independent of how long sampling and rendering took
+            next.tv_nsec += static_cast<long>(interval_ms % 1000) * 1000000L;
+            next.tv_sec += interval_ms / 1000 + next.tv_nsec / 1000000000L;
+            next.tv_nsec %= 1000000000L;
+            // After a frame that overran the interval, restart the cadence from now instead of
+            // catching up with a burst of back-to-back frames
+            struct timespec now;
+            clock_gettime(CLOCK_MONOTONIC, &now);
+            if (now.tv_sec > next.tv_sec || (now.tv_sec == next.tv_sec && now.tv_nsec > next.tv_nsec)) {
+                next = now;
+            }
+            clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, nullptr);
+            if (stop_requested) {
+                break;
+            }
+
+            sampler.sample();
+            const auto &links = sampler.links();
+
+            for (int column : columns) {
+                widths[column] = std::max(std::strlen(column_names[column]), numeric_widths[column]);
+            }
+            for (int ifindex : sampler.present()) {
+                const auto &link = links[ifindex];
+                widths[Device] = std::max(widths[Device], link.name.size());
+                widths[Type] = std::max(widths[Type], link.type.size());
+                widths[State] = std::max(widths[State], link.state.size());
+            }
+
+            ProbeSpan probe(ProbeKind::Render, "stats-frame");
+            probe.setResult(static_cast<int64_t>(sampler.present().size()));
+            frame.clear();
+            if (!terse_output) {
+                if (shown > 0) {
+                    frame += '\n';
+                }
+                for (size_t i = 0; i < columns.size(); ++i) {
+                    appendCell(
+                        frame, column_names[columns[i]], widths[columns[i]], columns[i] >= RxBytes,
+                        i + 1 == columns.size()
+                    );
+                }
+                frame += '\n';
+            }
+            for (int ifindex : sampler.present()) {
+                const auto &link = links[ifindex];
+                for (size_t i = 0; i < columns.size(); ++i) {
+                    const char *text = cell;
+                    switch (columns[i]) {
+                    case Device:
+                        text = link.name.c_str();
+                        break;
+                    case Type:
+                        text = link.type.c_str();
+                        break;
+                    case State:
+                        text = link.state.c_str();
+                        break;
+                    case RxBytes:
+                        std::snprintf(cell, sizeof(cell), "%.0f", link.rates.rx_bytes);
+                        break;
+                    case TxBytes:
+                        std::snprintf(cell, sizeof(cell), "%.0f", link.rates.tx_bytes);
+                        break;
+                    case RxPackets:
+                        std::snprintf(cell, sizeof(cell), "%.0f", link.rates.rx_packets);
+                        break;
+                    case TxPackets:
+                        std::snprintf(cell, sizeof(cell), "%.0f", link.rates.tx_packets);
+                        break;
+                    case RxErrors:
+                        std::snprintf(
+                            cell, sizeof(cell), "%llu", static_cast<unsigned long long>(link.rates.rx_errors)
+                        );
+                        break;
+                    case TxErrors:
+                        std::snprintf(
+                            cell, sizeof(cell), "%llu", static_cast<unsigned long long>(link.rates.tx_errors)
+                        );
+                        break;
+                    }
+                    if (terse_output) {
+                        if (i > 0) {
+                            frame += ':';
+                        }
+                        frame += text;
+                    } else {
+                        appendCell(frame, text, widths[columns[i]], columns[i] >= RxBytes, i + 1 == columns.size());
+                    }
+                }
+                frame += '\n';
+            }
+
+            // A pipe may accept a large frame in pieces; only a failed write (reader gone) ends the loop
+            size_t written = 0;
+            while (written < frame.size()) {
+                ssize_t n = write(STDOUT_FILENO, frame.data() + written, frame.size() - written);
+                if (n < 0 && errno == EINTR) {
+                    continue;
+                }
+                if (n <= 0) {
+                    return true;
+                }
+                written += static_cast<size_t>(n);
+            }
+            shown++;
+        }
+
+        return true;
+    } catch (const std::exception &e) {
+        std::cerr << "Error sampling interface statistics: " << e.what() << std::endl;
+        return false;
+    }
+}
+
+bool NetworkManager::exportMetrics(const std::string &path, int interval_ms) {
+    try {
+        MetricsExporter exporter(path);
+        installStopHandler();
+        if (!terse_output) {
+            std::cerr << "Writing metrics to " << path << ", press Ctrl-C to stop" << std::endl;
+        }
+        watchState(
+            interval_ms, [&exporter](const StateSnapshot &snapshot) { exporter.write(snapshot); },
+            [] { return stop_requested != 0; }
+        );
+        return true;
+    } catch (const sdbus::Error &e) {
+        std::cerr << "D-Bus error exporting metrics: " << e.what() << std::endl;
+        return false;
+    } catch (const std::exception &e) {
+        std::cerr << "Error exporting metrics: " << e.what() << std::endl;
+        return false;
+    }
+}
+
+bool NetworkManager::publishState(const std::string &path, int interval_ms) {
+    try {
+        StatePublisher publisher(path, static_cast<uint32_t>(interval_ms));
+        installStopHandler();
+        if (!terse_output) {
+            std::cerr << "Publishing state to " << path << ", press Ctrl-C to stop" << std::endl;
+        }
+        watchState(
+            interval_ms, [&publisher](const StateSnapshot &snapshot) { publisher.publish(snapshot); },
+            [] { return stop_requested != 0; }
+        );
+        return true;
+    } catch (const sdbus::Error &e) {
+        std::cerr << "D-Bus error publishing state: " << e.what() << std::endl;
+        return false;
+    } catch (const std::exception &e) {
+        std::cerr << "Error publishing state: " << e.what() << std::endl;
+        return false;
+    }
+}
+
+void NetworkManager::watchState(
+    int interval_ms, const std::function<void(const StateSnapshot &)> &sink, const std::function<bool()> &stop,
+    int wake_fd
+) {
+    StateWatcher watcher(std::chrono::milliseconds(interval_ms), sink);
+    watcher.run(stop, wake_fd);
+}
+
 void NetworkManager::printFormattedTable(
     const std::vector<std::vector<std::string>> &data, const std::vector<std::string> &headers
 ) const {
     if (data.empty()) {
         return;
     }
+    ProbeSpan probe(ProbeKind::Render, terse_output ? "table-terse" : "table");
+    probe.setResult(static_cast<int64_t>(data.size()));
 
     if (terse_output) {
         // Terse output format
@@ -0,0 +1,346 @@
+#include "nl80211_client.h"
+#include "deadline.h"
+#include "trace.h"
+
+#include <netlink/netlink.h>
+#include <netlink/genl/genl.h>
+#include <netlink/genl/ctrl.h>
+#include <linux/nl80211.h>
+#include <algorithm>
+#include <cstdio>
+#include <map>
+#include <utility>
+
+namespace {
+
+// RSN/WPA IE 中的 AKM 套件类型（IEEE 802.11-2020 表 9-151）
+constexpr unsigned AKM_8021X = 1u << 0;
+constexpr unsigned AKM_PSK = 1u << 1;
+constexpr unsigned AKM_SAE = 1u << 2;
+constexpr unsigned AKM_OWE = 1u << 3;
+
+constexpr uint16_t CAPABILITY_PRIVACY = 0x0010;
+constexpr uint8_t IE_SSID = 0;
+constexpr uint8_t IE_RSN = 48;
+constexpr uint8_t IE_VENDOR = 221;
+
+unsigned akmSuiteToFlag(const uint8_t *suite) {
+    // RSN 使用 00-0F-AC，WPA 使用 00-50-F2
+    bool rsn_oui = suite[0] == 0x00 && suite[1] == 0x0f && suite[2] == 0xac;
+    bool wpa_oui = suite[0] == 0x00 && suite[1] == 0x50 && suite[2] == 0xf2;
+    if (!rsn_oui && !wpa_oui) {
+        return 0;
+    }
+
+    switch (suite[3]) {
+    case 1:  // 802.1X
+    case 3:  // FT-802.1X
+    case 5:  // 802.1X-SHA256
+    case 11: // Suite B
+    case 12: // Suite B 192
+        return AKM_8021X;
+    case 2: // PSK
+    case 4: // FT-PSK
+    case 6: // PSK-SHA256
+        return AKM_PSK;
+    case 8: // SAE
+    case 9: // FT-SAE
+        return rsn_oui ? AKM_SAE : 0;
+    case 18: // OWE
+        return rsn_oui ? AKM_OWE : 0;
+    default:
+        return 0;
+    }
+}
+
+// 解析 RSN IE（或去掉 OUI 头后的 WPA IE）中的 AKM 列表
+unsigned parseAkmSuites(const uint8_t *data, size_t len) {
+    // version(2) + group cipher(4)
+    if (len < 6) {
+        return 0;
+    }
+    data += 6;
+    len -= 6;
+
+    // pairwise cipher count(2) + list(4*n)
+    if (len < 2) {
+        return 0;
+    }
+    size_t pairwise = data[0] | (data[1] << 8);
+    if (len < 2 + pairwise * 4) {
+        return 0;
+    }
+    data += 2 + pairwise * 4;
+    len -= 2 + pairwise * 4;
+
+    // AKM count(2) + list(4*n)
+    if (len < 2) {
+        return 0;
+    }
+    size_t akm_count = data[0] | (data[1] << 8);
+    data += 2;
+    len -= 2;
+
+    unsigned flags = 0;
+    for (size_t i = 0; i < akm_count && len >= 4; ++i, data += 4, len -= 4) {
+        flags |= akmSuiteToFlag(data);
+    }
+    return flags;
+}
+
+// 与 iwd 的 security_determine 保持一致的安全类型判定，不支持的 AKM 返回空字符串
+const char *securityFromAkm(uint16_t capability, bool has_rsn_or_wpa, unsigned akm) {
+    if (!(capability & CAPABILITY_PRIVACY)) {
+        return "open";
+    }
+    if (akm & (AKM_PSK | AKM_SAE)) {
+        return "psk";
+    }
+    if (akm & AKM_8021X) {
+        return "8021x";
+    }
+    if (akm & AKM_OWE) {
+        return "open";
+    }
+    return has_rsn_or_wpa ? "" : "wep";
+}
+
+// 就地遍历 IE 列表，只复制最终需要的 SSID
+void parseInformationElements(
+    const uint8_t *ie, size_t len, uint16_t capability, Nl80211Client::BssInfo &info
+) {
+    bool has_rsn_or_wpa = false;
+    unsigned akm = 0;
+
+    while (len >= 2 && len >= static_cast<size_t>(ie[1]) + 2) {
+        const uint8_t id = ie[0];
+        const uint8_t elen = ie[1];
+        const uint8_t *data = ie + 2;
+
+        if (id == IE_SSID) {
+            info.ssid.assign(reinterpret_cast<const char *>(data), elen);
+        } else if (id == IE_RSN) {
+            has_rsn_or_wpa = true;
+            akm |= parseAkmSuites(data, elen);
+        } else if (id == IE_VENDOR && elen >= 4 && data[0] == 0x00 && data[1] == 0x50 && data[2] == 0xf2 &&
+                   data[3] == 0x01) {
+            // Microsoft WPA IE: OUI(3) + type(1) 之后与 RSN IE 布局相同
+            has_rsn_or_wpa = true;
+            akm |= parseAkmSuites(data + 4, elen - 4);
+        }
+
+        ie += elen + 2;
+        len -= elen + 2;
+    }
+
+    info.security = securityFromAkm(capability, has_rsn_or_wpa, akm);
+}
+
+int onInterface(struct nl_msg *msg, void *arg) {
+    auto *interfaces = static_cast<std::vector<Nl80211Client::InterfaceInfo> *>(arg);
+
+    struct genlmsghdr *gnlh = static_cast<struct genlmsghdr *>(nlmsg_data(nlmsg_hdr(msg)));
+    struct nlattr *tb[NL80211_ATTR_MAX + 1];
+    nla_parse(tb, NL80211_ATTR_MAX, genlmsg_attrdata(gnlh, 0), genlmsg_attrlen(gnlh, 0), nullptr);
+
+    if (!tb[NL80211_ATTR_IFINDEX] || !tb[NL80211_ATTR_IFNAME]) {
+        return NL_SKIP;
+    }
+
+    // 只关心 station 模式的接口
+    if (tb[NL80211_ATTR_IFTYPE] && nla_get_u32(tb[NL80211_ATTR_IFTYPE]) != NL80211_IFTYPE_STATION) {
+        return NL_SKIP;
+    }
+
+    interfaces->push_back(
+        {static_cast<int>(nla_get_u32(tb[NL80211_ATTR_IFINDEX])), nla_get_string(tb[NL80211_ATTR_IFNAME])}
+    );
+    return NL_SKIP;
+}
+
+int onScanResult(struct nl_msg *msg, void *arg) {
+    auto *results = static_cast<std::vector<Nl80211Client::BssInfo> *>(arg);
+
+    struct genlmsghdr *gnlh = static_cast<struct genlmsghdr *>(nlmsg_data(nlmsg_hdr(msg)));
+    struct nlattr *tb[NL80211_ATTR_MAX + 1];
+    nla_parse(tb, NL80211_ATTR_MAX, genlmsg_attrdata(gnlh, 0), genlmsg_attrlen(gnlh, 0), nullptr);
+
+    if (!tb[NL80211_ATTR_BSS]) {
+        return NL_SKIP;
+    }
+
+    struct nlattr *bss[NL80211_BSS_MAX + 1];
+    if (nla_parse_nested(bss, NL80211_BSS_MAX, tb[NL80211_ATTR_BSS], nullptr) < 0) {
+        return NL_SKIP;
+    }
+
+    // 只有 mBm 形式的信号强度才能与 iwd 的 dBm*100 对齐
+    if (!bss[NL80211_BSS_BSSID] || !bss[NL80211_BSS_SIGNAL_MBM]) {
+        return NL_SKIP;
+    }
+
+    Nl80211Client::BssInfo info;
+
+    const uint8_t *mac = static_cast<const uint8_t *>(nla_data(bss[NL80211_BSS_BSSID]));
+    char mac_buf[18];
+    std::snprintf(
+        mac_buf, sizeof(mac_buf), "%02x:%02x:%02x:%02x:%02x:%02x", mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]
+    );
+    info.bssid = mac_buf;
+
+    info.frequency = bss[NL80211_BSS_FREQUENCY] ? nla_get_u32(bss[NL80211_BSS_FREQUENCY]) : 0;
+    info.signal_mbm = static_cast<int32_t>(nla_get_u32(bss[NL80211_BSS_SIGNAL_MBM]));
+    info.associated =
+        bss[NL80211_BSS_STATUS] && nla_get_u32(bss[NL80211_BSS_STATUS]) == NL80211_BSS_STATUS_ASSOCIATED;
+
+    uint16_t capability = bss[NL80211_BSS_CAPABILITY] ? nla_get_u16(bss[NL80211_BSS_CAPABILITY]) : 0;
+
+    // 优先使用探测响应中的 IE，没有时退回到 Beacon IE
+    struct nlattr *ies = bss[NL80211_BSS_INFORMATION_ELEMENTS];
+    if (!ies) {
+        ies = bss[NL80211_BSS_BEACON_IES];
+    }
+    if (ies) {
+        parseInformationElements(static_cast<const uint8_t *>(nla_data(ies)), nla_len(ies), capability, info);
+    } else {
+        info.security = (capability & CAPABILITY_PRIVACY) ? "wep" : "open";
+    }
+
+    results->push_back(std::move(info));
+    return NL_SKIP;
+}
+
+} // namespace
+
+void Nl80211Client::SocketDeleter::operator()(struct nl_sock *sock) const {
+    if (sock) {
+        nl_close(sock);
+        nl_socket_free(sock);
+    }
+}
+
+Nl80211Client::Nl80211Client() : sock_(nl_socket_alloc()), family_id_(-1) {
+    if (!sock_) {
+        throw NetworkException("Failed to allocate netlink socket");
+    }
+
+    if (genl_connect(sock_.get()) < 0) {
+        throw NetworkException("Failed to connect to generic netlink");
+    }
+
+    // 扫描结果单条消息可能超过一个页面，让 libnl 先探测消息长度
+    nl_socket_enable_msg_peek(sock_.get());
+
+    Deadline::global().applyReceiveTimeout(nl_socket_get_fd(sock_.get()));
+    family_id_ = Trace::global().netlinkExchange(
+        sock_.get(), "CTRL_CMD_GETFAMILY", "nl80211", [this] { return genl_ctrl_resolve(sock_.get(), "nl80211"); },
+        nullptr, nullptr
+    );
+    Deadline::global().check("resolving nl80211 family");
+    if (family_id_ < 0) {
+        throw NetworkException("nl80211 generic netlink family not found");
+    }
+}
+
+Nl80211Client::~Nl80211Client() = default;
+
+std::vector<Nl80211Client::InterfaceInfo> Nl80211Client::listInterfaces() {
+    std::vector<InterfaceInfo> interfaces;
+
+    std::unique_ptr<struct nl_msg, void (*)(struct nl_msg *)> msg(nlmsg_alloc(), nlmsg_free);
+    if (!msg) {
+        throw NetworkException("Failed to allocate netlink message");
+    }
+
+    genlmsg_put(msg.get(), NL_AUTO_PORT, NL_AUTO_SEQ, family_id_, 0, NLM_F_DUMP, NL80211_CMD_GET_INTERFACE, 0);
+
+    nl_socket_modify_cb(sock_.get(), NL_CB_VALID, NL_CB_CUSTOM, onInterface, &interfaces);
+
+    // 接收受 --wait 截止时间限制，到期后 recvmsg 以 EAGAIN 返回
+    Deadline::global().applyReceiveTimeout(nl_socket_get_fd(sock_.get()));
+    int err = Trace::global().netlinkExchange(
+        sock_.get(), "NL80211_CMD_GET_INTERFACE", "",
+        [&] {
+            int sent = nl_send_auto(sock_.get(), msg.get());
+            return sent < 0 ? sent : nl_recvmsgs_default(sock_.get());
+        },
+        onInterface, &interfaces
+    );
+    Deadline::global().check("dumping nl80211 interfaces");
+    if (err < 0) {
+        throw NetworkException("Failed to dump nl80211 interfaces: " + std::string(nl_geterror(err)));
+    }
+
+    return interfaces;
+}
+
+std::vector<Nl80211Client::BssInfo> Nl80211Client::dumpScan(int ifindex) {
+    std::vector<BssInfo> results;
+
+    std::unique_ptr<struct nl_msg, void (*)(struct nl_msg *)> msg(nlmsg_alloc(), nlmsg_free);
+    if (!msg) {
+        throw NetworkException("Failed to allocate netlink message");
+    }
+
+    genlmsg_put(msg.get(), NL_AUTO_PORT, NL_AUTO_SEQ, family_id_, 0, NLM_F_DUMP, NL80211_CMD_GET_SCAN, 0);
+    nla_put_u32(msg.get(), NL80211_ATTR_IFINDEX, ifindex);
+
+    nl_socket_modify_cb(sock_.get(), NL_CB_VALID, NL_CB_CUSTOM, onScanResult, &results);
+
+    // 接收受 --wait 截止时间限制，到期后 recvmsg 以 EAGAIN 返回
+    Deadline::global().applyReceiveTimeout(nl_socket_get_fd(sock_.get()));
+    int err = Trace::global().netlinkExchange(
+        sock_.get(), "NL80211_CMD_GET_SCAN", std::to_string(ifindex),
+        [&] {
+            int sent = nl_send_auto(sock_.get(), msg.get());
+            return sent < 0 ? sent : nl_recvmsgs_default(sock_.get());
+        },
+        onScanResult, &results
+    );
+    Deadline::global().check("dumping nl80211 scan results");
+    if (err < 0) {
+        throw NetworkException("Failed to dump nl80211 scan results: " + std::string(nl_geterror(err)));
+    }
+
+    return results;
+}
+
+std::vector<Station::NetworkInfo> Nl80211Client::getNetworks(int ifindex) {
+    auto bss_list = dumpScan(ifindex);
+
+    // iwd 把同一 SSID 和安全类型的多个 BSS 合并为一个 Network，信号取最强的 BSS
+    std::map<std::pair<std::string, std::string>, Station::NetworkInfo> merged;
+    for (auto &bss : bss_list) {
+        // 隐藏网络和不支持的安全类型，iwd 也不会为其创建 Network 对象
+        if (bss.security.empty() || bss.ssid.empty() || bss.ssid.find_first_not_of('\0') == std::string::npos) {
+            continue;
+        }
+
+        auto key = std::make_pair(bss.ssid, bss.security);
+        auto it = merged.find(key);
+        if (it == merged.end()) {
+            Station::NetworkInfo info;
+            info.ssid = std::move(bss.ssid);
+            info.security = std::move(bss.security);
+            info.signal_strength = bss.signal_mbm;
+            info.in_use = bss.associated;
+            merged.emplace(std::move(key), std::move(info));
+        } else {
+            it->second.signal_strength = std::max(it->second.signal_strength, bss.signal_mbm);
+            it->second.in_use = it->second.in_use || bss.associated;
+        }
+    }
+
+    std::vector<Station::NetworkInfo> networks;
+    networks.reserve(merged.size());
+    for (auto &entry : merged) {
+        networks.push_back(std::move(entry.second));
+    }
+
+    // 与 GetOrderedNetworks 一样按信号强度降序排列
+    std::sort(networks.begin(), networks.end(), [](const Station::NetworkInfo &a, const Station::NetworkInfo &b) {
+        return a.signal_strength > b.signal_strength;
+    });
+
+    return networks;
+}
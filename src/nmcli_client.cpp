@@ -0,0 +1,361 @@
+#include "nmcli_client.h"
+#include "network_manager.h"
+#include "iwd_manager.h"
+#include "diagnostics.h"
+#include "iwd_interfaces.h"
+
+#include <sdbus-c++/sdbus-c++.h>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+namespace {
+
+using PropertyMap = std::map<std::string, sdbus::Variant>;
+using ManagedObjects = std::map<sdbus::ObjectPath, std::map<std::string, PropertyMap>>;
+
+// 第一个实现了 interface 的对象，没有时返回 nullptr
+const std::pair<const sdbus::ObjectPath, std::map<std::string, PropertyMap>> *
+findObject(const ManagedObjects &objects, const std::string &interface) {
+    for (const auto &object : objects) {
+        if (object.second.count(interface)) {
+            return &object;
+        }
+    }
+    return nullptr;
+}
+
+const PropertyMap *findInterface(const ManagedObjects &objects, const std::string &path, const std::string &interface) {
+    auto object = objects.find(sdbus::ObjectPath{path});
+    if (object == objects.end()) {
+        return nullptr;
+    }
+    auto properties = object->second.find(interface);
+    return properties == object->second.end() ? nullptr : &properties->second;
+}
+
+} // namespace
+
+struct NmcliClient::Impl {
+    // 同步查询共用一条总线连接和一个 NetworkManager，由 query_mutex 串行化
+    std::mutex query_mutex;
+    IwdManager iwd;
+    NetworkManager network;
+
+    // *Async 查询在一个查询线程上依次执行，第一次提交时启动
+    std::mutex job_mutex;
+    std::condition_variable job_cv;
+    std::deque<std::function<void()>> jobs;
+    bool jobs_closed = false;
+    std::thread job_thread;
+
+    // 监视线程在第一次注册回调时启动，析构时退出
+    std::mutex watch_mutex;
+    std::condition_variable watch_cv;
+    std::map<uint64_t, StateCallback> callbacks;
+    uint64_t next_id = 1;
+    int interval_ms = 5000;
+    bool shutdown = false;
+    std::thread watcher;
+    int wake_fd = -1;
+
+    Impl() {
+        wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (wake_fd < 0) {
+            throw NmcliException("Failed to create eventfd");
+        }
+    }
+
+    ~Impl() {
+        // 正在执行的查询照常完成，排队的查询随 packaged_task 销毁以 broken_promise 结束
+        {
+            std::lock_guard<std::mutex> lock(job_mutex);
+            jobs_closed = true;
+            jobs.clear();
+        }
+        job_cv.notify_all();
+        if (job_thread.joinable()) {
+            job_thread.join();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(watch_mutex);
+            shutdown = true;
+            callbacks.clear();
+        }
+        watch_cv.notify_all();
+        wake();
+        if (watcher.joinable()) {
+            watcher.join();
+        }
+        close(wake_fd);
+    }
+
+    void wake() {
+        uint64_t one = 1;
+        [[maybe_unused]] ssize_t written = write(wake_fd, &one, sizeof(one));
+    }
+
+    // 持锁执行查询，静默诊断输出，并把 sdbus::Error 转换为 DBusException
+    template <typename F> auto query(F &&body) -> decltype(body()) {
+        std::lock_guard<std::mutex> lock(query_mutex);
+        DiagnosticsMute mute;
+        try {
+            return body();
+        } catch (const sdbus::Error &e) {
+            throw DBusException(e.getName() + ": " + e.getMessage());
+        }
+    }
+
+    // 把查询交给查询线程，结果或异常通过 future 返回
+    template <typename F> auto submit(F &&body) -> std::future<decltype(body())> {
+        auto task = std::make_shared<std::packaged_task<decltype(body())()>>(std::forward<F>(body));
+        auto future = task->get_future();
+        {
+            std::lock_guard<std::mutex> lock(job_mutex);
+            jobs.emplace_back([task] { (*task)(); });
+            if (!job_thread.joinable()) {
+                job_thread = std::thread([this] { runJobs(); });
+            }
+        }
+        job_cv.notify_one();
+        return future;
+    }
+
+    void runJobs() {
+        std::unique_lock<std::mutex> lock(job_mutex);
+        for (;;) {
+            job_cv.wait(lock, [this] { return jobs_closed || !jobs.empty(); });
+            if (jobs_closed) {
+                return;
+            }
+            std::function<void()> job = std::move(jobs.front());
+            jobs.pop_front();
+            lock.unlock();
+            job();
+            lock.lock();
+        }
+    }
+
+    ManagedObjects managedObjects() {
+        auto rootProxy =
+            sdbus::createProxy(iwd.connection(), sdbus::ServiceName{"net.connman.iwd"}, sdbus::ObjectPath{"/"});
+        return dbusCall<ManagedObjects>(
+            *rootProxy, "org.freedesktop.DBus.ObjectManager", "GetManagedObjects", "listing iwd objects"
+        );
+    }
+
+    std::string connectivity() {
+        return query([this] { return network.getConnectivity(); });
+    }
+
+    std::vector<Device> devices() {
+        return query([this] {
+            std::vector<NetworkManager::DeviceInfo> links;
+            if (!network.listDevices(links)) {
+                throw NetworkException("Failed to list devices");
+            }
+            std::vector<Device> devices;
+            for (const auto &device : links) {
+                devices.push_back({device.name, device.type, device.state});
+            }
+            return devices;
+        });
+    }
+
+    bool wifiRadioEnabled() {
+        return query([this] {
+            ManagedObjects objects = managedObjects();
+            const auto *adapter = findObject(objects, IwdAdapterProperties::INTERFACE);
+            if (!adapter) {
+                throw NetworkException("No WiFi adapter found");
+            }
+            // 只需要 Powered，不解码适配器的其他属性
+            const PropertyMap &properties = adapter->second.at(IwdAdapterProperties::INTERFACE);
+            auto powered = properties.find("Powered");
+            if (powered == properties.end()) {
+                throw NetworkException("WiFi adapter does not report Powered");
+            }
+            return iwdPropertyValue<bool>(powered->second, IwdAdapterProperties::INTERFACE, "Powered");
+        });
+    }
+
+    std::vector<WifiNetwork> wifiNetworks(bool rescan) {
+        return query([this, rescan] {
+            // 扫描协调、排序和信号质量与 device wifi list 相同
+            NetworkManager::WifiListing listing =
+                network.collectWifiNetworks(rescan ? RescanPolicy::Yes : RescanPolicy::No);
+            if (listing.scan_timed_out) {
+                throw NetworkException("Scan timeout");
+            }
+
+            // 快照中没有是否已保存，从一次 GetManagedObjects 读取
+            ManagedObjects objects = managedObjects();
+
+            const ScanSnapshot &snapshot = listing.networks;
+            std::vector<WifiNetwork> networks;
+            networks.reserve(listing.order.size());
+            for (const uint32_t i : listing.order) {
+                const PropertyMap *properties =
+                    findInterface(objects, std::string(snapshot.objectPath(i)), IwdNetworkProperties::INTERFACE);
+                WifiNetwork entry;
+                entry.ssid = std::string(snapshot.ssid(i));
+                entry.security = std::string(snapshot.security(i));
+                entry.signal_dbm = snapshot.signal(i) / 100;
+                entry.quality = listing.quality[i];
+                entry.in_use = snapshot.inUse(i);
+                entry.known = properties && properties->count("KnownNetwork");
+                networks.push_back(std::move(entry));
+            }
+            return networks;
+        });
+    }
+
+    std::vector<Connection> connections(bool active_only) {
+        return query([this, active_only] {
+            // 命名、UUID、--active 和排列顺序与 connection show 相同
+            std::vector<Connection> connections;
+            for (auto &info : network.collectConnections(active_only)) {
+                connections.push_back(
+                    {std::move(info.name), std::move(info.uuid), std::move(info.type), std::move(info.device)}
+                );
+            }
+            return connections;
+        });
+    }
+
+    void dispatch(const StateSnapshot &snapshot) {
+        std::vector<StateCallback> targets;
+        {
+            std::lock_guard<std::mutex> lock(watch_mutex);
+            for (const auto &[id, callback] : callbacks) {
+                targets.push_back(callback);
+            }
+        }
+        for (const auto &callback : targets) {
+            try {
+                callback(snapshot);
+            } catch (...) {
+            }
+        }
+    }
+
+    void runWatcher() {
+        DiagnosticsMute mute;
+        NetworkManager watchNetwork;
+        auto idle = [this] { return shutdown || callbacks.empty(); };
+
+        std::unique_lock<std::mutex> lock(watch_mutex);
+        while (!shutdown) {
+            watch_cv.wait(lock, [this] { return shutdown || !callbacks.empty(); });
+            if (shutdown) {
+                break;
+            }
+            const int interval = interval_ms;
+            lock.unlock();
+
+            bool failed = false;
+            try {
+                watchNetwork.watchState(
+                    interval, [this](const StateSnapshot &snapshot) { dispatch(snapshot); },
+                    [&] {
+                        std::lock_guard<std::mutex> guard(watch_mutex);
+                        return idle();
+                    },
+                    wake_fd
+                );
+            } catch (const std::exception &) {
+                // 系统总线断开等情况，稍后重新建立连接
+                failed = true;
+            }
+
+            lock.lock();
+            if (failed) {
+                watch_cv.wait_for(lock, std::chrono::seconds(1), [this] { return shutdown; });
+            }
+        }
+    }
+};
+
+NmcliClient::NmcliClient() {
+    try {
+        impl_ = std::make_unique<Impl>();
+    } catch (const sdbus::Error &e) {
+        throw DBusException("Failed to connect to the system bus: " + e.getMessage());
+    }
+}
+
+NmcliClient::~NmcliClient() = default;
+
+std::string NmcliClient::connectivity() {
+    return impl_->connectivity();
+}
+
+std::vector<NmcliClient::Device> NmcliClient::devices() {
+    return impl_->devices();
+}
+
+bool NmcliClient::wifiRadioEnabled() {
+    return impl_->wifiRadioEnabled();
+}
+
+std::vector<NmcliClient::WifiNetwork> NmcliClient::wifiNetworks(bool rescan) {
+    return impl_->wifiNetworks(rescan);
+}
+
+std::vector<NmcliClient::Connection> NmcliClient::connections(bool active_only) {
+    return impl_->connections(active_only);
+}
+
+std::future<std::string> NmcliClient::connectivityAsync() {
+    return impl_->submit([impl = impl_.get()] { return impl->connectivity(); });
+}
+
+std::future<std::vector<NmcliClient::Device>> NmcliClient::devicesAsync() {
+    return impl_->submit([impl = impl_.get()] { return impl->devices(); });
+}
+
+std::future<bool> NmcliClient::wifiRadioEnabledAsync() {
+    return impl_->submit([impl = impl_.get()] { return impl->wifiRadioEnabled(); });
+}
+
+std::future<std::vector<NmcliClient::WifiNetwork>> NmcliClient::wifiNetworksAsync(bool rescan) {
+    return impl_->submit([impl = impl_.get(), rescan] { return impl->wifiNetworks(rescan); });
+}
+
+std::future<std::vector<NmcliClient::Connection>> NmcliClient::connectionsAsync(bool active_only) {
+    return impl_->submit([impl = impl_.get(), active_only] { return impl->connections(active_only); });
+}
+uint64_t NmcliClient::onStateChanged(StateCallback callback, int interval_ms) {
+    uint64_t id;
+    {
+        std::lock_guard<std::mutex> lock(impl_->watch_mutex);
+        id = impl_->next_id++;
+        if (impl_->callbacks.empty()) {
+            impl_->interval_ms = interval_ms;
+        }
+        impl_->callbacks.emplace(id, std::move(callback));
+        if (!impl_->watcher.joinable()) {
+            impl_->watcher = std::thread([impl = impl_.get()] { impl->runWatcher(); });
+        }
+    }
+    impl_->watch_cv.notify_all();
+    // 正在运行的监视循环立即重新采集，新回调不必等到下一次变化
+    impl_->wake();
+    return id;
+}
+
+void NmcliClient::removeStateCallback(uint64_t id) {
+    {
+        std::lock_guard<std::mutex> lock(impl_->watch_mutex);
+        impl_->callbacks.erase(id);
+    }
+    // 让监视循环重新检查是否还有回调
+    impl_->wake();
+}
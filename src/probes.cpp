@@ -0,0 +1,220 @@
+#include "probes.h"
+
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+#if !defined(NMCLI_ALT_NO_USDT) && defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+#define NMCLI_ALT_HAVE_USDT 1
+#endif
+#endif
+
+#ifdef NMCLI_ALT_HAVE_USDT
+#define NMCLI_PROBE2(name, a, b) DTRACE_PROBE2(nmcli_alt, name, a, b)
+#define NMCLI_PROBE4(name, a, b, c, d) DTRACE_PROBE4(nmcli_alt, name, a, b, c, d)
+#else
+#define NMCLI_PROBE2(name, a, b) ((void)(a), (void)(b))
+#define NMCLI_PROBE4(name, a, b, c, d) ((void)(a), (void)(b), (void)(c), (void)(d))
+#endif
+
+namespace {
+
+const char *categoryName(ProbeKind kind) {
+    switch (kind) {
+    case ProbeKind::DBus:
+        return "dbus";
+    case ProbeKind::Netlink:
+        return "netlink";
+    case ProbeKind::Process:
+        return "process";
+    case ProbeKind::Scan:
+        return "scan";
+    case ProbeKind::Render:
+        return "render";
+    }
+    return "other";
+}
+
+long currentTid() {
+    thread_local const long tid = syscall(SYS_gettid);
+    return tid;
+}
+
+// 缓冲区超过这个大小时写入文件
+constexpr size_t FLUSH_BYTES = 64 * 1024;
+
+void appendEscaped(std::string &out, const char *value) {
+    for (; *value; ++value) {
+        const unsigned char c = static_cast<unsigned char>(*value);
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += static_cast<char>(c);
+        } else if (c < 0x20) {
+            char escaped[8];
+            std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+            out += escaped;
+        } else {
+            out += static_cast<char>(c);
+        }
+    }
+}
+
+} // namespace
+
+void Probes::begin(ProbeKind kind, const char *name, const char *detail) {
+    // 探针名必须是字面量，因此按类型分别展开
+    switch (kind) {
+    case ProbeKind::DBus:
+        NMCLI_PROBE2(dbus__call__start, name, detail);
+        break;
+    case ProbeKind::Netlink:
+        NMCLI_PROBE2(netlink__send, name, detail);
+        break;
+    case ProbeKind::Process:
+        NMCLI_PROBE2(process__spawn, name, detail);
+        break;
+    case ProbeKind::Scan:
+        NMCLI_PROBE2(scan__start, name, detail);
+        break;
+    case ProbeKind::Render:
+        NMCLI_PROBE2(render__start, name, detail);
+        break;
+    }
+}
+
+void Probes::end(ProbeKind kind, const char *name, const char *detail, Clock::time_point start, int64_t result) {
+    const Clock::duration elapsed = Clock::now() - start;
+    const int64_t elapsed_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+    switch (kind) {
+    case ProbeKind::DBus:
+        NMCLI_PROBE4(dbus__call__end, name, detail, elapsed_ns, result);
+        break;
+    case ProbeKind::Netlink:
+        NMCLI_PROBE4(netlink__receive, name, detail, elapsed_ns, result);
+        break;
+    case ProbeKind::Process:
+        NMCLI_PROBE4(process__exit, name, detail, elapsed_ns, result);
+        break;
+    case ProbeKind::Scan:
+        NMCLI_PROBE4(scan__complete, name, detail, elapsed_ns, result);
+        break;
+    case ProbeKind::Render:
+        NMCLI_PROBE4(render__end, name, detail, elapsed_ns, result);
+        break;
+    }
+
+    ChromeTrace &trace = ChromeTrace::global();
+    if (trace.enabled()) {
+        trace.add(categoryName(kind), name, detail, start, elapsed, result);
+    }
+}
+
+ChromeTrace &ChromeTrace::global() {
+    static ChromeTrace instance;
+    return instance;
+}
+
+ChromeTrace::~ChromeTrace() {
+    if (file_) {
+        std::fclose(file_);
+    }
+}
+
+bool ChromeTrace::enable(const std::string &path) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (file_) {
+        // 重复的 --trace 以最后一个为准
+        std::fclose(file_);
+    }
+    file_ = std::fopen(path.c_str(), "w");
+    if (!file_) {
+        std::cerr << "Error: cannot write trace to " << path << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+    path_ = path;
+    origin_ = Probes::Clock::now();
+    pid_ = getpid();
+
+    char buffer[160];
+    std::snprintf(
+        buffer, sizeof(buffer),
+        "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n"
+        "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%ld,\"args\":{\"name\":\"nmcli-alt\"}}",
+        pid_
+    );
+    pending_ = buffer;
+    pending_.reserve(FLUSH_BYTES + 1024);
+    enabled_.store(true, std::memory_order_relaxed);
+    return true;
+}
+
+void ChromeTrace::add(
+    const char *category, const char *name, const char *detail, Probes::Clock::time_point start,
+    Probes::Clock::duration elapsed, int64_t result
+) {
+    const long tid = currentTid();
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!file_) {
+        return;
+    }
+
+    // 时间戳以微秒为单位，从 --trace 生效时起算
+    const double ts = std::chrono::duration<double, std::micro>(start - origin_).count();
+    const double dur = std::chrono::duration<double, std::micro>(elapsed).count();
+    char buffer[160];
+    pending_ += ",\n{\"name\":\"";
+    appendEscaped(pending_, name);
+    pending_ += "\",\"cat\":\"";
+    pending_ += category;
+    std::snprintf(
+        buffer, sizeof(buffer), "\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":%ld,\"tid\":%ld,\"args\":{", ts,
+        dur, pid_, tid
+    );
+    pending_ += buffer;
+    if (detail && *detail) {
+        pending_ += "\"detail\":\"";
+        appendEscaped(pending_, detail);
+        pending_ += "\",";
+    }
+    std::snprintf(buffer, sizeof(buffer), "\"result\":%" PRId64 "}}", result);
+    pending_ += buffer;
+
+    if (pending_.size() >= FLUSH_BYTES) {
+        flushLocked();
+    }
+}
+
+void ChromeTrace::flushLocked() {
+    if (!pending_.empty() && error_ == 0) {
+        if (std::fwrite(pending_.data(), 1, pending_.size(), file_) != pending_.size()) {
+            error_ = errno;
+        }
+    }
+    // 写入失败后丢弃后续区间，不让缓冲区继续增长
+    pending_.clear();
+}
+
+bool ChromeTrace::write() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!file_) {
+        return false;
+    }
+    pending_ += "\n]}\n";
+    flushLocked();
+    if (std::fclose(file_) != 0 && error_ == 0) {
+        error_ = errno;
+    }
+    file_ = nullptr;
+    enabled_.store(false, std::memory_order_relaxed);
+    if (error_ != 0) {
+        std::cerr << "Error: cannot write trace to " << path_ << ": " << strerror(error_) << std::endl;
+        return false;
+    }
+    return true;
+}
@@ -1,16 +1,85 @@
 #include "process_util.h"
+#include "deadline.h"
+#include "probes.h"
 #include <iostream>
+#include <chrono>
+#include <thread>
 #include <unistd.h>
+#include <poll.h>
+#include <cerrno>
+#include <csignal>
+#include <sys/syscall.h>
 #include <sys/wait.h>
 #include <cstring>
 #include <sstream>
 
+namespace {
+
+enum class WaitResult {
+    Exited,   // 子进程已退出并被回收，status 有效
+    TimedOut, // 截止时间已到，子进程仍在运行
+    Failed,   // 等待本身失败（例如子进程已被别处回收）
+};
+
+// 被信号打断时重试的waitpid
+pid_t waitpidRetry(pid_t pid, int& status, int options) {
+    pid_t result;
+    do {
+        result = waitpid(pid, &status, options);
+    } while (result < 0 && errno == EINTR);
+    return result;
+}
+
+// 在截止时间前等待子进程退出；只有 deadline 确实到期才返回 TimedOut
+WaitResult waitWithDeadline(pid_t pid, int& status, const Deadline& deadline) {
+#ifdef SYS_pidfd_open
+    // 优先使用pidfd，子进程退出时pidfd变为可读
+    int pidfd = static_cast<int>(syscall(SYS_pidfd_open, pid, 0));
+    if (pidfd >= 0) {
+        struct pollfd pfd = {pidfd, POLLIN, 0};
+        int ready;
+        do {
+            ready = poll(&pfd, 1, deadline.pollTimeoutMs());
+        } while ((ready < 0 && errno == EINTR) || (ready == 0 && !deadline.expired()));
+        close(pidfd);
+        if (ready > 0) {
+            return waitpidRetry(pid, status, 0) == pid ? WaitResult::Exited : WaitResult::Failed;
+        }
+        if (ready == 0) {
+            return WaitResult::TimedOut;
+        }
+        // poll失败时退回到下面的轮询
+    }
+#endif
+
+    // 内核不支持pidfd时退回到轮询
+    while (true) {
+        pid_t result = waitpidRetry(pid, status, WNOHANG);
+        if (result == pid) {
+            return WaitResult::Exited;
+        }
+        if (result < 0) {
+            return WaitResult::Failed;
+        }
+        if (deadline.expired()) {
+            return WaitResult::TimedOut;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+}
+
+} // namespace
+
 int ProcessUtil::executeCommand(const std::string& command, const std::vector<std::string>& args) {
+    // 子进程从这里到被回收为止是一个区间（子进程 exec 前不会触发探针）
+    ProbeSpan probe(ProbeKind::Process, command.c_str());
+
     // 创建子进程
     pid_t pid = fork();
     
     if (pid == -1) {
         // fork失败
+        probe.setResult(-1);
         std::cerr << "Failed to fork process" << std::endl;
         return -1;
     } else if (pid == 0) {
@@ -36,13 +105,31 @@ int ProcessUtil::executeCommand(const std::string& command, const std::vector<st
     } else {
         // 父进程
         int status;
-        waitpid(pid, &status, 0);
+        const Deadline& deadline = Deadline::global();
+        const WaitResult waited = deadline.unlimited()
+                                      ? (waitpidRetry(pid, status, 0) == pid ? WaitResult::Exited : WaitResult::Failed)
+                                      : waitWithDeadline(pid, status, deadline);
+        if (waited == WaitResult::TimedOut) {
+            // 预算耗尽，终止子进程并回收，避免留下僵尸进程
+            kill(pid, SIGKILL);
+            waitpidRetry(pid, status, 0);
+            probe.setResult(-1);
+            throw TimeoutException("Timeout expired while waiting for " + command);
+        }
+        if (waited == WaitResult::Failed) {
+            // 等待出错不是超时，按执行失败报告
+            probe.setResult(-1);
+            std::cerr << "Failed to wait for command " << command << ": " << strerror(errno) << std::endl;
+            return -1;
+        }
         
         if (WIFEXITED(status)) {
             // 正常退出
+            probe.setResult(WEXITSTATUS(status));
             return WEXITSTATUS(status);
         } else {
             // 异常退出
+            probe.setResult(-1);
             std::cerr << "Command exited abnormally" << std::endl;
             return -1;
         }
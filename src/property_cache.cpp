@@ -0,0 +1,203 @@
+#include "property_cache.h"
+#include "dbus_async.h"
+#include "trace.h"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string_view>
+
+namespace {
+
+constexpr char CACHE_MAGIC[] = "NMCACHE1";
+constexpr size_t CACHE_MAGIC_SIZE = sizeof(CACHE_MAGIC) - 1;
+
+} // namespace
+
+PropertyCache &PropertyCache::global() {
+    static PropertyCache cache;
+    return cache;
+}
+
+std::string PropertyCache::defaultPath() {
+    const char *runtime_dir = std::getenv("XDG_RUNTIME_DIR");
+    if (!runtime_dir || runtime_dir[0] == '\0') {
+        return "";
+    }
+    return std::string(runtime_dir) + "/nmcli-alt/iwd-cache";
+}
+
+void PropertyCache::enable(const std::string &path) {
+    path_ = path;
+    load();
+}
+
+void PropertyCache::load() {
+    int fd = open(path_.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) < 0 || static_cast<size_t>(st.st_size) < CACHE_MAGIC_SIZE) {
+        close(fd);
+        return;
+    }
+    const size_t size = static_cast<size_t>(st.st_size);
+    void *map = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        return;
+    }
+
+    const std::string_view data(static_cast<const char *>(map), size);
+    if (data.substr(0, CACHE_MAGIC_SIZE) == std::string_view(CACHE_MAGIC, CACHE_MAGIC_SIZE)) {
+        try {
+            TraceDecoder decoder(data.substr(CACHE_MAGIC_SIZE));
+            std::string owner(decoder.bytes());
+            const uint64_t generation = decoder.u64();
+            std::map<Key, std::string> entries;
+            for (uint32_t count = decoder.u32(); count > 0; --count) {
+                std::string path(decoder.bytes());
+                std::string interface(decoder.bytes());
+                std::string property(decoder.bytes());
+                entries.emplace(
+                    std::make_tuple(std::move(path), std::move(interface), std::move(property)),
+                    std::string(decoder.bytes())
+                );
+            }
+            owner_ = std::move(owner);
+            generation_ = generation;
+            entries_ = std::move(entries);
+        } catch (const NmcliException &) {
+            // 截断的文件（例如写入时断电）按空缓存处理
+        }
+    }
+    munmap(map, size);
+}
+
+bool PropertyCache::covers(const std::string &interface, const std::string &property) const {
+    if (!enabled()) {
+        return false;
+    }
+    // 网络对象路径由 SSID 和安全类型编码而来，同一路径的 Name、Type 不会变化
+    if (interface == "net.connman.iwd.Network" || interface == "net.connman.iwd.KnownNetwork") {
+        return property == "Name" || property == "Type";
+    }
+    return interface == "net.connman.iwd.Device" && property == "Name";
+}
+
+bool PropertyCache::validate(sdbus::IConnection &connection) {
+    if (validated_) {
+        return usable_;
+    }
+    validated_ = true;
+
+    std::string owner;
+    try {
+        auto bus = sdbus::createProxy(
+            connection, sdbus::ServiceName{"org.freedesktop.DBus"}, sdbus::ObjectPath{"/org/freedesktop/DBus"}
+        );
+        owner = dbusCall<std::string>(
+            *bus, "org.freedesktop.DBus", "GetNameOwner", "resolving iwd", std::string("net.connman.iwd")
+        );
+    } catch (const sdbus::Error &) {
+        // iwd 不在总线上，本次运行不使用缓存
+        usable_ = false;
+        return false;
+    }
+
+    if (owner != owner_) {
+        // iwd 在两次运行之间重启过，对象路径和属性都要重新读取
+        if (!entries_.empty()) {
+            entries_.clear();
+            generation_++;
+        }
+        owner_ = std::move(owner);
+        dirty_ = true;
+    }
+    usable_ = true;
+    return true;
+}
+
+const std::string *PropertyCache::lookup(
+    sdbus::IConnection &connection, const std::string &path, const std::string &interface, const std::string &property
+) {
+    if (!enabled() || !validate(connection)) {
+        return nullptr;
+    }
+    auto it = entries_.find(std::make_tuple(path, interface, property));
+    return it == entries_.end() ? nullptr : &it->second;
+}
+
+void PropertyCache::store(
+    const std::string &path, const std::string &interface, const std::string &property, std::string value
+) {
+    // 只在确认过唯一总线名之后写入，保证条目和 owner_ 属于同一个 iwd 进程
+    if (!enabled() || !validated_ || !usable_) {
+        return;
+    }
+    auto [it, inserted] = entries_.try_emplace(std::make_tuple(path, interface, property));
+    if (inserted || it->second != value) {
+        it->second = std::move(value);
+        dirty_ = true;
+    }
+}
+
+void PropertyCache::invalidate() {
+    entries_.clear();
+    generation_++;
+    validated_ = false;
+    usable_ = false;
+    dirty_ = true;
+}
+
+void PropertyCache::noteError(const std::string &error_name) {
+    if (enabled() && !entries_.empty() &&
+        (error_name == "org.freedesktop.DBus.Error.UnknownObject" ||
+         error_name == "org.freedesktop.DBus.Error.UnknownInterface" ||
+         error_name == "org.freedesktop.DBus.Error.UnknownMethod")) {
+        invalidate();
+    }
+}
+
+void PropertyCache::flush() {
+    if (!enabled() || !dirty_) {
+        return;
+    }
+
+    std::string data(CACHE_MAGIC, CACHE_MAGIC_SIZE);
+    TraceEncoder encoder(data);
+    encoder.bytes(owner_);
+    encoder.u64(generation_);
+    encoder.u32(static_cast<uint32_t>(entries_.size()));
+    for (const auto &[key, value] : entries_) {
+        encoder.bytes(std::get<0>(key));
+        encoder.bytes(std::get<1>(key));
+        encoder.bytes(std::get<2>(key));
+        encoder.bytes(value);
+    }
+
+    const size_t slash = path_.rfind('/');
+    if (slash != std::string::npos && slash > 0) {
+        mkdir(path_.substr(0, slash).c_str(), 0700);
+    }
+
+    // 同时结束的多个进程各自写临时文件，rename 保证读取方看到的总是某一个完整版本
+    const std::string tmp_path = path_ + "." + std::to_string(getpid()) + ".tmp";
+    // 缓存里有已知网络的名称，只允许本用户读取
+    int fd = open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        return;
+    }
+    const bool written = write(fd, data.data(), data.size()) == static_cast<ssize_t>(data.size());
+    if (close(fd) != 0 || !written || rename(tmp_path.c_str(), path_.c_str()) != 0) {
+        unlink(tmp_path.c_str());
+        return;
+    }
+    dirty_ = false;
+}
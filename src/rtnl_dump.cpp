@@ -0,0 +1,270 @@
+#include "rtnl_dump.h"
+#include "deadline.h"
+#include "trace.h"
+
+#include <netlink/netlink.h>
+#include <netlink/msg.h>
+#include <netlink/attr.h>
+#include <netlink/route/link.h>
+#include <linux/rtnetlink.h>
+#include <linux/if_addr.h>
+#include <linux/if_arp.h>
+#include <arpa/inet.h>
+#include <cstdio>
+#include <cstring>
+#include <utility>
+
+namespace {
+
+struct DumpContext {
+    std::map<int, RtnlDump::LinkRecord> links;
+    // (ifindex, family) -> 已记录默认路由的 metric，用于选择 metric 最小的网关
+    std::map<std::pair<int, int>, uint32_t> gateway_metrics;
+    bool has_default_route = false;
+};
+
+std::string addressToString(int family, const void *data) {
+    char buf[INET6_ADDRSTRLEN];
+    if (!inet_ntop(family, data, buf, sizeof(buf))) {
+        return "";
+    }
+    return buf;
+}
+
+int onLink(struct nl_msg *msg, void *arg) {
+    auto *ctx = static_cast<DumpContext *>(arg);
+    struct nlmsghdr *nlh = nlmsg_hdr(msg);
+    if (nlh->nlmsg_type != RTM_NEWLINK) {
+        return NL_SKIP;
+    }
+
+    auto *ifi = static_cast<struct ifinfomsg *>(nlmsg_data(nlh));
+    struct nlattr *tb[IFLA_MAX + 1];
+    if (nlmsg_parse(nlh, sizeof(*ifi), tb, IFLA_MAX, nullptr) < 0) {
+        return NL_SKIP;
+    }
+
+    RtnlDump::LinkRecord &link = ctx->links[ifi->ifi_index];
+    link.ifindex = ifi->ifi_index;
+    link.flags = ifi->ifi_flags;
+
+    if (tb[IFLA_IFNAME]) {
+        link.name = nla_get_string(tb[IFLA_IFNAME]);
+    }
+    if (tb[IFLA_MTU]) {
+        link.mtu = nla_get_u32(tb[IFLA_MTU]);
+    }
+    if (tb[IFLA_OPERSTATE]) {
+        link.operstate = nla_get_u8(tb[IFLA_OPERSTATE]);
+    }
+
+    if (tb[IFLA_ADDRESS]) {
+        const auto *mac = static_cast<const unsigned char *>(nla_data(tb[IFLA_ADDRESS]));
+        int len = nla_len(tb[IFLA_ADDRESS]);
+        link.hwaddr.clear();
+        link.hwaddr.reserve(len * 3);
+        for (int i = 0; i < len; ++i) {
+            char octet[4];
+            std::snprintf(octet, sizeof(octet), i == 0 ? "%02X" : ":%02X", mac[i]);
+            link.hwaddr += octet;
+        }
+    }
+
+    const char *kind = nullptr;
+    if (tb[IFLA_LINKINFO]) {
+        struct nlattr *info[IFLA_INFO_MAX + 1];
+        if (nla_parse_nested(info, IFLA_INFO_MAX, tb[IFLA_LINKINFO], nullptr) >= 0 && info[IFLA_INFO_KIND]) {
+            kind = nla_get_string(info[IFLA_INFO_KIND]);
+        }
+    }
+    link.type = RtnlDump::linkType(kind, ifi->ifi_type, link.name);
+
+    return NL_SKIP;
+}
+
+int onAddress(struct nl_msg *msg, void *arg) {
+    auto *ctx = static_cast<DumpContext *>(arg);
+    struct nlmsghdr *nlh = nlmsg_hdr(msg);
+    if (nlh->nlmsg_type != RTM_NEWADDR) {
+        return NL_SKIP;
+    }
+
+    auto *ifa = static_cast<struct ifaddrmsg *>(nlmsg_data(nlh));
+    if (ifa->ifa_family != AF_INET && ifa->ifa_family != AF_INET6) {
+        return NL_SKIP;
+    }
+
+    auto it = ctx->links.find(static_cast<int>(ifa->ifa_index));
+    if (it == ctx->links.end()) {
+        return NL_SKIP;
+    }
+
+    struct nlattr *tb[IFA_MAX + 1];
+    if (nlmsg_parse(nlh, sizeof(*ifa), tb, IFA_MAX, nullptr) < 0) {
+        return NL_SKIP;
+    }
+
+    // 点对点链路上 IFA_ADDRESS 是对端地址，本地地址在 IFA_LOCAL 中
+    struct nlattr *addr = tb[IFA_LOCAL] ? tb[IFA_LOCAL] : tb[IFA_ADDRESS];
+    if (!addr) {
+        return NL_SKIP;
+    }
+
+    // IFA_FLAGS 是 32 位扩展标志，旧内核只有 ifa_flags
+    const uint32_t flags = tb[IFA_FLAGS] ? nla_get_u32(tb[IFA_FLAGS]) : ifa->ifa_flags;
+    it->second.addresses.push_back(
+        {ifa->ifa_family, addressToString(ifa->ifa_family, nla_data(addr)), ifa->ifa_prefixlen, ifa->ifa_scope, flags}
+    );
+    return NL_SKIP;
+}
+
+int onRoute(struct nl_msg *msg, void *arg) {
+    auto *ctx = static_cast<DumpContext *>(arg);
+    struct nlmsghdr *nlh = nlmsg_hdr(msg);
+    if (nlh->nlmsg_type != RTM_NEWROUTE) {
+        return NL_SKIP;
+    }
+
+    auto *rtm = static_cast<struct rtmsg *>(nlmsg_data(nlh));
+    // 只关心主路由表中的默认单播路由
+    if (rtm->rtm_dst_len != 0 || rtm->rtm_type != RTN_UNICAST) {
+        return NL_SKIP;
+    }
+
+    struct nlattr *tb[RTA_MAX + 1];
+    if (nlmsg_parse(nlh, sizeof(*rtm), tb, RTA_MAX, nullptr) < 0) {
+        return NL_SKIP;
+    }
+
+    uint32_t table = tb[RTA_TABLE] ? nla_get_u32(tb[RTA_TABLE]) : rtm->rtm_table;
+    if (table != RT_TABLE_MAIN) {
+        return NL_SKIP;
+    }
+    // 与 getConnectivity 相同：主路由表中有默认路由即可，不要求网关（如 wireguard 的 dev 路由）
+    ctx->has_default_route = true;
+    if (!tb[RTA_GATEWAY] || !tb[RTA_OIF]) {
+        return NL_SKIP;
+    }
+
+    int ifindex = static_cast<int>(nla_get_u32(tb[RTA_OIF]));
+    auto it = ctx->links.find(ifindex);
+    if (it == ctx->links.end()) {
+        return NL_SKIP;
+    }
+
+    uint32_t metric = tb[RTA_PRIORITY] ? nla_get_u32(tb[RTA_PRIORITY]) : 0;
+    auto key = std::make_pair(ifindex, static_cast<int>(rtm->rtm_family));
+    auto known = ctx->gateway_metrics.find(key);
+    if (known != ctx->gateway_metrics.end() && known->second <= metric) {
+        return NL_SKIP;
+    }
+    ctx->gateway_metrics[key] = metric;
+
+    std::string gateway = addressToString(rtm->rtm_family, nla_data(tb[RTA_GATEWAY]));
+    if (rtm->rtm_family == AF_INET) {
+        it->second.ipv4_gateway = std::move(gateway);
+    } else if (rtm->rtm_family == AF_INET6) {
+        it->second.ipv6_gateway = std::move(gateway);
+    }
+    return NL_SKIP;
+}
+
+} // namespace
+
+void RtnlDump::SocketDeleter::operator()(struct nl_sock *sock) const {
+    if (sock) {
+        nl_close(sock);
+        nl_socket_free(sock);
+    }
+}
+
+RtnlDump::RtnlDump() : sock_(nl_socket_alloc()) {
+    if (!sock_) {
+        throw NetworkException("Failed to allocate netlink socket");
+    }
+
+    if (nl_connect(sock_.get(), NETLINK_ROUTE) < 0) {
+        throw NetworkException("Failed to connect to rtnetlink");
+    }
+
+    // 地址很多时单条 dump 消息可能超过一个页面
+    nl_socket_enable_msg_peek(sock_.get());
+}
+
+RtnlDump::~RtnlDump() = default;
+
+void RtnlDump::dump(int type, int family, int (*handler)(struct nl_msg *, void *), void *arg) {
+    // 三种请求头都以一字节的地址族开头，按最大的 ifinfomsg 发送
+    struct ifinfomsg request;
+    std::memset(&request, 0, sizeof(request));
+    request.ifi_family = static_cast<unsigned char>(family);
+
+    size_t header_size = sizeof(struct ifinfomsg);
+    if (type == RTM_GETADDR) {
+        header_size = sizeof(struct ifaddrmsg);
+    } else if (type == RTM_GETROUTE) {
+        header_size = sizeof(struct rtmsg);
+    }
+
+    nl_socket_modify_cb(sock_.get(), NL_CB_VALID, NL_CB_CUSTOM, handler, arg);
+
+    const char *operation =
+        type == RTM_GETADDR ? "RTM_GETADDR" : (type == RTM_GETROUTE ? "RTM_GETROUTE" : "RTM_GETLINK");
+
+    // 接收受 --wait 截止时间限制，到期后 recvmsg 以 EAGAIN 返回
+    Deadline::global().applyReceiveTimeout(nl_socket_get_fd(sock_.get()));
+    int err = Trace::global().netlinkExchange(
+        sock_.get(), operation, std::to_string(family),
+        [&] {
+            int sent = nl_send_simple(sock_.get(), type, NLM_F_DUMP, &request, header_size);
+            return sent < 0 ? sent : nl_recvmsgs_default(sock_.get());
+        },
+        handler, arg
+    );
+    Deadline::global().check("waiting for rtnetlink dump");
+    if (err < 0) {
+        throw NetworkException("rtnetlink dump failed: " + std::string(nl_geterror(err)));
+    }
+}
+
+std::map<int, RtnlDump::LinkRecord> RtnlDump::collect(bool with_addresses) {
+    DumpContext ctx;
+
+    // 内核同一 socket 上同时只能进行一个 dump，因此依次发送并在同一 socket 上接收
+    dump(RTM_GETLINK, AF_UNSPEC, onLink, &ctx);
+    if (with_addresses) {
+        dump(RTM_GETADDR, AF_UNSPEC, onAddress, &ctx);
+    }
+    dump(RTM_GETROUTE, AF_UNSPEC, onRoute, &ctx);
+    has_default_route_ = ctx.has_default_route;
+
+    return std::move(ctx.links);
+}
+
+std::string RtnlDump::linkType(const char *kind, unsigned short arptype, const std::string &name) {
+    if (kind) {
+        return kind;
+    }
+    if (arptype == ARPHRD_LOOPBACK) {
+        return "loopback";
+    }
+    if (arptype == ARPHRD_ETHER) {
+        // 与 listDevices 保持一致，以接口名区分无线和有线
+        return (!name.empty() && name[0] == 'w') ? "wifi" : "ethernet";
+    }
+    return "unknown";
+}
+
+bool RtnlDump::usableAddress(int family, uint8_t scope, uint32_t flags) {
+    if (family != AF_INET6) {
+        return family == AF_INET;
+    }
+    // 链路本地地址不能承载外部流量，DAD 未完成的地址还不能使用（完成后内核会再发一次 RTM_NEWADDR）
+    return scope == RT_SCOPE_UNIVERSE && !(flags & (IFA_F_TENTATIVE | IFA_F_DADFAILED));
+}
+
+std::string RtnlDump::operstateToString(uint8_t operstate) {
+    char state_buf[32];
+    rtnl_link_operstate2str(operstate, state_buf, sizeof(state_buf));
+    return state_buf;
+}
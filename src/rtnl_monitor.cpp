@@ -0,0 +1,192 @@
+#include "rtnl_monitor.h"
+#include "rtnl_dump.h"
+#include "trace.h"
+
+#include <netlink/netlink.h>
+#include <netlink/msg.h>
+#include <netlink/attr.h>
+#include <linux/rtnetlink.h>
+#include <linux/if_addr.h>
+#include <linux/if_link.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <cerrno>
+#include <cstring>
+
+namespace {
+
+// 通知消息都很小，一次 recv 可以读取多条
+constexpr size_t RECV_BUFFER_SIZE = 32 * 1024;
+
+std::string addressToString(int family, const void *data) {
+    char buf[INET6_ADDRSTRLEN];
+    if (!inet_ntop(family, data, buf, sizeof(buf))) {
+        return "";
+    }
+    return buf;
+}
+
+bool parseAddress(struct nlmsghdr *nlh, int ifindex, RtnlMonitor::Event &event) {
+    auto *ifa = static_cast<struct ifaddrmsg *>(nlmsg_data(nlh));
+    if (ifindex != 0 && static_cast<int>(ifa->ifa_index) != ifindex) {
+        return false;
+    }
+    if (ifa->ifa_family != AF_INET && ifa->ifa_family != AF_INET6) {
+        return false;
+    }
+
+    struct nlattr *tb[IFA_MAX + 1];
+    if (nlmsg_parse(nlh, sizeof(*ifa), tb, IFA_MAX, nullptr) < 0) {
+        return false;
+    }
+
+    // IFA_FLAGS 是 32 位扩展标志，旧内核只有 ifa_flags
+    uint32_t flags = tb[IFA_FLAGS] ? nla_get_u32(tb[IFA_FLAGS]) : ifa->ifa_flags;
+    if (!RtnlDump::usableAddress(ifa->ifa_family, ifa->ifa_scope, flags)) {
+        return false;
+    }
+
+    struct nlattr *addr = tb[IFA_LOCAL] ? tb[IFA_LOCAL] : tb[IFA_ADDRESS];
+    if (!addr) {
+        return false;
+    }
+
+    event.type = nlh->nlmsg_type == RTM_NEWADDR ? RtnlMonitor::EventType::AddressAdded
+                                                : RtnlMonitor::EventType::AddressRemoved;
+    event.ifindex = static_cast<int>(ifa->ifa_index);
+    event.family = ifa->ifa_family;
+    event.detail = addressToString(ifa->ifa_family, nla_data(addr));
+    return true;
+}
+
+bool parseRoute(struct nlmsghdr *nlh, int ifindex, RtnlMonitor::Event &event) {
+    auto *rtm = static_cast<struct rtmsg *>(nlmsg_data(nlh));
+    if (rtm->rtm_dst_len != 0 || rtm->rtm_type != RTN_UNICAST) {
+        return false;
+    }
+
+    struct nlattr *tb[RTA_MAX + 1];
+    if (nlmsg_parse(nlh, sizeof(*rtm), tb, RTA_MAX, nullptr) < 0) {
+        return false;
+    }
+
+    uint32_t table = tb[RTA_TABLE] ? nla_get_u32(tb[RTA_TABLE]) : rtm->rtm_table;
+    if (table != RT_TABLE_MAIN || !tb[RTA_OIF]) {
+        return false;
+    }
+    const int oif = static_cast<int>(nla_get_u32(tb[RTA_OIF]));
+    if (ifindex != 0 && oif != ifindex) {
+        return false;
+    }
+
+    event.type = nlh->nlmsg_type == RTM_NEWROUTE ? RtnlMonitor::EventType::DefaultRouteAdded
+                                                 : RtnlMonitor::EventType::DefaultRouteRemoved;
+    event.ifindex = oif;
+    event.family = rtm->rtm_family;
+    event.detail = tb[RTA_GATEWAY] ? addressToString(rtm->rtm_family, nla_data(tb[RTA_GATEWAY])) : "";
+    return true;
+}
+
+bool parseLink(struct nlmsghdr *nlh, int ifindex, RtnlMonitor::Event &event) {
+    auto *ifi = static_cast<struct ifinfomsg *>(nlmsg_data(nlh));
+    if (ifindex != 0 && ifi->ifi_index != ifindex) {
+        return false;
+    }
+
+    struct nlattr *tb[IFLA_MAX + 1];
+    if (nlmsg_parse(nlh, sizeof(*ifi), tb, IFLA_MAX, nullptr) < 0) {
+        return false;
+    }
+
+    event.type = RtnlMonitor::EventType::LinkChanged;
+    event.ifindex = ifi->ifi_index;
+    event.family = AF_UNSPEC;
+    event.detail = tb[IFLA_IFNAME] ? nla_get_string(tb[IFLA_IFNAME]) : "";
+    return true;
+}
+
+} // namespace
+
+void RtnlMonitor::SocketDeleter::operator()(struct nl_sock *sock) const {
+    if (sock) {
+        nl_close(sock);
+        nl_socket_free(sock);
+    }
+}
+
+RtnlMonitor::RtnlMonitor(int ifindex) : ifindex_(ifindex) {
+    // 通知没有录制，回放时不订阅，也就不会产生任何事件；地址和路由由调用者的 dump 得到
+    if (Trace::global().replaying()) {
+        return;
+    }
+
+    sock_.reset(nl_socket_alloc());
+    recv_buf_.reset(new char[RECV_BUFFER_SIZE]);
+    if (!sock_) {
+        throw NetworkException("Failed to allocate netlink socket");
+    }
+
+    // 组播通知不是对请求的响应，不检查序列号
+    nl_socket_disable_seq_check(sock_.get());
+
+    if (nl_connect(sock_.get(), NETLINK_ROUTE) < 0) {
+        throw NetworkException("Failed to connect to rtnetlink");
+    }
+
+    if (nl_socket_add_memberships(
+            sock_.get(), RTNLGRP_LINK, RTNLGRP_IPV4_IFADDR, RTNLGRP_IPV6_IFADDR, RTNLGRP_IPV4_ROUTE, RTNLGRP_IPV6_ROUTE,
+            0
+        ) < 0) {
+        throw NetworkException("Failed to subscribe to rtnetlink notifications");
+    }
+
+    nl_socket_set_nonblocking(sock_.get());
+}
+
+RtnlMonitor::~RtnlMonitor() = default;
+
+int RtnlMonitor::fd() const {
+    // poll() 忽略负数 fd
+    return sock_ ? nl_socket_get_fd(sock_.get()) : -1;
+}
+
+void RtnlMonitor::drain(const std::function<void(const Event &)> &callback) {
+    if (!sock_) {
+        return;
+    }
+    const int fd = nl_socket_get_fd(sock_.get());
+
+    while (true) {
+        ssize_t received = recv(fd, recv_buf_.get(), RECV_BUFFER_SIZE, MSG_DONTWAIT);
+        if (received < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                return;
+            }
+            if (errno == ENOBUFS) {
+                callback(Event{EventType::Overflow, 0, AF_UNSPEC, ""});
+                continue;
+            }
+            throw NetworkException("Failed to receive rtnetlink notification: " + std::string(strerror(errno)));
+        }
+
+        int remaining = static_cast<int>(received);
+        for (struct nlmsghdr *nlh = reinterpret_cast<struct nlmsghdr *>(recv_buf_.get()); nlmsg_ok(nlh, remaining);
+             nlh = nlmsg_next(nlh, &remaining)) {
+            Event event;
+            bool matched = false;
+            if (nlh->nlmsg_type == RTM_NEWADDR || nlh->nlmsg_type == RTM_DELADDR) {
+                matched = parseAddress(nlh, ifindex_, event);
+            } else if (nlh->nlmsg_type == RTM_NEWROUTE || nlh->nlmsg_type == RTM_DELROUTE) {
+                matched = parseRoute(nlh, ifindex_, event);
+            } else if (nlh->nlmsg_type == RTM_NEWLINK || nlh->nlmsg_type == RTM_DELLINK) {
+                matched = parseLink(nlh, ifindex_, event);
+            }
+            if (matched) {
+                callback(event);
+            }
+        }
+    }
+}
@@ -0,0 +1,183 @@
+#include "scan_coordinator.h"
+
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstdlib>
+#include <algorithm>
+#include <ctime>
+
+namespace {
+
+constexpr const char *SCAN_STATE_PATH = "/run/nmcli-alt/scan";
+constexpr uint32_t SCAN_STATE_MAGIC = 0x43534d4e; // "NMSC"
+constexpr uint32_t SCAN_STATE_VERSION = 1;
+
+// 持锁进程发起 Scan 之前和扫描结束之后短暂地持有锁而 Scanning 为 false，等待扫描开始的时间上限
+constexpr auto SETTLE_INTERVAL = std::chrono::milliseconds(100);
+
+struct ScanRecord {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t completed_ns; // CLOCK_BOOTTIME，不受系统时间调整影响，挂起期间继续计时
+    int32_t pid;
+    uint32_t reserved;
+};
+
+uint64_t boottimeNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_BOOTTIME, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+// 持有排他锁期间的作用域，扫描抛出异常时也会释放
+class ExclusiveLock {
+  public:
+    explicit ExclusiveLock(int fd) : fd_(fd) {}
+    ~ExclusiveLock() { flock(fd_, LOCK_UN); }
+
+    ExclusiveLock(const ExclusiveLock &) = delete;
+    ExclusiveLock &operator=(const ExclusiveLock &) = delete;
+
+  private:
+    int fd_;
+};
+
+} // namespace
+
+ScanCoordinator::ScanCoordinator() {
+    if (open(SCAN_STATE_PATH)) {
+        return;
+    }
+    // 普通用户无法在 /run 下创建目录时退回到自己的运行时目录，只与同一用户的进程协调
+    const char *runtime_dir = std::getenv("XDG_RUNTIME_DIR");
+    if (runtime_dir && runtime_dir[0] != '\0') {
+        open(std::string(runtime_dir) + "/nmcli-alt/scan");
+    }
+}
+
+ScanCoordinator::ScanCoordinator(const std::string &path) {
+    open(path);
+}
+
+ScanCoordinator::~ScanCoordinator() {
+    if (fd_ >= 0) {
+        close(fd_);
+    }
+}
+
+bool ScanCoordinator::open(const std::string &path) {
+    const size_t slash = path.rfind('/');
+    if (slash != std::string::npos && slash > 0) {
+        mkdir(path.substr(0, slash).c_str(), 0755);
+    }
+
+    // 能打开文件的进程都能占住锁，所以只使用属于自己、其他用户无权打开的文件
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC | O_NOFOLLOW, 0600);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) < 0 || !S_ISREG(st.st_mode) || st.st_uid != geteuid() || (st.st_mode & 077) != 0) {
+        close(fd);
+        return false;
+    }
+    fd_ = fd;
+    path_ = path;
+    return true;
+}
+
+std::optional<std::chrono::milliseconds> ScanCoordinator::lastScanAge() const {
+    ScanRecord record;
+    if (fd_ < 0 || pread(fd_, &record, sizeof(record), 0) != static_cast<ssize_t>(sizeof(record)) ||
+        record.magic != SCAN_STATE_MAGIC || record.version != SCAN_STATE_VERSION) {
+        return std::nullopt;
+    }
+    const uint64_t now = boottimeNs();
+    // 重启后 CLOCK_BOOTTIME 从零开始，上次开机留下的记录比当前时间还新
+    if (record.completed_ns > now) {
+        return std::nullopt;
+    }
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::nanoseconds(now - record.completed_ns));
+}
+
+void ScanCoordinator::recordCompletion() {
+    if (fd_ < 0) {
+        return;
+    }
+    ScanRecord record{SCAN_STATE_MAGIC, SCAN_STATE_VERSION, boottimeNs(), static_cast<int32_t>(getpid()), 0};
+    [[maybe_unused]] ssize_t written = pwrite(fd_, &record, sizeof(record), 0);
+}
+
+bool ScanCoordinator::waitForScan(Clock::duration timeout, const Scanner &scanner) {
+    const auto deadline = Clock::now() + timeout;
+    for (;;) {
+        // 持锁进程的扫描结束时 Scanning 回到 false，由 D-Bus 信号唤醒
+        auto remaining = deadline - Clock::now();
+        if (remaining <= Clock::duration::zero() || !scanner.wait(false, remaining)) {
+            return false;
+        }
+        if (flock(fd_, LOCK_SH | LOCK_NB) == 0) {
+            flock(fd_, LOCK_UN);
+            return true;
+        }
+        if (errno != EWOULDBLOCK) {
+            return false;
+        }
+        // 锁仍被持有而 Scanning 为 false：对方即将发起扫描或正在记录完成时间，等扫描开始后再检查
+        remaining = deadline - Clock::now();
+        if (remaining <= Clock::duration::zero()) {
+            return false;
+        }
+        scanner.wait(true, std::min<Clock::duration>(remaining, SETTLE_INTERVAL));
+    }
+}
+
+bool ScanCoordinator::run(
+    RescanPolicy policy, std::chrono::seconds max_age, Clock::duration timeout, const Scanner &scanner
+) {
+    if (policy == RescanPolicy::No) {
+        return true;
+    }
+    if (fd_ < 0) {
+        return scanner.scan();
+    }
+
+    auto fresh = [this, max_age] {
+        auto age = lastScanAge();
+        return age && *age <= max_age;
+    };
+    if (policy == RescanPolicy::Auto && fresh()) {
+        return true;
+    }
+
+    if (flock(fd_, LOCK_EX | LOCK_NB) < 0) {
+        if (errno != EWOULDBLOCK) {
+            // 文件系统不支持 flock 时不协调
+            return scanner.scan();
+        }
+        // 另一个进程正在扫描：加入它，结束后读取的就是这次扫描的结果
+        return waitForScan(timeout, scanner);
+    }
+
+    ExclusiveLock lock(fd_);
+    // 检查和加锁之间可能刚有一次扫描完成
+    if (policy == RescanPolicy::Auto && fresh()) {
+        return true;
+    }
+    // iwd 的周期扫描或其他客户端的扫描正在进行：加入它，结束后同样记录完成时间
+    if (scanner.scanning()) {
+        if (!scanner.wait(false, timeout)) {
+            return false;
+        }
+        recordCompletion();
+        return true;
+    }
+    if (!scanner.scan()) {
+        return false;
+    }
+    recordCompletion();
+    return true;
+}
@@ -0,0 +1,87 @@
+#include "scan_snapshot.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <new>
+
+namespace {
+
+// 每行各列占用的字节数、SSID 的预留长度（SSID 最长 32 字节）和 iwd 对象路径的典型长度，
+// 用于预估 arena 初始大小
+constexpr size_t ROW_BYTES = 3 * sizeof(std::string_view) + sizeof(int16_t) + sizeof(uint8_t);
+constexpr size_t MAX_SSID_BYTES = 32;
+constexpr size_t OBJECT_PATH_BYTES = 96;
+
+} // namespace
+
+StringInterner::StringInterner(std::pmr::memory_resource *arena) : arena_(arena), strings_(arena) {}
+
+std::string_view StringInterner::intern(std::string_view value) {
+    auto it = strings_.find(value);
+    if (it != strings_.end()) {
+        return *it;
+    }
+
+    char *storage = static_cast<char *>(arena_->allocate(value.size() + 1, alignof(char)));
+    std::memcpy(storage, value.data(), value.size());
+    storage[value.size()] = '\0';
+
+    return *strings_.emplace(storage, value.size()).first;
+}
+
+void *ScanSnapshot::CountingResource::do_allocate(size_t bytes, size_t alignment) {
+    allocations++;
+    this->bytes += bytes;
+    return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+}
+
+void ScanSnapshot::CountingResource::do_deallocate(void *p, size_t bytes, size_t alignment) {
+    std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+}
+
+bool ScanSnapshot::CountingResource::do_is_equal(const std::pmr::memory_resource &other) const noexcept {
+    return this == &other;
+}
+
+ScanSnapshot::ScanSnapshot(size_t expected_networks)
+    : upstream_(std::make_unique<CountingResource>()),
+      arena_(std::make_unique<std::pmr::monotonic_buffer_resource>(
+          expected_networks * (ROW_BYTES + MAX_SSID_BYTES + OBJECT_PATH_BYTES) + 512, upstream_.get()
+      )),
+      interner_(arena_.get()), object_paths_(arena_.get()), ssids_(arena_.get()), securities_(arena_.get()),
+      signals_(arena_.get()), in_use_(arena_.get()) {
+    object_paths_.reserve(expected_networks);
+    ssids_.reserve(expected_networks);
+    securities_.reserve(expected_networks);
+    signals_.reserve(expected_networks);
+    in_use_.reserve(expected_networks);
+}
+
+ScanSnapshot::~ScanSnapshot() = default;
+
+ScanSnapshot::ScanSnapshot(ScanSnapshot &&) noexcept = default;
+
+void ScanSnapshot::add(
+    std::string_view object_path, std::string_view ssid, std::string_view security, int signal_strength, bool in_use
+) {
+    // SSID 和对象路径每个网络各不相同，直接复制到 arena，随快照一起释放
+    ssids_.push_back(copy(ssid));
+    object_paths_.push_back(copy(object_path));
+    securities_.push_back(interner_.intern(security));
+    signals_.push_back(static_cast<int16_t>(std::clamp(signal_strength, INT16_MIN, INT16_MAX)));
+    in_use_.push_back(in_use ? 1 : 0);
+}
+
+std::string_view ScanSnapshot::copy(std::string_view value) {
+    if (value.empty()) {
+        return {};
+    }
+    char *storage = static_cast<char *>(arena_->allocate(value.size(), alignof(char)));
+    std::memcpy(storage, value.data(), value.size());
+    return {storage, value.size()};
+}
+
+ScanSnapshot::Stats ScanSnapshot::stats() const {
+    return {signals_.size(), upstream_ ? upstream_->bytes : 0, upstream_ ? upstream_->allocations : 0};
+}
@@ -0,0 +1,44 @@
+#include "signal_quality.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#if defined(__SSE2__)
+namespace {
+
+// 8 个 int16 的 dBm*100 转换为质量（仍为 int16）
+inline __m128i qualityLanes(__m128i mbm) {
+    // x / 100 向零取整：(x * 20972) >> 21，负数再加 1；对整个 int16 范围精确
+    __m128i dbm = _mm_srai_epi16(_mm_mulhi_epi16(mbm, _mm_set1_epi16(20972)), 5);
+    dbm = _mm_sub_epi16(dbm, _mm_srai_epi16(mbm, 15));
+
+    // clamp(2*dBm+200, 0, 100)
+    __m128i quality = _mm_add_epi16(_mm_add_epi16(dbm, dbm), _mm_set1_epi16(200));
+    quality = _mm_max_epi16(quality, _mm_setzero_si128());
+    quality = _mm_min_epi16(quality, _mm_set1_epi16(100));
+
+    // 低于 -90dBm 直接为 0
+    __m128i below = _mm_cmplt_epi16(dbm, _mm_set1_epi16(-90));
+    return _mm_andnot_si128(below, quality);
+}
+
+} // namespace
+#endif
+
+void signalToQuality(const int16_t *signal_mbm, uint8_t *quality, size_t count) {
+    size_t i = 0;
+
+#if defined(__SSE2__)
+    for (; i + 16 <= count; i += 16) {
+        __m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i *>(signal_mbm + i));
+        __m128i high = _mm_loadu_si128(reinterpret_cast<const __m128i *>(signal_mbm + i + 8));
+        __m128i packed = _mm_packus_epi16(qualityLanes(low), qualityLanes(high));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(quality + i), packed);
+    }
+#endif
+
+    for (; i < count; ++i) {
+        quality[i] = static_cast<uint8_t>(dbmToQuality(signal_mbm[i] / 100));
+    }
+}
@@ -0,0 +1,133 @@
+#include "state_publisher.h"
+
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <utility>
+
+namespace {
+
+template <size_t N> void copyField(char (&field)[N], const std::string &value) {
+    const size_t len = std::min(value.size(), N - 1);
+    std::memcpy(field, value.data(), len);
+    std::memset(field + len, 0, N - len);
+}
+
+std::string errorText() {
+    return std::string(strerror(errno));
+}
+
+} // namespace
+
+StatePublisher::StatePublisher(std::string path, uint32_t interval_ms)
+    : path_(std::move(path)), interval_ms_(interval_ms) {
+    // 默认路径在 /run 下，第一次发布时目录还不存在
+    const size_t slash = path_.rfind('/');
+    if (slash != std::string::npos && slash > 0) {
+        const std::string dir = path_.substr(0, slash);
+        if (mkdir(dir.c_str(), 0755) < 0 && errno != EEXIST) {
+            throw NmcliException("Failed to create " + dir + ": " + errorText());
+        }
+    }
+
+    fd_ = open(path_.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd_ < 0) {
+        throw NmcliException("Failed to open " + path_ + ": " + errorText());
+    }
+
+    if (flock(fd_, LOCK_EX | LOCK_NB) < 0) {
+        const std::string reason = errno == EWOULDBLOCK ? "another publisher is running" : errorText();
+        close(fd_);
+        throw NmcliException("Failed to lock " + path_ + ": " + reason);
+    }
+
+    // 不截断：已有的同版本文件原样复用，读取端不需要重新映射
+    if (ftruncate(fd_, sizeof(ShmState)) < 0) {
+        const std::string reason = errorText();
+        close(fd_);
+        throw NmcliException("Failed to resize " + path_ + ": " + reason);
+    }
+
+    void *map = mmap(nullptr, sizeof(ShmState), PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (map == MAP_FAILED) {
+        const std::string reason = errorText();
+        close(fd_);
+        throw NmcliException("Failed to map " + path_ + ": " + reason);
+    }
+    state_ = static_cast<ShmState *>(map);
+
+    std::atomic_ref<uint32_t> seq(state_->seq);
+    uint32_t current = seq.load(std::memory_order_relaxed);
+    if (state_->magic != SHM_STATE_MAGIC || state_->version != SHM_STATE_VERSION ||
+        state_->size != sizeof(ShmState)) {
+        // 新文件或旧布局：在写区间内清零，读取端在第一次发布前读到的都是无效快照
+        current |= 1;
+        seq.store(current, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        std::memset(
+            reinterpret_cast<char *>(state_) + offsetof(ShmState, generation), 0,
+            sizeof(ShmState) - offsetof(ShmState, generation)
+        );
+        state_->magic = SHM_STATE_MAGIC;
+        state_->version = SHM_STATE_VERSION;
+        state_->size = sizeof(ShmState);
+        seq.store(current + 1, std::memory_order_release);
+    }
+}
+
+StatePublisher::~StatePublisher() {
+    if (state_) {
+        munmap(state_, sizeof(ShmState));
+    }
+    if (fd_ >= 0) {
+        close(fd_);
+    }
+}
+
+void StatePublisher::publish(const StateSnapshot &snapshot) {
+    std::atomic_ref<uint32_t> seq(state_->seq);
+    // 奇数 seq 只可能来自在写区间内退出的上一个发布端，此时沿用它的写区间，本次写入覆盖残缺的数据
+    const uint32_t begin = seq.load(std::memory_order_relaxed) | 1;
+    seq.store(begin, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    state_->generation++;
+    state_->updated_ns = static_cast<uint64_t>(now.tv_sec) * 1000000000ull + static_cast<uint64_t>(now.tv_nsec);
+    state_->interval_ms = interval_ms_;
+    state_->iwd_available = snapshot.iwd_available ? 1 : 0;
+    state_->radio_enabled = snapshot.radio_enabled ? (*snapshot.radio_enabled ? 1 : 0) : -1;
+    copyField(state_->connectivity, snapshot.connectivity);
+
+    state_->link_count = static_cast<uint32_t>(std::min(snapshot.links.size(), SHM_MAX_LINKS));
+    state_->links_truncated = snapshot.links.size() > SHM_MAX_LINKS ? 1 : 0;
+    for (uint32_t i = 0; i < state_->link_count; ++i) {
+        const auto &link = snapshot.links[i];
+        ShmLinkRecord &record = state_->links[i];
+        copyField(record.device, link.device);
+        copyField(record.type, link.type);
+        copyField(record.operstate, link.operstate);
+    }
+
+    state_->wifi_count = static_cast<uint32_t>(std::min(snapshot.wifi.size(), SHM_MAX_WIFI));
+    for (uint32_t i = 0; i < state_->wifi_count; ++i) {
+        const auto &wifi = snapshot.wifi[i];
+        ShmWifiRecord &record = state_->wifi[i];
+        copyField(record.device, wifi.device);
+        copyField(record.ssid, wifi.ssid);
+        record.connected = wifi.connected ? 1 : 0;
+        record.has_signal = wifi.has_signal ? 1 : 0;
+        record.signal_dbm = wifi.signal_dbm;
+        record.quality = wifi.quality;
+    }
+
+    seq.store(begin + 1, std::memory_order_release);
+}
@@ -0,0 +1,217 @@
+#include "state_watcher.h"
+#include "deadline.h"
+#include "diagnostics.h"
+#include "iwd_interfaces.h"
+#include "property_cache.h"
+#include "signal_quality.h"
+
+#include <unistd.h>
+#include <iostream>
+#include <utility>
+
+namespace {
+
+// 一次事件风暴（漫游会同时改变链路、地址、路由和 Station 状态）合并为一次采集
+constexpr std::chrono::milliseconds COALESCE_DELAY(50);
+
+} // namespace
+
+StateWatcher::StateWatcher(std::chrono::milliseconds interval, Sink sink)
+    : interval_(interval), sink_(std::move(sink)), loop_(iwd_.connection()), monitor_(0) {
+    bus_proxy_ = sdbus::createProxy(
+        iwd_.connection(), sdbus::ServiceName{"org.freedesktop.DBus"}, sdbus::ObjectPath{"/org/freedesktop/DBus"}
+    );
+    owner_subscription_ = bus_proxy_->uponSignal("NameOwnerChanged")
+                              .onInterface("org.freedesktop.DBus")
+                              .call(
+                                  [this](const std::string &name, const std::string & /*oldOwner*/,
+                                         const std::string & /*newOwner*/) {
+                                      if (name == "net.connman.iwd") {
+                                          PropertyCache::global().invalidate();
+                                          iwd_changed_ = true;
+                                          scheduleRefresh();
+                                      }
+                                  },
+                                  sdbus::return_slot
+                              );
+}
+
+StateWatcher::~StateWatcher() = default;
+
+void StateWatcher::run(const std::function<bool()> &stop, int wake_fd) {
+    const uint64_t watch = loop_.addWatch(monitor_.fd(), [this] {
+        monitor_.drain([this](const RtnlMonitor::Event &) { scheduleRefresh(); });
+    });
+
+    uint64_t wake_watch = 0;
+    if (wake_fd >= 0) {
+        wake_watch = loop_.addWatch(wake_fd, [this, wake_fd] {
+            uint64_t value;
+            while (read(wake_fd, &value, sizeof(value)) > 0) {
+            }
+            scheduleRefresh();
+        });
+    }
+
+    refresh();
+    loop_.addTimer(DBusEventLoop::Clock::now() + interval_, [this] { tick(); });
+
+    // --wait 的时间预算像停止请求一样结束循环
+    const Deadline &deadline = Deadline::global();
+    if (!deadline.unlimited()) {
+        loop_.addTimer(
+            DBusEventLoop::Clock::now() + deadline.remainingOr(DBusEventLoop::Clock::duration::zero()), [] {}
+        );
+    }
+    loop_.runUntil([&] { return stop() || deadline.expired(); });
+
+    loop_.removeWatch(watch);
+    if (wake_watch != 0) {
+        loop_.removeWatch(wake_watch);
+    }
+}
+
+void StateWatcher::scheduleRefresh() {
+    if (flush_timer_ == 0) {
+        flush_timer_ = loop_.addTimer(DBusEventLoop::Clock::now() + COALESCE_DELAY, [this] {
+            flush_timer_ = 0;
+            refresh();
+        });
+    }
+}
+
+void StateWatcher::tick() {
+    scheduleRefresh();
+    loop_.addTimer(DBusEventLoop::Clock::now() + interval_, [this] { tick(); });
+}
+
+void StateWatcher::attachIwd() {
+    iwd_subscriptions_.clear();
+    adapter_proxy_.reset();
+    station_.reset();
+    wifi_device_.clear();
+
+    auto propertiesChanged = [this](
+                                 const std::string & /*interface*/,
+                                 const std::map<std::string, sdbus::Variant> & /*changed*/,
+                                 const std::vector<std::string> & /*invalidated*/
+                             ) { scheduleRefresh(); };
+
+    try {
+        station_ = iwd_.createStation();
+        if (!station_) {
+            return;
+        }
+        wifi_device_ = station_->getDeviceName();
+        auto stationChanged = [this](
+                                  const std::string &interface, const std::map<std::string, sdbus::Variant> &changed,
+                                  const std::vector<std::string> & /*invalidated*/
+                              ) {
+            // 无论谁发起的扫描，结束时都记录完成时间，--rescan auto 因此可以复用 iwd 的周期扫描
+            auto scanning = changed.find("Scanning");
+            if (interface == "net.connman.iwd.Station" && scanning != changed.end() &&
+                scanning->second.containsValueOfType<bool>() && !scanning->second.get<bool>()) {
+                scan_coordinator_.recordCompletion();
+            }
+            scheduleRefresh();
+        };
+        iwd_subscriptions_.push_back(station_->stationProxy_->uponSignal("PropertiesChanged")
+                                         .onInterface("org.freedesktop.DBus.Properties")
+                                         .call(stationChanged, sdbus::return_slot));
+
+        std::string adapterPath = iwd_.getAdapterObjectPath();
+        if (!adapterPath.empty()) {
+            adapter_proxy_ = sdbus::createProxy(
+                iwd_.connection(), sdbus::ServiceName{"net.connman.iwd"}, sdbus::ObjectPath{adapterPath}
+            );
+            iwd_subscriptions_.push_back(adapter_proxy_->uponSignal("PropertiesChanged")
+                                             .onInterface("org.freedesktop.DBus.Properties")
+                                             .call(propertiesChanged, sdbus::return_slot));
+        }
+    } catch (const std::exception &) {
+        // iwd 不可用，NameOwnerChanged 会在它出现时触发重新订阅
+        iwd_subscriptions_.clear();
+        adapter_proxy_.reset();
+        station_.reset();
+    }
+}
+
+void StateWatcher::readWifi(StateSnapshot &snapshot) {
+    try {
+        StateSnapshot::WifiState wifi;
+        wifi.device = wifi_device_;
+
+        std::string networkPath = station_->getConnectedNetwork();
+        if (!networkPath.empty()) {
+            wifi.connected = true;
+            auto networkProxy = station_->objectProxy(sdbus::ObjectPath{networkPath});
+            wifi.ssid = IwdNetworkProxy(*networkProxy).name();
+        }
+
+        if (wifi.connected && !wifi_device_.empty()) {
+            auto &sampler = samplers_[wifi_device_];
+            if (!sampler) {
+                sampler = std::make_unique<LinkSampler>(wifi_device_);
+            }
+            LinkSampler::Sample sample;
+            if (sampler->sample(sample)) {
+                wifi.has_signal = true;
+                wifi.signal_dbm = sample.signal;
+                wifi.quality = dbmToQuality(sample.signal);
+            }
+        }
+
+        if (adapter_proxy_) {
+            sdbus::Variant powered = dbusCall<sdbus::Variant>(
+                *adapter_proxy_, "org.freedesktop.DBus.Properties", "Get", "reading radio state",
+                std::string("net.connman.iwd.Adapter"), std::string("Powered")
+            );
+            snapshot.radio_enabled = powered.get<bool>();
+        }
+
+        snapshot.iwd_available = true;
+        snapshot.wifi.push_back(wifi);
+    } catch (const std::exception &e) {
+        // 通常是 iwd 正在退出，NameOwnerChanged 会触发重新订阅
+        diag() << "Error reading iwd state: " << e.what() << std::endl;
+    }
+}
+
+void StateWatcher::refresh() {
+    if (iwd_changed_) {
+        iwd_changed_ = false;
+        attachIwd();
+    }
+
+    StateSnapshot snapshot;
+    // 地址不在快照中，跳过地址 dump；连通性与 networking connectivity 使用同一条默认路由规则
+    for (const auto &[ifindex, link] : dump_.collect(false)) {
+        snapshot.links.push_back({link.name, link.type, RtnlDump::operstateToString(link.operstate)});
+    }
+    snapshot.connectivity = dump_.hasDefaultRoute() ? "full" : "none";
+
+    if (station_) {
+        readWifi(snapshot);
+    }
+
+    // 截止时间到期时读到的状态不完整，不再输出，循环随即结束
+    if (Deadline::global().expired()) {
+        return;
+    }
+    deliver(snapshot);
+}
+
+void StateWatcher::deliver(const StateSnapshot &snapshot) {
+    try {
+        sink_(snapshot);
+        if (sink_failing_) {
+            sink_failing_ = false;
+            diag() << "State output recovered" << std::endl;
+        }
+    } catch (const std::exception &e) {
+        if (!sink_failing_) {
+            sink_failing_ = true;
+            diag() << "Error writing state, will retry on the next refresh: " << e.what() << std::endl;
+        }
+    }
+}
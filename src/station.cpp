@@ -1,10 +1,13 @@
 #include "station.h"
+#include "diagnostics.h"
+#include "iwd_interfaces.h"
+#include "iwd_introspection.h"
+#include "probes.h"
 #include <sdbus-c++/sdbus-c++.h>
-#include <iostream>
-#include <regex>
 
 Station::Station(const std::string &device_object_path)
-    : device_object_path_(device_object_path), connection_(sdbus::createSystemBusConnection()),
+    : device_object_path_(device_object_path), owned_connection_(openSystemBus()),
+      connection_(owned_connection_.get()),
       stationProxy_(
           sdbus::createProxy(
               *connection_, sdbus::ServiceName{"net.connman.iwd"}, sdbus::ObjectPath{device_object_path_}
@@ -13,6 +16,14 @@ Station::Station(const std::string &device_object_path)
     // 构造函数初始化列表中直接初始化connection_和stationProxy_
 }
 
+Station::Station(sdbus::IConnection &connection, const std::string &device_object_path)
+    : device_object_path_(device_object_path), connection_(&connection),
+      stationProxy_(
+          sdbus::createProxy(
+              *connection_, sdbus::ServiceName{"net.connman.iwd"}, sdbus::ObjectPath{device_object_path_}
+          )
+      ) {}
+
 Station::~Station() = default;
 
 // 移除了initializeConnection方法，因为现在在构造函数中直接初始化
@@ -25,7 +36,7 @@ bool Station::scan() {
 
     try {
         // 调用Scan方法
-        stationProxy_->callMethod("Scan").onInterface("net.connman.iwd.Station").dontExpectReply();
+        dbusCall<>(*stationProxy_, "net.connman.iwd.Station", "Scan", "requesting scan");
         return true;
     } catch (const sdbus::Error &e) {
         throw DBusException("D-Bus error scanning networks: " + std::string(e.what()));
@@ -44,8 +55,12 @@ bool Station::disconnect() {
     }
 
     try {
-        // 调用Disconnect方法
-        stationProxy_->callMethod("Disconnect").onInterface("net.connman.iwd.Station").dontExpectReply();
+        // 在当前线程上驱动协程版本直到完成
+        DBusEventLoop loop(*connection_);
+        auto timeout = Deadline::global().remainingOr(std::chrono::seconds(10));
+        if (!loop.run(disconnectAsync(loop, timeout))) {
+            diag() << "Timed out waiting for station to disconnect" << std::endl;
+        }
         return true;
     } catch (const sdbus::Error &e) {
         throw DBusException("D-Bus error disconnecting: " + std::string(e.what()));
@@ -57,9 +72,77 @@ bool Station::disconnect() {
     }
 }
 
+DBusTask<bool> Station::scanAsync(DBusEventLoop &loop, DBusEventLoop::Clock::duration timeout) {
+    // 从请求扫描到 Scanning 回到 false 是一个区间，失败、超时或任务被取消时 result 为 1
+    ProbeSpan probe(ProbeKind::Scan, "Scan", device_object_path_.c_str());
+    probe.setResult(1);
+
+    // iwd 连接或自动连接期间、或另一个客户端的扫描抢先开始时返回 Busy/InProgress，
+    // 这不是失败：正在扫描就等这次扫描结束，否则让调用者使用已有的扫描结果
+    std::string refused;
+    try {
+        co_await dbusCallAsync<>(loop, *stationProxy_, "net.connman.iwd.Station", "Scan");
+    } catch (const sdbus::Error &e) {
+        if (e.getName() != "net.connman.iwd.Busy" && e.getName() != "net.connman.iwd.InProgress") {
+            throw;
+        }
+        refused = e.getName();
+    }
+    if (!refused.empty()) {
+        sdbus::Variant scanning = co_await dbusCallAsync<sdbus::Variant>(
+            loop, *stationProxy_, "org.freedesktop.DBus.Properties", "Get", std::string("net.connman.iwd.Station"),
+            std::string("Scanning")
+        );
+        if (!scanning.containsValueOfType<bool>() || !scanning.get<bool>()) {
+            diag() << "Scan refused (" << refused << "), using existing results" << std::endl;
+            co_return false;
+        }
+    }
+
+    // Scan 返回时扫描已经开始（或 iwd 正在进行另一次扫描），等待 Scanning 属性回到 false
+    const bool completed = co_await DBusPropertyWait(
+        loop, *stationProxy_, "net.connman.iwd.Station", "Scanning", DBusPropertyWait::equals(false), timeout
+    );
+    probe.setResult(completed ? 0 : 1);
+    co_return completed;
+}
+
+DBusTask<bool>
+Station::waitScanningAsync(DBusEventLoop &loop, bool scanning, DBusEventLoop::Clock::duration timeout) {
+    co_return co_await DBusPropertyWait(
+        loop, *stationProxy_, "net.connman.iwd.Station", "Scanning", DBusPropertyWait::equals(scanning), timeout
+    );
+}
+
+DBusTask<bool> Station::disconnectAsync(DBusEventLoop &loop, DBusEventLoop::Clock::duration timeout) {
+    co_await dbusCallAsync<>(loop, *stationProxy_, "net.connman.iwd.Station", "Disconnect");
+
+    co_return co_await DBusPropertyWait(
+        loop, *stationProxy_, "net.connman.iwd.Station", "State", DBusPropertyWait::equals<std::string>("disconnected"),
+        timeout
+    );
+}
+
 std::vector<Station::NetworkInfo> Station::getOrderedNetworks() {
+    ScanSnapshot snapshot = getScanSnapshot();
+
     std::vector<NetworkInfo> networks;
+    networks.reserve(snapshot.size());
+
+    for (size_t i = 0; i < snapshot.size(); ++i) {
+        NetworkInfo info;
+        info.object_path = std::string(snapshot.objectPath(i));
+        info.ssid = std::string(snapshot.ssid(i));
+        info.security = std::string(snapshot.security(i));
+        info.signal_strength = snapshot.signal(i);
+        info.in_use = snapshot.inUse(i);
+        networks.push_back(std::move(info));
+    }
 
+    return networks;
+}
+
+ScanSnapshot Station::getScanSnapshot() {
     // 检查D-Bus连接是否已初始化
     if (!connection_) {
         throw DBusException("D-Bus connection not initialized");
@@ -72,40 +155,30 @@ std::vector<Station::NetworkInfo> Station::getOrderedNetworks() {
         );
 
         // 调用D-Bus方法并直接存储到目标类型，不使用Variant中转
-        std::vector<sdbus::Struct<sdbus::ObjectPath, int16_t>> networkList;
-
-        stationProxy->callMethod("GetOrderedNetworks")
-            .onInterface("net.connman.iwd.Station")
-            .storeResultsTo(networkList); // 直接存储到networkList
+        auto networkList = dbusCall<std::vector<sdbus::Struct<sdbus::ObjectPath, int16_t>>>(
+            *stationProxy, "net.connman.iwd.Station", "GetOrderedNetworks", "getting ordered networks"
+        );
 
         // 不在这里打印"Found X networks"信息，而是在调用者那里根据terse_output标志决定是否打印
 
         // 获取当前连接的网络
         const std::string connectedNetwork = getConnectedNetwork();
 
-        // 预分配空间以提高性能
-        networks.reserve(networkList.size());
+        // 按网络数量一次性预留 arena 空间
+        ScanSnapshot snapshot(networkList.size());
 
-        // 使用变换算法而不是手写循环
         for (const auto &[objPath, signalStrength] : networkList) {
-            NetworkInfo info;
-            info.object_path = objPath.c_str();
-            info.signal_strength = signalStrength;
-            info.in_use = (info.object_path == connectedNetwork);
-
-            // 获取网络详细信息
-            // 使用新的模板方法获取SSID
-            info.ssid = getPropertyFromObjectPath<std::string>(
-                sdbus::ObjectPath{info.object_path}, "net.connman.iwd.Network", "Name"
-            );
-
-            // 使用新的模板方法获取安全类型
-            info.security = getPropertyFromObjectPath<std::string>(
-                sdbus::ObjectPath{info.object_path}, "net.connman.iwd.Network", "Type"
-            );
-
-            networks.push_back(std::move(info)); // 使用移动语义
+            // 获取SSID和安全类型（--cache 命中时不发起 D-Bus 调用）
+            auto networkProxy = objectProxy(objPath);
+            IwdNetworkProxy network(*networkProxy);
+            const std::string ssid = network.name();
+            const std::string security = network.type();
+
+            // SSID 复制进快照的 arena，对象路径和安全类型驻留
+            snapshot.add(objPath, ssid, security, signalStrength, objPath == connectedNetwork);
         }
+
+        return snapshot;
     } catch (const sdbus::Error &e) {
         throw DBusException("D-Bus error getting ordered networks: " + std::string(e.what()));
     } catch (const NmcliException &e) {
@@ -114,56 +187,40 @@ std::vector<Station::NetworkInfo> Station::getOrderedNetworks() {
     } catch (const std::exception &e) {
         throw NetworkException("Error getting ordered networks: " + std::string(e.what()));
     }
-
-    return networks;
 }
 
 std::vector<std::string> Station::getAllConnection() {
     auto iwdProxy =
         sdbus::createProxy(*connection_, sdbus::ServiceName{"net.connman.iwd"}, sdbus::ObjectPath{"/net/connman/iwd"});
 
-    std::string introspectionData;
-    iwdProxy->callMethod("Introspect")
-        .onInterface("org.freedesktop.DBus.Introspectable")
-        .storeResultsTo(introspectionData);
-
-    // Parse the introspection data to find known network objects
-    // Known networks are directly under /net/connman/iwd/
-    std::regex nodeRegex("<node name=\"([^\"]+)\"");
-    std::smatch match;
-    std::string::const_iterator searchStart(introspectionData.cbegin());
-
-    std::vector<std::string> wifiConnections;
-    // Find all network nodes
-    while (std::regex_search(searchStart, introspectionData.cend(), match, nodeRegex)) {
-        std::string networkNodeName = match[1].str();
-        searchStart = match.suffix().first;
-
-        // Skip non-network nodes (numeric nodes are adapters/devices)
-        if (std::all_of(networkNodeName.begin(), networkNodeName.end(), ::isdigit)) {
-            continue;
-        }
+    std::string introspectionData = dbusCall<std::string>(
+        *iwdProxy, "org.freedesktop.DBus.Introspectable", "Introspect", "listing known networks"
+    );
 
-        std::string networkPath = "/net/connman/iwd/" + networkNodeName;
-        wifiConnections.push_back(networkPath);
-    }
-    return wifiConnections;
+    return networkPathsFromIntrospection(introspectionData);
 }
 
 std::string Station::getState() const {
-    return getProperty<std::string>("net.connman.iwd.Station", "State");
+    return IwdStationProxy(*stationProxy_).state();
 }
 
 std::string Station::getConnectedNetwork() const {
-    return getProperty<sdbus::ObjectPath>("net.connman.iwd.Station", "ConnectedNetwork").c_str();
+    // 未连接时 iwd 不导出 ConnectedNetwork，返回空串
+    return IwdStationProxy(*stationProxy_).connectedNetwork().value_or(sdbus::ObjectPath{});
 }
 
 bool Station::isScanning() const {
-    return getProperty<bool>("net.connman.iwd.Station", "Scanning");
+    return IwdStationProxy(*stationProxy_).scanning();
 }
 
 std::string Station::getDeviceName() const {
-    return getPropertyFromObjectPath<std::string>(
-        sdbus::ObjectPath{device_object_path_}, "net.connman.iwd.Device", "Name"
-    );
+    // Station 与 Device 在同一对象上
+    return IwdDeviceProxy(*stationProxy_).name();
+}
+
+std::unique_ptr<sdbus::IProxy> Station::objectProxy(const sdbus::ObjectPath &objectPath) const {
+    if (!connection_) {
+        throw std::runtime_error("D-Bus connection not initialized");
+    }
+    return sdbus::createProxy(*connection_, sdbus::ServiceName{"net.connman.iwd"}, objectPath);
 }
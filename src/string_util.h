@@ -0,0 +1,12 @@
+#ifndef STRING_UTIL_H
+#define STRING_UTIL_H
+
+#include <string>
+#include <vector>
+
+// 库内部和命令行前端使用的字符串工具，不随公共头文件安装
+
+// 按分隔符切分字符串，保留空字段（-f 的字段列表）
+std::vector<std::string> split(const std::string &str, char delimiter);
+
+#endif // STRING_UTIL_H
@@ -0,0 +1,217 @@
+#include "trace.h"
+#include "instrumentation.h"
+#include "probes.h"
+
+#include <netlink/netlink.h>
+#include <netlink/msg.h>
+#include <netlink/cache.h>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr char TRACE_MAGIC[] = "NMTRACE1";
+constexpr size_t TRACE_MAGIC_SIZE = sizeof(TRACE_MAGIC) - 1;
+
+const char *kindName(Trace::Kind kind) {
+    return kind == Trace::Kind::DBus ? "D-Bus" : "netlink";
+}
+
+// NL_CB_MSG_IN 在每条消息进入 libnl 的解析流程之前调用，控制消息（DONE/ERROR）不需要保存
+int captureMessage(struct nl_msg *msg, void *arg) {
+    struct nlmsghdr *nlh = nlmsg_hdr(msg);
+    if (nlh->nlmsg_type >= NLMSG_MIN_TYPE) {
+        static_cast<std::vector<std::string> *>(arg)->emplace_back(reinterpret_cast<const char *>(nlh), nlh->nlmsg_len);
+    }
+    return NL_OK;
+}
+
+int parseIntoCache(struct nl_msg *msg, void *arg) {
+    nl_cache_parse_and_add(static_cast<struct nl_cache *>(arg), msg);
+    return NL_OK;
+}
+
+} // namespace
+
+Trace &Trace::global() {
+    static Trace trace;
+    return trace;
+}
+
+Trace::~Trace() {
+    if (file_) {
+        std::fclose(file_);
+    }
+}
+
+void Trace::startRecording(const std::string &path) {
+    file_ = std::fopen(path.c_str(), "wb");
+    if (!file_) {
+        throw NmcliException("Failed to open trace file " + path + ": " + std::string(strerror(errno)));
+    }
+    std::fwrite(TRACE_MAGIC, 1, TRACE_MAGIC_SIZE, file_);
+    origin_ = Clock::now();
+}
+
+void Trace::loadReplay(const std::string &path, bool paced) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        throw NmcliException("Failed to open trace file " + path);
+    }
+    std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+    if (data.compare(0, TRACE_MAGIC_SIZE, TRACE_MAGIC) != 0) {
+        throw NmcliException("Not an nmcli-alt trace file: " + path);
+    }
+
+    // 重新加载时替换之前的回放内容
+    replies_.clear();
+    TraceDecoder decoder(std::string_view(data).substr(TRACE_MAGIC_SIZE));
+    while (!decoder.empty()) {
+        Kind kind = static_cast<Kind>(decoder.u8());
+        std::string operation(decoder.bytes());
+        std::string key(decoder.bytes());
+        decoder.u64(); // 开始时间
+        const auto elapsed = std::chrono::duration_cast<Clock::duration>(std::chrono::nanoseconds(decoder.u64()));
+        replies_[std::make_tuple(kind, std::move(operation), std::move(key))].pending.push_back(
+            Reply{std::string(decoder.bytes()), elapsed}
+        );
+    }
+    replaying_ = true;
+    paced_ = paced;
+}
+
+void Trace::record(
+    Kind kind, const std::string &operation, const std::string &key, Clock::time_point start, Clock::duration elapsed,
+    const std::string &payload
+) {
+    if (!file_) {
+        return;
+    }
+
+    std::string buf;
+    TraceEncoder encoder(buf);
+    encoder.u8(static_cast<uint8_t>(kind));
+    encoder.bytes(operation);
+    encoder.bytes(key);
+    encoder.u64(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(start - origin_).count()));
+    encoder.u64(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+    encoder.bytes(payload);
+    std::fwrite(buf.data(), 1, buf.size(), file_);
+}
+
+const std::string *
+Trace::find(Kind kind, const std::string &operation, const std::string &key, Clock::duration *delay) {
+    auto it = replies_.find(std::make_tuple(kind, operation, key));
+    if (it == replies_.end()) {
+        return nullptr;
+    }
+
+    Replies &replies = it->second;
+    if (!replies.pending.empty()) {
+        replies.last = std::move(replies.pending.front());
+        replies.pending.pop_front();
+    }
+    if (delay) {
+        *delay = paced_ ? replies.last.elapsed : Clock::duration::zero();
+    }
+    return &replies.last.payload;
+}
+
+bool Trace::pending(Kind kind, const std::string &operation, const std::string &key) const {
+    auto it = replies_.find(std::make_tuple(kind, operation, key));
+    return it != replies_.end() && !it->second.pending.empty();
+}
+
+const std::string &
+Trace::replay(Kind kind, const std::string &operation, const std::string &key, Clock::duration *delay) {
+    Clock::duration elapsed{};
+    const std::string *payload = find(kind, operation, key, &elapsed);
+    if (!payload) {
+        throw NmcliException(std::string("No recorded ") + kindName(kind) + " reply for " + operation);
+    }
+    if (delay) {
+        *delay = elapsed;
+    } else if (elapsed > Clock::duration::zero()) {
+        // 同步调用方：录制时它同样阻塞了这么久
+        std::this_thread::sleep_for(elapsed);
+    }
+    return *payload;
+}
+
+int Trace::netlinkExchange(
+    struct nl_sock *sock, const std::string &operation, const std::string &key, const std::function<int()> &live,
+    int (*handler)(struct nl_msg *, void *), void *arg
+) {
+    if (replaying_) {
+        TraceDecoder decoder(replay(Kind::Netlink, operation, key));
+        int result = static_cast<int32_t>(decoder.u32());
+        uint32_t count = decoder.u32();
+        for (uint32_t i = 0; i < count; ++i) {
+            // nlmsg_convert 复制消息，录制的数据不需要满足对齐要求
+            std::string raw(decoder.bytes());
+            struct nl_msg *msg = nlmsg_convert(reinterpret_cast<struct nlmsghdr *>(raw.data()));
+            if (!msg) {
+                throw NmcliException("Failed to allocate netlink message");
+            }
+            if (handler) {
+                handler(msg, arg);
+            }
+            nlmsg_free(msg);
+        }
+        return result;
+    }
+
+    std::vector<std::string> messages;
+    if (file_) {
+        nl_socket_modify_cb(sock, NL_CB_MSG_IN, NL_CB_CUSTOM, captureMessage, &messages);
+    }
+
+    const Clock::time_point start = Clock::now();
+    int result;
+    {
+        LatencySpan span("netlink", operation);
+        ProbeSpan probe(ProbeKind::Netlink, operation.c_str());
+        result = live();
+        probe.setResult(result);
+    }
+
+    if (file_) {
+        nl_socket_modify_cb(sock, NL_CB_MSG_IN, NL_CB_DEFAULT, nullptr, nullptr);
+
+        std::string payload;
+        TraceEncoder encoder(payload);
+        encoder.u32(static_cast<uint32_t>(result));
+        encoder.u32(static_cast<uint32_t>(messages.size()));
+        for (const auto &message : messages) {
+            encoder.bytes(message);
+        }
+        record(Kind::Netlink, operation, key, start, Clock::now() - start, payload);
+    }
+
+    return result;
+}
+
+int Trace::netlinkCache(
+    struct nl_sock *sock, const char *cache_name, const std::string &operation,
+    const std::function<int(struct nl_cache **)> &alloc, struct nl_cache **result
+) {
+    if (!replaying_) {
+        return netlinkExchange(sock, operation, cache_name, [&] { return alloc(result); }, nullptr, nullptr);
+    }
+
+    int err = nl_cache_alloc_name(cache_name, result);
+    if (err < 0) {
+        return err;
+    }
+    err = netlinkExchange(sock, operation, cache_name, {}, parseIntoCache, *result);
+    if (err < 0) {
+        nl_cache_free(*result);
+        *result = nullptr;
+    }
+    return err;
+}